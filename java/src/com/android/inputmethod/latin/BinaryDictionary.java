@@ -22,6 +22,9 @@ import android.util.SparseArray;
 import com.android.inputmethod.keyboard.ProximityInfo;
 import com.android.inputmethod.latin.SuggestedWords.SuggestedWordInfo;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Locale;
@@ -37,16 +40,54 @@ public final class BinaryDictionary extends Dictionary {
     // Must be equal to MAX_RESULTS in native/jni/src/defines.h
     private static final int MAX_RESULTS = 18;
 
+    // Must be equal to MAX_SEARCHED_DICTIONARY_COUNT in native/jni/src/defines.h
+    public static final int MAX_SEARCHED_DICTIONARY_COUNT = 4;
+
+    // Layout of the direct buffers of getSuggestionsDirectNative(), in ints of the native order.
+    // Must be the same as in native/jni/com_android_inputmethod_latin_BinaryDictionary.cpp
+    // The input buffer holds the code points, the previous word, then the x coordinates, the
+    // y coordinates, the times and the pointer ids of as many points as fit in it.
+    private static final int DIRECT_INPUT_CODE_POINTS_OFFSET = 0;
+    private static final int DIRECT_INPUT_PREV_WORD_OFFSET = MAX_WORD_LENGTH;
+    private static final int DIRECT_INPUT_POINTS_OFFSET = 2 * MAX_WORD_LENGTH;
+    // The output buffer holds the number of suggestions, then their code points, scores, space
+    // indices and types. The native code clears the code points, scores and types of the
+    // suggestions of the previous call, and all the space indices, before writing the new ones.
+    private static final int DIRECT_OUTPUT_COUNT_OFFSET = 0;
+    private static final int DIRECT_OUTPUT_CODE_POINTS_OFFSET = 1;
+    private static final int DIRECT_OUTPUT_SCORES_OFFSET =
+            DIRECT_OUTPUT_CODE_POINTS_OFFSET + MAX_WORD_LENGTH * MAX_RESULTS;
+    private static final int DIRECT_OUTPUT_SPACE_INDICES_OFFSET =
+            DIRECT_OUTPUT_SCORES_OFFSET + MAX_RESULTS;
+    private static final int DIRECT_OUTPUT_TYPES_OFFSET =
+            DIRECT_OUTPUT_SPACE_INDICES_OFFSET + MAX_RESULTS;
+    private static final int DIRECT_OUTPUT_SIZE = DIRECT_OUTPUT_TYPES_OFFSET + MAX_RESULTS;
+    private static final int BYTES_PER_INT = 4;
+
     private long mNativeDict;
     private final Locale mLocale;
     private final int[] mInputCodePoints = new int[MAX_WORD_LENGTH];
-    private final int[] mOutputCodePoints = new int[MAX_WORD_LENGTH * MAX_RESULTS];
-    private final int[] mSpaceIndices = new int[MAX_RESULTS];
-    private final int[] mOutputScores = new int[MAX_RESULTS];
-    private final int[] mOutputTypes = new int[MAX_RESULTS];
+    private final int[] mOutputCodePoints = new int[MAX_WORD_LENGTH];
+    // Shared with the native code, which reads and writes them in place.
+    private ByteBuffer mDirectInputBuffer;
+    private IntBuffer mDirectInput;
+    private int mDirectInputPointCapacity;
+    private final ByteBuffer mDirectOutputBuffer = ByteBuffer.allocateDirect(
+            DIRECT_OUTPUT_SIZE * BYTES_PER_INT).order(ByteOrder.nativeOrder());
+    private final IntBuffer mDirectOutput = mDirectOutputBuffer.asIntBuffer();
+    // Outputs of getSuggestionsFromDictionariesNative().
+    private final int[] mMultiOutputCodePoints = new int[MAX_WORD_LENGTH * MAX_RESULTS];
+    private final int[] mMultiOutputScores = new int[MAX_RESULTS];
+    private final int[] mMultiSpaceIndices = new int[MAX_RESULTS];
+    private final int[] mMultiOutputTypes = new int[MAX_RESULTS];
+    private final int[] mMultiOutputDictionaryIndices = new int[MAX_RESULTS];
 
     private final boolean mUseFullEditDistance;
 
+    // Native sessions of getSuggestionsBatch(), created for mBatchThreadCount threads.
+    private long mNativeBatchSuggest;
+    private int mBatchThreadCount;
+
     private final SparseArray<DicTraverseSession> mDicTraverseSessions =
             CollectionUtils.newSparseArray();
 
@@ -77,17 +118,41 @@ public final class BinaryDictionary extends Dictionary {
      */
     public BinaryDictionary(final String filename, final long offset, final long length,
             final boolean useFullEditDistance, final Locale locale, final String dictType) {
+        this(filename, offset, length, useFullEditDistance, locale, dictType,
+                false /* useCacheOptimizedLayout */, true /* useLookupIndices */);
+    }
+
+    /**
+     * Constructor for the binary dictionary, choosing how the native code lays it out in memory.
+     * @param filename the name of the file to read through native code.
+     * @param offset the offset of the dictionary data within the file.
+     * @param length the length of the binary data.
+     * @param useFullEditDistance whether to use the full edit distance in suggestions
+     * @param dictType the dictionary type, as a human-readable string
+     * @param useCacheOptimizedLayout whether to read a static dictionary from an in-memory copy
+     *        whose nodes are rearranged for locality, instead of from the mapped file. This costs
+     *        a copy of the dictionary in memory.
+     * @param useLookupIndices whether to build the native lookup indices of a static dictionary,
+     *        which speed up word lookups and rank suggestions better. They cost a walk of the
+     *        dictionary when it is opened and some memory, about 2MB for English. If
+     *        useCacheOptimizedLayout is set, the parent links among them are built anyway, as the
+     *        rearranged dictionary needs them to read bigrams.
+     */
+    public BinaryDictionary(final String filename, final long offset, final long length,
+            final boolean useFullEditDistance, final Locale locale, final String dictType,
+            final boolean useCacheOptimizedLayout, final boolean useLookupIndices) {
         super(dictType);
         mLocale = locale;
         mUseFullEditDistance = useFullEditDistance;
-        loadDictionary(filename, offset, length);
+        loadDictionary(filename, offset, length, useCacheOptimizedLayout, useLookupIndices);
     }
 
     static {
         JniUtils.loadNativeLibrary();
     }
 
-    private static native long openNative(String sourceDir, long dictOffset, long dictSize);
+    private static native long openNative(String sourceDir, long dictOffset, long dictSize,
+            boolean useCacheOptimizedLayout, boolean useLookupIndices);
     private static native void closeNative(long dict);
     private static native int getProbabilityNative(long dict, int[] word);
     private static native boolean isValidBigramNative(long dict, int[] word1, int[] word2);
@@ -96,13 +161,32 @@ public final class BinaryDictionary extends Dictionary {
             int[] pointerIds, int[] inputCodePoints, int inputSize, int commitPoint,
             boolean isGesture, int[] prevWordCodePointArray, boolean useFullEditDistance,
             int[] outputCodePoints, int[] outputScores, int[] outputIndices, int[] outputTypes);
+    private static native int getSuggestionsDirectNative(long dict, long proximityInfo,
+            long traverseSession, ByteBuffer input, ByteBuffer output, int inputSize,
+            int commitPoint, boolean isGesture, int prevWordLength, boolean useFullEditDistance);
+    private static native int getSuggestionsFromDictionariesNative(long dict,
+            long[] additionalDicts, float[] weights, long proximityInfo, long traverseSession,
+            int[] xCoordinates, int[] yCoordinates, int[] times, int[] pointerIds,
+            int[] inputCodePoints, int inputSize, int commitPoint, boolean isGesture,
+            int[] prevWordCodePointArray, int[] outputCodePoints, int[] outputScores,
+            int[] outputIndices, int[] outputTypes, int[] outputDictionaryIndices);
+    private static native long createBatchSuggestNative(String locale, int threadCount);
+    private static native void releaseBatchSuggestNative(long batchSuggest);
+    private static native int getSuggestionsBatchNative(long dict, long proximityInfo,
+            long batchSuggest, int inputCount, int[] inputStarts, int[] xCoordinates,
+            int[] yCoordinates, int[] times, int[] pointerIds, int[] inputCodePoints,
+            int[] prevWordStarts, int[] prevWordCodePoints, boolean isGesture,
+            boolean useFullEditDistance, int[] outResultStarts, int[] outWordStarts,
+            int[] outCodePoints, int[] outScores, int[] outSpaceIndices, int[] outTypes);
     private static native float calcNormalizedScoreNative(int[] before, int[] after, int score);
     private static native int editDistanceNative(int[] before, int[] after);
 
     // TODO: Move native dict into session
     private final void loadDictionary(final String path, final long startOffset,
-            final long length) {
-        mNativeDict = openNative(path, startOffset, length);
+            final long length, final boolean useCacheOptimizedLayout,
+            final boolean useLookupIndices) {
+        mNativeDict = openNative(path, startOffset, length, useCacheOptimizedLayout,
+                useLookupIndices);
     }
 
     @Override
@@ -135,41 +219,195 @@ public final class BinaryDictionary extends Dictionary {
 
         final InputPointers ips = composer.getInputPointers();
         final int inputSize = isGesture ? ips.getPointerSize() : composerSize;
+        // No dictionary word is longer: a longer previous word can't have bigrams.
+        final int prevWordLength = (null == prevWordCodePointArray
+                || prevWordCodePointArray.length > MAX_WORD_LENGTH)
+                ? 0 : prevWordCodePointArray.length;
+        ensureDirectInputPointCapacity(inputSize);
+        final IntBuffer input = mDirectInput;
+        input.position(DIRECT_INPUT_CODE_POINTS_OFFSET);
+        input.put(mInputCodePoints, 0, MAX_WORD_LENGTH);
+        if (prevWordLength > 0) {
+            input.position(DIRECT_INPUT_PREV_WORD_OFFSET);
+            input.put(prevWordCodePointArray, 0, prevWordLength);
+        }
+        input.position(DIRECT_INPUT_POINTS_OFFSET);
+        input.put(ips.getXCoordinates(), 0, inputSize);
+        input.position(DIRECT_INPUT_POINTS_OFFSET + mDirectInputPointCapacity);
+        input.put(ips.getYCoordinates(), 0, inputSize);
+        input.position(DIRECT_INPUT_POINTS_OFFSET + 2 * mDirectInputPointCapacity);
+        input.put(ips.getTimes(), 0, inputSize);
+        input.position(DIRECT_INPUT_POINTS_OFFSET + 3 * mDirectInputPointCapacity);
+        input.put(ips.getPointerIds(), 0, inputSize);
         // proximityInfo and/or prevWordForBigrams may not be null.
-        final int count = getSuggestionsNative(mNativeDict, proximityInfo.getNativeProximityInfo(),
+        final int count = getSuggestionsDirectNative(mNativeDict,
+                proximityInfo.getNativeProximityInfo(), getTraverseSession(sessionId).getSession(),
+                mDirectInputBuffer, mDirectOutputBuffer, inputSize, 0 /* commitPoint */, isGesture,
+                prevWordLength, mUseFullEditDistance);
+        final IntBuffer output = mDirectOutput;
+        final ArrayList<SuggestedWordInfo> suggestions = CollectionUtils.newArrayList();
+        for (int j = 0; j < count; ++j) {
+            final int start = DIRECT_OUTPUT_CODE_POINTS_OFFSET + j * MAX_WORD_LENGTH;
+            int len = 0;
+            while (len < MAX_WORD_LENGTH && output.get(start + len) != 0) {
+                mOutputCodePoints[len] = output.get(start + len);
+                ++len;
+            }
+            if (len > 0) {
+                final int outputType = output.get(DIRECT_OUTPUT_TYPES_OFFSET + j);
+                final int flags = outputType & SuggestedWordInfo.KIND_MASK_FLAGS;
+                if (blockOffensiveWords
+                        && 0 != (flags & SuggestedWordInfo.KIND_FLAG_POSSIBLY_OFFENSIVE)
+                        && 0 == (flags & SuggestedWordInfo.KIND_FLAG_EXACT_MATCH)) {
+                    // If we block potentially offensive words, and if the word is possibly
+                    // offensive, then we don't output it unless it's also an exact match.
+                    continue;
+                }
+                final int kind = outputType & SuggestedWordInfo.KIND_MASK_KIND;
+                final int score = SuggestedWordInfo.KIND_WHITELIST == kind
+                        ? SuggestedWordInfo.MAX_SCORE
+                        : output.get(DIRECT_OUTPUT_SCORES_OFFSET + j);
+                suggestions.add(new SuggestedWordInfo(new String(mOutputCodePoints, 0, len),
+                        score, kind, flags, mDictType));
+            }
+        }
+        return suggestions;
+    }
+
+    /**
+     * Searches the suggestions of this dictionary and of additionalDictionaries in one search,
+     * where the words of all of them compete in the same queues. The language cost of a word of
+     * dictionary i is raised by weights[i], this dictionary being dictionary 0, so a weight of 0
+     * searches the dictionaries as equals and a higher one favors the words of the others. Each
+     * suggestion is tagged with the type of the dictionary it comes from. The predictions, when
+     * there is no input, only come from this dictionary.
+     *
+     * @param additionalDictionaries at most MAX_SEARCHED_DICTIONARY_COUNT - 1 dictionaries.
+     * @param weights one weight per dictionary, this one first.
+     */
+    public ArrayList<SuggestedWordInfo> getSuggestionsFromDictionaries(
+            final BinaryDictionary[] additionalDictionaries, final float[] weights,
+            final WordComposer composer, final String prevWord, final ProximityInfo proximityInfo,
+            final boolean blockOffensiveWords, final int sessionId) {
+        if (!isValidDictionary()) return null;
+        if (additionalDictionaries.length >= MAX_SEARCHED_DICTIONARY_COUNT
+                || weights.length != additionalDictionaries.length + 1) {
+            return null;
+        }
+        final long[] additionalDicts = new long[additionalDictionaries.length];
+        for (int i = 0; i < additionalDictionaries.length; ++i) {
+            if (!additionalDictionaries[i].isValidDictionary()) return null;
+            additionalDicts[i] = additionalDictionaries[i].mNativeDict;
+        }
+
+        Arrays.fill(mInputCodePoints, Constants.NOT_A_CODE);
+        final int[] prevWordCodePointArray = (null == prevWord)
+                ? null : StringUtils.toCodePointArray(prevWord);
+        final int composerSize = composer.size();
+
+        final boolean isGesture = composer.isBatchMode();
+        if (composerSize <= 1 || !isGesture) {
+            if (composerSize > MAX_WORD_LENGTH - 1) return null;
+            for (int i = 0; i < composerSize; i++) {
+                mInputCodePoints[i] = composer.getCodeAt(i);
+            }
+        }
+
+        final InputPointers ips = composer.getInputPointers();
+        final int inputSize = isGesture ? ips.getPointerSize() : composerSize;
+        Arrays.fill(mMultiOutputCodePoints, 0);
+        final int count = getSuggestionsFromDictionariesNative(mNativeDict, additionalDicts,
+                weights, proximityInfo.getNativeProximityInfo(),
                 getTraverseSession(sessionId).getSession(), ips.getXCoordinates(),
                 ips.getYCoordinates(), ips.getTimes(), ips.getPointerIds(), mInputCodePoints,
                 inputSize, 0 /* commitPoint */, isGesture, prevWordCodePointArray,
-                mUseFullEditDistance, mOutputCodePoints, mOutputScores, mSpaceIndices,
-                mOutputTypes);
+                mMultiOutputCodePoints, mMultiOutputScores, mMultiSpaceIndices, mMultiOutputTypes,
+                mMultiOutputDictionaryIndices);
         final ArrayList<SuggestedWordInfo> suggestions = CollectionUtils.newArrayList();
         for (int j = 0; j < count; ++j) {
             final int start = j * MAX_WORD_LENGTH;
             int len = 0;
-            while (len < MAX_WORD_LENGTH && mOutputCodePoints[start + len] != 0) {
+            while (len < MAX_WORD_LENGTH && mMultiOutputCodePoints[start + len] != 0) {
                 ++len;
             }
             if (len > 0) {
-                final int flags = mOutputTypes[j] & SuggestedWordInfo.KIND_MASK_FLAGS;
+                final int flags = mMultiOutputTypes[j] & SuggestedWordInfo.KIND_MASK_FLAGS;
                 if (blockOffensiveWords
                         && 0 != (flags & SuggestedWordInfo.KIND_FLAG_POSSIBLY_OFFENSIVE)
                         && 0 == (flags & SuggestedWordInfo.KIND_FLAG_EXACT_MATCH)) {
-                    // If we block potentially offensive words, and if the word is possibly
-                    // offensive, then we don't output it unless it's also an exact match.
                     continue;
                 }
-                final int kind = mOutputTypes[j] & SuggestedWordInfo.KIND_MASK_KIND;
+                final int kind = mMultiOutputTypes[j] & SuggestedWordInfo.KIND_MASK_KIND;
                 final int score = SuggestedWordInfo.KIND_WHITELIST == kind
-                        ? SuggestedWordInfo.MAX_SCORE : mOutputScores[j];
-                // TODO: check that all users of the `kind' parameter are ready to accept
-                // flags too and pass mOutputTypes[j] instead of kind
-                suggestions.add(new SuggestedWordInfo(new String(mOutputCodePoints, start, len),
-                        score, kind, mDictType));
+                        ? SuggestedWordInfo.MAX_SCORE : mMultiOutputScores[j];
+                final int dictionaryIndex = mMultiOutputDictionaryIndices[j];
+                final String sourceDictType = dictionaryIndex > 0
+                        ? additionalDictionaries[dictionaryIndex - 1].mDictType : mDictType;
+                suggestions.add(new SuggestedWordInfo(
+                        new String(mMultiOutputCodePoints, start, len), score, kind, flags,
+                        sourceDictType));
             }
         }
         return suggestions;
     }
 
+    private void ensureDirectInputPointCapacity(final int pointCount) {
+        if (null != mDirectInput && pointCount <= mDirectInputPointCapacity) return;
+        // Gestures grow by many points at a time.
+        mDirectInputPointCapacity =
+                Math.max(pointCount, Math.max(MAX_WORD_LENGTH, 2 * mDirectInputPointCapacity));
+        mDirectInputBuffer = ByteBuffer.allocateDirect(
+                (DIRECT_INPUT_POINTS_OFFSET + 4 * mDirectInputPointCapacity) * BYTES_PER_INT)
+                .order(ByteOrder.nativeOrder());
+        mDirectInput = mDirectInputBuffer.asIntBuffer();
+    }
+
+    /**
+     * Searches the suggestions of many inputs in one native call, for offline evaluation. The
+     * inputs are split in contiguous slices searched on threadCount threads, each with a session
+     * of its own, so the consecutive prefixes of a word are best given in order. The suggestions
+     * are the same as the ones of {@link #getSuggestions} for each input on its own, without the
+     * filtering of offensive words.
+     *
+     * Input i is made of the points [inputStarts[i], inputStarts[i + 1]) of xCoordinates,
+     * yCoordinates, times, pointerIds and inputCodePoints, and its previous word is the code points
+     * [prevWordStarts[i], prevWordStarts[i + 1]) of prevWordCodePoints, none if that is empty.
+     * The suggestions of input i are [outResultStarts[i], outResultStarts[i + 1]) of outScores,
+     * outSpaceIndices and outTypes, and suggestion j is the code points
+     * [outWordStarts[j], outWordStarts[j + 1]) of outCodePoints. There are at most MAX_RESULTS
+     * suggestions of MAX_WORD_LENGTH code points per input.
+     *
+     * @return the number of suggestions, or -1 if the inputs are invalid or the outputs are too
+     * small for the suggestions.
+     */
+    public synchronized int getSuggestionsBatch(final ProximityInfo proximityInfo,
+            final int threadCount, final int inputCount, final int[] inputStarts,
+            final int[] xCoordinates, final int[] yCoordinates, final int[] times,
+            final int[] pointerIds, final int[] inputCodePoints, final int[] prevWordStarts,
+            final int[] prevWordCodePoints, final boolean isGesture, final int[] outResultStarts,
+            final int[] outWordStarts, final int[] outCodePoints, final int[] outScores,
+            final int[] outSpaceIndices, final int[] outTypes) {
+        if (!isValidDictionary()) return -1;
+        if (mNativeBatchSuggest == 0 || mBatchThreadCount != threadCount) {
+            releaseBatchSuggest();
+            mNativeBatchSuggest = createBatchSuggestNative(
+                    mLocale != null ? mLocale.toString() : "", threadCount);
+            mBatchThreadCount = threadCount;
+        }
+        return getSuggestionsBatchNative(mNativeDict, proximityInfo.getNativeProximityInfo(),
+                mNativeBatchSuggest, inputCount, inputStarts, xCoordinates, yCoordinates, times,
+                pointerIds, inputCodePoints, prevWordStarts, prevWordCodePoints, isGesture,
+                mUseFullEditDistance, outResultStarts, outWordStarts, outCodePoints, outScores,
+                outSpaceIndices, outTypes);
+    }
+
+    private synchronized void releaseBatchSuggest() {
+        if (mNativeBatchSuggest != 0) {
+            releaseBatchSuggestNative(mNativeBatchSuggest);
+            mNativeBatchSuggest = 0;
+        }
+    }
+
     public boolean isValidDictionary() {
         return mNativeDict != 0;
     }
@@ -224,6 +462,7 @@ public final class BinaryDictionary extends Dictionary {
     }
 
     private synchronized void closeInternal() {
+        releaseBatchSuggest();
         if (mNativeDict != 0) {
             closeNative(mNativeDict);
             mNativeDict = 0;
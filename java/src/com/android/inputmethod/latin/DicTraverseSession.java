@@ -26,6 +26,10 @@ public final class DicTraverseSession {
     private static native long setDicTraverseSessionNative(String locale);
     private static native void initDicTraverseSessionNative(long nativeDicTraverseSession,
             long dictionary, int[] previousWord, int previousWordLength);
+    private static native void setDicTraverseSessionSearchLimitsNative(
+            long nativeDicTraverseSession, int maxSearchTimeMs, int maxExpandedNodeCount);
+    private static native void setDicTraverseSessionExpansionThreadCountNative(
+            long nativeDicTraverseSession, int threadCount);
     private static native void releaseDicTraverseSessionNative(long nativeDicTraverseSession);
 
     private long mNativeDicTraverseSession;
@@ -49,6 +53,26 @@ public final class DicTraverseSession {
                 mNativeDicTraverseSession, dictionary, previousWord, previousWordLength);
     }
 
+    /**
+     * Limits the time and the number of expanded nodes of each following search. A limit of 0
+     * means none. A search stopped by a limit returns the suggestions found so far, flagged with
+     * {@link SuggestedWords.SuggestedWordInfo#KIND_FLAG_PARTIAL_RESULT} in their
+     * {@link SuggestedWords.SuggestedWordInfo#mKindFlags}, see
+     * {@link SuggestedWords.SuggestedWordInfo#isPartialResult()}.
+     */
+    public void setSearchLimits(int maxSearchTimeMs, int maxExpandedNodeCount) {
+        setDicTraverseSessionSearchLimitsNative(
+                mNativeDicTraverseSession, maxSearchTimeMs, maxExpandedNodeCount);
+    }
+
+    /**
+     * Expands the search nodes on up to threadCount threads, when there are enough of them. The
+     * suggestions are the same as with the default of 1 thread.
+     */
+    public void setExpansionThreadCount(int threadCount) {
+        setDicTraverseSessionExpansionThreadCountNative(mNativeDicTraverseSession, threadCount);
+    }
+
     private final long createNativeDicTraverseSession(String locale) {
         return setDicTraverseSessionNative(locale);
     }
@@ -420,7 +420,7 @@ public final class Suggest {
             sb.appendCodePoint(Constants.CODE_SINGLE_QUOTE);
         }
         return new SuggestedWordInfo(sb.toString(), wordInfo.mScore, wordInfo.mKind,
-                wordInfo.mSourceDict);
+                wordInfo.mKindFlags, wordInfo.mSourceDict);
     }
 
     public void close() {
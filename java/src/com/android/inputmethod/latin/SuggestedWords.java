@@ -137,23 +137,38 @@ public final class SuggestedWords {
         public static final int KIND_MASK_FLAGS = 0xFFFFFF00; // Mask to get the flags
         public static final int KIND_FLAG_POSSIBLY_OFFENSIVE = 0x80000000;
         public static final int KIND_FLAG_EXACT_MATCH = 0x40000000;
+        public static final int KIND_FLAG_PARTIAL_RESULT = 0x20000000;
 
         public final String mWord;
         public final int mScore;
         public final int mKind; // one of the KIND_* constants above
+        public final int mKindFlags; // KIND_FLAG_* bits
         public final int mCodePointCount;
         public final String mSourceDict;
         private String mDebugString = "";
 
         public SuggestedWordInfo(final String word, final int score, final int kind,
                 final String sourceDict) {
+            this(word, score, kind, 0 /* kindFlags */, sourceDict);
+        }
+
+        public SuggestedWordInfo(final String word, final int score, final int kind,
+                final int kindFlags, final String sourceDict) {
             mWord = word;
             mScore = score;
             mKind = kind;
+            mKindFlags = kindFlags;
             mSourceDict = sourceDict;
             mCodePointCount = StringUtils.codePointCount(mWord);
         }
 
+        /**
+         * Whether the search that found this suggestion was stopped by the limits of its session
+         * before its end, so that better suggestions may have been missed.
+         */
+        public boolean isPartialResult() {
+            return 0 != (mKindFlags & KIND_FLAG_PARTIAL_RESULT);
+        }
 
         public void setDebugString(final String str) {
             if (null == str) throw new NullPointerException("Debug info is null");
@@ -20,24 +20,13 @@ LOCAL_PATH := $(call my-dir)
 FLAG_DBG ?= false
 FLAG_DO_PROFILE ?= false
 
-######################################
-include $(CLEAR_VARS)
-
 LATIN_IME_SRC_DIR := src
 
-LOCAL_C_INCLUDES += $(LOCAL_PATH)/$(LATIN_IME_SRC_DIR)
-
-LOCAL_CFLAGS += -Werror -Wall -Wextra -Weffc++ -Wformat=2 -Wcast-qual -Wcast-align \
+LATIN_IME_COMMON_CFLAGS := -Werror -Wall -Wextra -Weffc++ -Wformat=2 -Wcast-qual -Wcast-align \
     -Wwrite-strings -Wfloat-equal -Wpointer-arith -Winit-self -Wredundant-decls -Wno-system-headers
 
-ifeq ($(TARGET_ARCH), arm)
-ifeq ($(TARGET_GCC_VERSION), 4.6)
-LOCAL_CFLAGS += -Winline
-endif # TARGET_GCC_VERSION
-endif # TARGET_ARCH
-
 # To suppress compiler warnings for unused variables/functions used for debug features etc.
-LOCAL_CFLAGS += -Wno-unused-parameter -Wno-unused-function
+LATIN_IME_COMMON_CFLAGS += -Wno-unused-parameter -Wno-unused-function
 
 LATIN_IME_JNI_SRC_FILES := \
     com_android_inputmethod_keyboard_ProximityInfo.cpp \
@@ -64,8 +53,18 @@ LATIN_IME_CORE_SRC_FILES := \
         dic_node.cpp \
         dic_node_utils.cpp \
         dic_nodes_cache.cpp) \
+    $(addprefix suggest/core/dictionary/, \
+        cache_optimized_trie.cpp \
+        char_group_lookup_index.cpp \
+        parent_link_index.cpp \
+        subtree_probability_index.cpp \
+        trie_walk.cpp) \
     suggest/core/policy/weighting.cpp \
-    suggest/core/session/dic_traverse_session.cpp \
+    $(addprefix suggest/core/session/, \
+        batch_suggest.cpp \
+        dic_traverse_session.cpp \
+        dic_traverse_session_pool.cpp \
+        worker_thread_pool.cpp) \
     suggest/policyimpl/gesture/gesture_suggest_policy_factory.cpp \
     $(addprefix suggest/policyimpl/typing/, \
         scoring_params.cpp \
@@ -74,6 +73,19 @@ LATIN_IME_CORE_SRC_FILES := \
         typing_traversal.cpp \
         typing_weighting.cpp)
 
+######################################
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/$(LATIN_IME_SRC_DIR)
+
+LOCAL_CFLAGS += $(LATIN_IME_COMMON_CFLAGS)
+
+ifeq ($(TARGET_ARCH), arm)
+ifeq ($(TARGET_GCC_VERSION), 4.6)
+LOCAL_CFLAGS += -Winline
+endif # TARGET_GCC_VERSION
+endif # TARGET_ARCH
+
 LOCAL_SRC_FILES := \
     $(LATIN_IME_JNI_SRC_FILES) \
     $(addprefix $(LATIN_IME_SRC_DIR)/, $(LATIN_IME_CORE_SRC_FILES))
@@ -124,7 +136,43 @@ LOCAL_LDFLAGS += -ldl
 
 include $(BUILD_SHARED_LIBRARY)
 
+######################################
+# Host build of the core, with host/jni.h standing in for the JNI, to measure the engine on a
+# workstation. The JNI glue is left out.
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/host $(LOCAL_PATH)/$(LATIN_IME_SRC_DIR)
+
+LOCAL_CFLAGS += $(LATIN_IME_COMMON_CFLAGS)
+
+LOCAL_SRC_FILES := $(addprefix $(LATIN_IME_SRC_DIR)/, $(LATIN_IME_CORE_SRC_FILES))
+
+LOCAL_MODULE := libjni_latinime_common_host_static
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_STATIC_LIBRARY)
+######################################
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/host $(LOCAL_PATH)/$(LATIN_IME_SRC_DIR)
+
+LOCAL_CFLAGS += $(LATIN_IME_COMMON_CFLAGS)
+
+LOCAL_SRC_FILES := host/latinime_bench.cpp
+
+# The traverse sessions and the suggest policies register themselves from global constructors,
+# which a plain static library link would drop.
+LOCAL_WHOLE_STATIC_LIBRARIES := libjni_latinime_common_host_static
+
+LOCAL_LDLIBS += -lpthread -lrt
+
+LOCAL_MODULE := latinime_bench
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
+
 #################### Clean up the tmp vars
+LATIN_IME_COMMON_CFLAGS :=
 LATIN_IME_CORE_SRC_FILES :=
 LATIN_IME_JNI_SRC_FILES :=
 LATIN_IME_SRC_DIR :=
@@ -15,6 +15,7 @@
  */
 
 #include <cstring> // for memset()
+#include <vector>
 
 #define LOG_TAG "LatinIME: jni: BinaryDictionary"
 
@@ -35,6 +36,7 @@
 #include "dictionary.h"
 #include "jni.h"
 #include "jni_common.h"
+#include "suggest/core/session/batch_suggest.h"
 
 namespace latinime {
 
@@ -43,7 +45,8 @@ class ProximityInfo;
 static void releaseDictBuf(const void *dictBuf, const size_t length, const int fd);
 
 static jlong latinime_BinaryDictionary_open(JNIEnv *env, jclass clazz, jstring sourceDir,
-        jlong dictOffset, jlong dictSize) {
+        jlong dictOffset, jlong dictSize, jboolean useCacheOptimizedLayout,
+        jboolean useLookupIndices) {
     PROF_OPEN;
     PROF_START(66);
     const jsize sourceDirUtf8Length = env->GetStringUTFLength(sourceDir);
@@ -118,7 +121,8 @@ static jlong latinime_BinaryDictionary_open(JNIEnv *env, jclass clazz, jstring s
         releaseDictBuf(dictBuf, 0, 0);
 #endif // USE_MMAP_FOR_DICTIONARY
     } else {
-        dictionary = new Dictionary(dictBuf, static_cast<int>(dictSize), fd, adjust);
+        dictionary = new Dictionary(dictBuf, static_cast<int>(dictSize), fd, adjust,
+                useCacheOptimizedLayout, useLookupIndices);
     }
     PROF_END(66);
     PROF_CLOSE;
@@ -204,6 +208,311 @@ static int latinime_BinaryDictionary_getSuggestions(JNIEnv *env, jclass clazz, j
     return count;
 }
 
+static int latinime_BinaryDictionary_getSuggestionsFromDictionaries(JNIEnv *env, jclass clazz,
+        jlong dict, jlongArray additionalDictsArray, jfloatArray weightsArray, jlong proximityInfo,
+        jlong dicTraverseSession, jintArray xCoordinatesArray, jintArray yCoordinatesArray,
+        jintArray timesArray, jintArray pointerIdsArray, jintArray inputCodePointsArray,
+        jint inputSize, jint commitPoint, jboolean isGesture,
+        jintArray prevWordCodePointsForBigrams, jintArray outputCodePointsArray,
+        jintArray scoresArray, jintArray spaceIndicesArray, jintArray outputTypesArray,
+        jintArray outputDictionaryIndicesArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+    void *traverseSession = reinterpret_cast<void *>(dicTraverseSession);
+
+    // Dictionaries
+    const jsize additionalDictsLength = env->GetArrayLength(additionalDictsArray);
+    if (additionalDictsLength >= MAX_SEARCHED_DICTIONARY_COUNT
+            || env->GetArrayLength(weightsArray) != additionalDictsLength + 1) {
+        AKLOGE("Invalid additionalDictsLength: %d", additionalDictsLength);
+        ASSERT(false);
+        return 0;
+    }
+    jlong additionalDicts[additionalDictsLength];
+    env->GetLongArrayRegion(additionalDictsArray, 0, additionalDictsLength, additionalDicts);
+    const Dictionary *additionalDictionaries[additionalDictsLength];
+    for (int i = 0; i < additionalDictsLength; ++i) {
+        additionalDictionaries[i] = reinterpret_cast<Dictionary *>(additionalDicts[i]);
+        if (!additionalDictionaries[i]) return 0;
+    }
+    float weights[additionalDictsLength + 1];
+    env->GetFloatArrayRegion(weightsArray, 0, additionalDictsLength + 1, weights);
+
+    // Input values
+    int xCoordinates[inputSize];
+    int yCoordinates[inputSize];
+    int times[inputSize];
+    int pointerIds[inputSize];
+    const jsize inputCodePointsLength = env->GetArrayLength(inputCodePointsArray);
+    int inputCodePoints[inputCodePointsLength];
+    const jsize prevWordCodePointsLength =
+            prevWordCodePointsForBigrams ? env->GetArrayLength(prevWordCodePointsForBigrams) : 0;
+    int prevWordCodePointsInternal[prevWordCodePointsLength];
+    int *prevWordCodePoints = 0;
+    env->GetIntArrayRegion(xCoordinatesArray, 0, inputSize, xCoordinates);
+    env->GetIntArrayRegion(yCoordinatesArray, 0, inputSize, yCoordinates);
+    env->GetIntArrayRegion(timesArray, 0, inputSize, times);
+    env->GetIntArrayRegion(pointerIdsArray, 0, inputSize, pointerIds);
+    env->GetIntArrayRegion(inputCodePointsArray, 0, inputCodePointsLength, inputCodePoints);
+    if (prevWordCodePointsForBigrams) {
+        env->GetIntArrayRegion(prevWordCodePointsForBigrams, 0, prevWordCodePointsLength,
+                prevWordCodePointsInternal);
+        prevWordCodePoints = prevWordCodePointsInternal;
+    }
+
+    // Output values
+    const jsize outputCodePointsLength = env->GetArrayLength(outputCodePointsArray);
+    if (outputCodePointsLength != (MAX_WORD_LENGTH * MAX_RESULTS)) {
+        AKLOGE("Invalid outputCodePointsLength: %d", outputCodePointsLength);
+        ASSERT(false);
+        return 0;
+    }
+    const jsize scoresLength = env->GetArrayLength(scoresArray);
+    const jsize outputDictionaryIndicesLength = env->GetArrayLength(outputDictionaryIndicesArray);
+    if (scoresLength != MAX_RESULTS || outputDictionaryIndicesLength != MAX_RESULTS) {
+        AKLOGE("Invalid scoresLength: %d", scoresLength);
+        ASSERT(false);
+        return 0;
+    }
+    int outputCodePoints[outputCodePointsLength];
+    int scores[scoresLength];
+    const jsize spaceIndicesLength = env->GetArrayLength(spaceIndicesArray);
+    int spaceIndices[spaceIndicesLength];
+    const jsize outputTypesLength = env->GetArrayLength(outputTypesArray);
+    int outputTypes[outputTypesLength];
+    int outputDictionaryIndices[outputDictionaryIndicesLength];
+    memset(outputCodePoints, 0, sizeof(outputCodePoints));
+    memset(scores, 0, sizeof(scores));
+    memset(spaceIndices, 0, sizeof(spaceIndices));
+    memset(outputTypes, 0, sizeof(outputTypes));
+    memset(outputDictionaryIndices, 0, sizeof(outputDictionaryIndices));
+
+    int count;
+    if (isGesture || inputSize > 0) {
+        count = dictionary->getSuggestionsFromDictionaries(additionalDictionaries,
+                additionalDictsLength, weights, pInfo, traverseSession, xCoordinates,
+                yCoordinates, times, pointerIds, inputCodePoints, inputSize, prevWordCodePoints,
+                prevWordCodePointsLength, commitPoint, isGesture, outputCodePoints, scores,
+                spaceIndices, outputTypes, outputDictionaryIndices);
+    } else {
+        // The predictions only come from the main dictionary.
+        count = dictionary->getBigrams(prevWordCodePoints, prevWordCodePointsLength,
+                inputCodePoints, inputSize, outputCodePoints, scores, outputTypes);
+    }
+
+    // Copy back the output values
+    env->SetIntArrayRegion(outputCodePointsArray, 0, outputCodePointsLength, outputCodePoints);
+    env->SetIntArrayRegion(scoresArray, 0, scoresLength, scores);
+    env->SetIntArrayRegion(spaceIndicesArray, 0, spaceIndicesLength, spaceIndices);
+    env->SetIntArrayRegion(outputTypesArray, 0, outputTypesLength, outputTypes);
+    env->SetIntArrayRegion(outputDictionaryIndicesArray, 0, outputDictionaryIndicesLength,
+            outputDictionaryIndices);
+
+    return count;
+}
+
+// Layout of the direct buffers of getSuggestionsDirectNative(), in ints of the native order. It
+// must be the same as the one of BinaryDictionary.java.
+// Input: the code points, the previous word, then the x coordinates, the y coordinates, the
+// times and the pointer ids of as many points as fit in the buffer.
+static const int DIRECT_INPUT_CODE_POINTS_OFFSET = 0;
+static const int DIRECT_INPUT_PREV_WORD_OFFSET = MAX_WORD_LENGTH;
+static const int DIRECT_INPUT_POINTS_OFFSET = 2 * MAX_WORD_LENGTH;
+// Output: the number of suggestions, then their code points, scores, space indices and types,
+// laid out like the outputs of getSuggestionsNative(). The code points, scores and types of the
+// previous suggestions and all the space indices are cleared first, so the buffer must only be
+// read in between.
+static const int DIRECT_OUTPUT_COUNT_OFFSET = 0;
+static const int DIRECT_OUTPUT_CODE_POINTS_OFFSET = 1;
+static const int DIRECT_OUTPUT_SCORES_OFFSET =
+        DIRECT_OUTPUT_CODE_POINTS_OFFSET + MAX_WORD_LENGTH * MAX_RESULTS;
+static const int DIRECT_OUTPUT_SPACE_INDICES_OFFSET = DIRECT_OUTPUT_SCORES_OFFSET + MAX_RESULTS;
+static const int DIRECT_OUTPUT_TYPES_OFFSET = DIRECT_OUTPUT_SPACE_INDICES_OFFSET + MAX_RESULTS;
+static const int DIRECT_OUTPUT_SIZE = DIRECT_OUTPUT_TYPES_OFFSET + MAX_RESULTS;
+
+static jint latinime_BinaryDictionary_getSuggestionsDirect(JNIEnv *env, jclass clazz,
+        jlong dict, jlong proximityInfo, jlong dicTraverseSession, jobject inputBuffer,
+        jobject outputBuffer, jint inputSize, jint commitPoint, jboolean isGesture,
+        jint prevWordLength, jboolean useFullEditDistance) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    if (!dictionary) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+    void *traverseSession = reinterpret_cast<void *>(dicTraverseSession);
+    int *const input = static_cast<int *>(env->GetDirectBufferAddress(inputBuffer));
+    int *const output = static_cast<int *>(env->GetDirectBufferAddress(outputBuffer));
+    if (!input || !output) {
+        AKLOGE("Not direct buffers");
+        ASSERT(false);
+        return 0;
+    }
+    const jlong inputBufferSize =
+            env->GetDirectBufferCapacity(inputBuffer) / static_cast<jlong>(sizeof(int));
+    const jlong pointCapacity = (inputBufferSize - DIRECT_INPUT_POINTS_OFFSET) / 4;
+    if (inputSize < 0 || inputSize > pointCapacity || prevWordLength < 0
+            || prevWordLength > MAX_WORD_LENGTH || (!isGesture && inputSize > MAX_WORD_LENGTH)) {
+        AKLOGE("Invalid direct input: size %d, previous word length %d", inputSize,
+                prevWordLength);
+        ASSERT(false);
+        return 0;
+    }
+    if (env->GetDirectBufferCapacity(outputBuffer)
+            < static_cast<jlong>(DIRECT_OUTPUT_SIZE * sizeof(int))) {
+        AKLOGE("Invalid direct output buffer capacity");
+        ASSERT(false);
+        return 0;
+    }
+    int *const inputCodePoints = &input[DIRECT_INPUT_CODE_POINTS_OFFSET];
+    int *const prevWordCodePoints =
+            prevWordLength > 0 ? &input[DIRECT_INPUT_PREV_WORD_OFFSET] : 0;
+    int *const xCoordinates = &input[DIRECT_INPUT_POINTS_OFFSET];
+    int *const yCoordinates = xCoordinates + pointCapacity;
+    int *const times = yCoordinates + pointCapacity;
+    int *const pointerIds = times + pointCapacity;
+    int *const outputCodePoints = &output[DIRECT_OUTPUT_CODE_POINTS_OFFSET];
+    int *const scores = &output[DIRECT_OUTPUT_SCORES_OFFSET];
+    int *const spaceIndices = &output[DIRECT_OUTPUT_SPACE_INDICES_OFFSET];
+    int *const outputTypes = &output[DIRECT_OUTPUT_TYPES_OFFSET];
+
+    // Only the code points, scores and types of the previous suggestions have to be cleared: the
+    // rest of them is still zeroed. The space indices are all cleared, since the typing search
+    // writes MAX_RESULTS of them whatever its count.
+    const int lastCount = max(0, min(output[DIRECT_OUTPUT_COUNT_OFFSET], MAX_RESULTS));
+    memset(outputCodePoints, 0, lastCount * MAX_WORD_LENGTH * sizeof(outputCodePoints[0]));
+    memset(scores, 0, lastCount * sizeof(scores[0]));
+    memset(spaceIndices, 0, MAX_RESULTS * sizeof(spaceIndices[0]));
+    memset(outputTypes, 0, lastCount * sizeof(outputTypes[0]));
+
+    int count;
+    if (isGesture || inputSize > 0) {
+        count = dictionary->getSuggestions(pInfo, traverseSession, xCoordinates, yCoordinates,
+                times, pointerIds, inputCodePoints, inputSize, prevWordCodePoints,
+                prevWordLength, commitPoint, isGesture, useFullEditDistance, outputCodePoints,
+                scores, spaceIndices, outputTypes);
+    } else {
+        count = dictionary->getBigrams(prevWordCodePoints, prevWordLength, inputCodePoints,
+                inputSize, outputCodePoints, scores, outputTypes);
+    }
+    output[DIRECT_OUTPUT_COUNT_OFFSET] = count;
+    return count;
+}
+
+static jlong latinime_BinaryDictionary_createBatchSuggest(JNIEnv *env, jclass clazz,
+        jstring locale, jint threadCount) {
+    return reinterpret_cast<jlong>(new BatchSuggest(env, locale, threadCount));
+}
+
+static void latinime_BinaryDictionary_releaseBatchSuggest(JNIEnv *env, jclass clazz,
+        jlong batchSuggest) {
+    delete reinterpret_cast<BatchSuggest *>(batchSuggest);
+}
+
+// Checks that the count + 1 start offsets of startsArray are ordered and within length.
+static bool copyAndCheckStarts(JNIEnv *env, jintArray startsArray, const int count,
+        const int length, std::vector<int> *const starts) {
+    if (!startsArray || env->GetArrayLength(startsArray) < count + 1) {
+        return false;
+    }
+    starts->resize(count + 1);
+    env->GetIntArrayRegion(startsArray, 0, count + 1, &(*starts)[0]);
+    if ((*starts)[0] < 0 || (*starts)[count] > length) {
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        if ((*starts)[i] > (*starts)[i + 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The batches are large, so the arrays are copied to the heap rather than to the stack.
+static int *copyIntArray(JNIEnv *env, jintArray array, const int length,
+        std::vector<int> *const buffer) {
+    // One element more, so that an empty buffer still has an address.
+    buffer->resize(length + 1);
+    if (length > 0) {
+        env->GetIntArrayRegion(array, 0, length, &(*buffer)[0]);
+    }
+    return &(*buffer)[0];
+}
+
+static jint latinime_BinaryDictionary_getSuggestionsBatch(JNIEnv *env, jclass clazz, jlong dict,
+        jlong proximityInfo, jlong batchSuggest, jint inputCount, jintArray inputStartsArray,
+        jintArray xCoordinatesArray, jintArray yCoordinatesArray, jintArray timesArray,
+        jintArray pointerIdsArray, jintArray inputCodePointsArray, jintArray prevWordStartsArray,
+        jintArray prevWordCodePointsArray, jboolean isGesture, jboolean useFullEditDistance,
+        jintArray outResultStartsArray, jintArray outWordStartsArray,
+        jintArray outCodePointsArray, jintArray outScoresArray, jintArray outSpaceIndicesArray,
+        jintArray outTypesArray) {
+    Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
+    BatchSuggest *batch = reinterpret_cast<BatchSuggest *>(batchSuggest);
+    if (!dictionary || !batch || inputCount <= 0) return 0;
+    ProximityInfo *pInfo = reinterpret_cast<ProximityInfo *>(proximityInfo);
+
+    // Input values
+    const jsize pointCount = env->GetArrayLength(xCoordinatesArray);
+    if (env->GetArrayLength(yCoordinatesArray) < pointCount
+            || env->GetArrayLength(timesArray) < pointCount
+            || env->GetArrayLength(pointerIdsArray) < pointCount
+            || env->GetArrayLength(inputCodePointsArray) < pointCount) {
+        AKLOGE("Invalid batch point arrays");
+        ASSERT(false);
+        return -1;
+    }
+    const jsize prevWordCodePointCount =
+            prevWordCodePointsArray ? env->GetArrayLength(prevWordCodePointsArray) : 0;
+    std::vector<int> inputStarts;
+    std::vector<int> prevWordStarts;
+    if (!copyAndCheckStarts(env, inputStartsArray, inputCount, pointCount, &inputStarts)
+            || !copyAndCheckStarts(env, prevWordStartsArray, inputCount, prevWordCodePointCount,
+                    &prevWordStarts)) {
+        AKLOGE("Invalid batch start offsets");
+        ASSERT(false);
+        return -1;
+    }
+    std::vector<int> xCoordinates;
+    std::vector<int> yCoordinates;
+    std::vector<int> times;
+    std::vector<int> pointerIds;
+    std::vector<int> inputCodePoints;
+    std::vector<int> prevWordCodePoints;
+    const int count = batch->getSuggestions(dictionary, pInfo, inputCount, &inputStarts[0],
+            copyIntArray(env, xCoordinatesArray, pointCount, &xCoordinates),
+            copyIntArray(env, yCoordinatesArray, pointCount, &yCoordinates),
+            copyIntArray(env, timesArray, pointCount, &times),
+            copyIntArray(env, pointerIdsArray, pointCount, &pointerIds),
+            copyIntArray(env, inputCodePointsArray, pointCount, &inputCodePoints),
+            &prevWordStarts[0], copyIntArray(env, prevWordCodePointsArray,
+                    prevWordCodePointCount, &prevWordCodePoints),
+            isGesture, useFullEditDistance);
+
+    // Output values: only the suggestions are copied back.
+    const BatchSuggestResults *const results = batch->getResults();
+    const int codePointCount = results->getCodePointCount();
+    if (env->GetArrayLength(outResultStartsArray) < inputCount + 1
+            || env->GetArrayLength(outWordStartsArray) < count + 1
+            || env->GetArrayLength(outCodePointsArray) < codePointCount
+            || env->GetArrayLength(outScoresArray) < count
+            || env->GetArrayLength(outSpaceIndicesArray) < count
+            || env->GetArrayLength(outTypesArray) < count) {
+        AKLOGE("Batch output arrays too small for %d suggestions", count);
+        return -1;
+    }
+    env->SetIntArrayRegion(outResultStartsArray, 0, inputCount + 1, &results->mResultStarts[0]);
+    env->SetIntArrayRegion(outWordStartsArray, 0, count + 1, &results->mWordStarts[0]);
+    if (count > 0) {
+        if (codePointCount > 0) {
+            env->SetIntArrayRegion(outCodePointsArray, 0, codePointCount,
+                    &results->mCodePoints[0]);
+        }
+        env->SetIntArrayRegion(outScoresArray, 0, count, &results->mScores[0]);
+        env->SetIntArrayRegion(outSpaceIndicesArray, 0, count, &results->mSpaceIndices[0]);
+        env->SetIntArrayRegion(outTypesArray, 0, count, &results->mOutputTypes[0]);
+    }
+    return count;
+}
+
 static jint latinime_BinaryDictionary_getProbability(JNIEnv *env, jclass clazz, jlong dict,
         jintArray wordArray) {
     Dictionary *dictionary = reinterpret_cast<Dictionary *>(dict);
@@ -282,7 +591,7 @@ static void releaseDictBuf(const void *dictBuf, const size_t length, const int f
 
 static JNINativeMethod sMethods[] = {
     {const_cast<char *>("openNative"),
-     const_cast<char *>("(Ljava/lang/String;JJ)J"),
+     const_cast<char *>("(Ljava/lang/String;JJZZ)J"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_open)},
     {const_cast<char *>("closeNative"),
      const_cast<char *>("(J)V"),
@@ -290,6 +599,21 @@ static JNINativeMethod sMethods[] = {
     {const_cast<char *>("getSuggestionsNative"),
      const_cast<char *>("(JJJ[I[I[I[I[IIIZ[IZ[I[I[I[I)I"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestions)},
+    {const_cast<char *>("getSuggestionsFromDictionariesNative"),
+     const_cast<char *>("(J[J[FJJ[I[I[I[I[IIIZ[I[I[I[I[I[I)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsFromDictionaries)},
+    {const_cast<char *>("getSuggestionsDirectNative"),
+     const_cast<char *>("(JJJLjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;IIZIZ)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsDirect)},
+    {const_cast<char *>("createBatchSuggestNative"),
+     const_cast<char *>("(Ljava/lang/String;I)J"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_createBatchSuggest)},
+    {const_cast<char *>("releaseBatchSuggestNative"),
+     const_cast<char *>("(J)V"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_releaseBatchSuggest)},
+    {const_cast<char *>("getSuggestionsBatchNative"),
+     const_cast<char *>("(JJJI[I[I[I[I[I[I[I[IZZ[I[I[I[I[I[I)I"),
+     reinterpret_cast<void *>(latinime_BinaryDictionary_getSuggestionsBatch)},
     {const_cast<char *>("getProbabilityNative"),
      const_cast<char *>("(J[I)I"),
      reinterpret_cast<void *>(latinime_BinaryDictionary_getProbability)},
@@ -42,6 +42,19 @@ static void latinime_initDicTraverseSession(JNIEnv *env, jclass clazz, jlong tra
     DicTraverseWrapper::initDicTraverseSession(ts, dict, prevWord, previousWordLength);
 }
 
+static void latinime_setDicTraverseSessionSearchLimits(JNIEnv *env, jclass clazz,
+        jlong traverseSession, jint maxSearchTimeMs, jint maxExpandedDicNodeCount) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    DicTraverseWrapper::setDicTraverseSessionSearchLimits(ts, maxSearchTimeMs,
+            maxExpandedDicNodeCount);
+}
+
+static void latinime_setDicTraverseSessionExpansionThreadCount(JNIEnv *env, jclass clazz,
+        jlong traverseSession, jint threadCount) {
+    void *ts = reinterpret_cast<void *>(traverseSession);
+    DicTraverseWrapper::setDicTraverseSessionExpansionThreadCount(ts, threadCount);
+}
+
 static void latinime_releaseDicTraverseSession(JNIEnv *env, jclass clazz, jlong traverseSession) {
     void *ts = reinterpret_cast<void *>(traverseSession);
     DicTraverseWrapper::releaseDicTraverseSession(ts);
@@ -54,6 +67,12 @@ static JNINativeMethod sMethods[] = {
     {const_cast<char *>("initDicTraverseSessionNative"),
      const_cast<char *>("(JJ[II)V"),
      reinterpret_cast<void *>(latinime_initDicTraverseSession)},
+    {const_cast<char *>("setDicTraverseSessionSearchLimitsNative"),
+     const_cast<char *>("(JII)V"),
+     reinterpret_cast<void *>(latinime_setDicTraverseSessionSearchLimits)},
+    {const_cast<char *>("setDicTraverseSessionExpansionThreadCountNative"),
+     const_cast<char *>("(JI)V"),
+     reinterpret_cast<void *>(latinime_setDicTraverseSessionExpansionThreadCount)},
     {const_cast<char *>("releaseDicTraverseSessionNative"),
      const_cast<char *>("(J)V"),
      reinterpret_cast<void *>(latinime_releaseDicTraverseSession)}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_HOST_JNI_H
+#define LATINIME_HOST_JNI_H
+
+// Stand-in for jni.h in the host build of the native core, where there is no Java VM. It only
+// declares what src/ uses: Java arrays and strings are plain host buffers, and JNIEnv copies out
+// of them. The JNI glue of native/jni is not part of the host build.
+
+#include <stdint.h>
+#include <cstring> // for memcpy() and strlen()
+
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef uint8_t jboolean;
+typedef float jfloat;
+typedef jint jsize;
+
+// A Java string, as a null terminated ASCII string.
+struct _jstring {
+    const char *mChars;
+};
+
+// A Java array of int or float.
+struct _jarray {
+    void *mElements;
+    jsize mLength;
+};
+
+typedef _jstring *jstring;
+typedef _jarray *jarray;
+typedef jarray jintArray;
+typedef jarray jfloatArray;
+
+struct _JNIEnv {
+    jsize GetArrayLength(jarray array) {
+        return array->mLength;
+    }
+
+    void GetIntArrayRegion(jintArray array, jsize start, jsize len, jint *buf) {
+        memcpy(buf, static_cast<const jint *>(array->mElements) + start, len * sizeof(jint));
+    }
+
+    void GetFloatArrayRegion(jfloatArray array, jsize start, jsize len, jfloat *buf) {
+        memcpy(buf, static_cast<const jfloat *>(array->mElements) + start, len * sizeof(jfloat));
+    }
+
+    jsize GetStringLength(jstring string) {
+        return static_cast<jsize>(strlen(string->mChars));
+    }
+
+    jsize GetStringUTFLength(jstring string) {
+        return static_cast<jsize>(strlen(string->mChars));
+    }
+
+    void GetStringUTFRegion(jstring string, jsize start, jsize len, char *buf) {
+        memcpy(buf, string->mChars + start, len);
+    }
+};
+
+typedef _JNIEnv JNIEnv;
+#endif // LATINIME_HOST_JNI_H
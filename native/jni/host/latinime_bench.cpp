@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replays a corpus of typed words through Suggest::getSuggestions() on the host, and reports the
+// latency, the expanded dic nodes and the memory of the searches per input length.
+//
+// Usage: latinime_bench [-r <repeat count>] [-o] [-n] [-t <thread count>] [-b <thread count>]
+//         <dictionary file> <corpus file>
+//   -r: replays the corpus this many times (default 1).
+//   -o: opens the dictionary with the cache optimized layout.
+//   -n: opens the dictionary without the lookup indices. With -o, the parent links are still
+//       built, as the rearranged dictionary needs them.
+//   -t: expands the active dic nodes on this many threads (default 1).
+//   -b: searches all the prefixes of each replay as one batch of BatchSuggest on this many
+//       threads instead, and reports the throughput.
+//
+// The corpus is UTF-8 text. Each word is typed one key at a time, as on a device: a search is
+// run for every prefix, on the same traverse session, with the previous word of the line as the
+// bigram context. Touch points are the key centers of a QWERTY layout; code points that are not
+// on it are typed without coordinates.
+//
+// The only memory reported per input length is the arena column: the largest word arena of a
+// search of that length. The peak resident memory on the last line covers the whole run,
+// dictionary included, and is not broken down by length.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "binary_format.h"
+#include "char_utils.h"
+#include "defines.h"
+#include "dic_traverse_wrapper.h"
+#include "dictionary.h"
+#include "jni.h"
+#include "proximity_info.h"
+#include "suggest/core/session/batch_suggest.h"
+#include "suggest/core/session/dic_traverse_session.h"
+
+namespace latinime {
+
+static const char *const QWERTY_ROWS[] = { "qwertyuiop", "asdfghjkl", "zxcvbnm" };
+static const int QWERTY_ROW_COUNT = 3;
+static const int KEY_WIDTH = 108;
+static const int KEY_HEIGHT = 162;
+static const int KEYBOARD_WIDTH = 10 * KEY_WIDTH;
+static const int KEYBOARD_HEIGHT = QWERTY_ROW_COUNT * KEY_HEIGHT;
+static const int GRID_WIDTH = 32;
+static const int GRID_HEIGHT = 16;
+// Same as ProximityInfo.SEARCH_DISTANCE on the Java side
+static const float SEARCH_DISTANCE = 1.2f;
+static const int TIME_BETWEEN_KEYS_MS = 200;
+
+// The keys of the layout, in the form ProximityInfo reads them.
+struct Layout {
+    Layout() : mXs(), mYs(), mWidths(), mHeights(), mCodes(), mProximityChars() {}
+
+    std::vector<int> mXs;
+    std::vector<int> mYs;
+    std::vector<int> mWidths;
+    std::vector<int> mHeights;
+    std::vector<int> mCodes;
+    std::vector<int> mProximityChars;
+};
+
+// Measures of the searches for one input length
+struct LengthStats {
+    LengthStats()
+            : mLatenciesUs(), mExpandedDicNodeCount(0), mMaxExpandedDicNodeCount(0),
+              mMaxWordArenaSize(0) {}
+
+    std::vector<int> mLatenciesUs;
+    int64_t mExpandedDicNodeCount;
+    int mMaxExpandedDicNodeCount;
+    int mMaxWordArenaSize;
+};
+
+static int64_t getMonotonicTimeUs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+static int squaredDistanceToEdge(const Layout &layout, const int keyIndex, const int x,
+        const int y) {
+    const int left = layout.mXs[keyIndex];
+    const int top = layout.mYs[keyIndex];
+    const int edgeX = max(left, min(x, left + layout.mWidths[keyIndex]));
+    const int edgeY = max(top, min(y, top + layout.mHeights[keyIndex]));
+    return (x - edgeX) * (x - edgeX) + (y - edgeY) * (y - edgeY);
+}
+
+// Lays out the keys and computes the nearest keys of every grid cell like
+// ProximityInfo.computeNearestNeighbors() does.
+static void createQwertyLayout(Layout *const layout) {
+    for (int row = 0; row < QWERTY_ROW_COUNT; ++row) {
+        const int rowLength = static_cast<int>(strlen(QWERTY_ROWS[row]));
+        const int left = (KEYBOARD_WIDTH - rowLength * KEY_WIDTH) / 2;
+        for (int i = 0; i < rowLength; ++i) {
+            layout->mXs.push_back(left + i * KEY_WIDTH);
+            layout->mYs.push_back(row * KEY_HEIGHT);
+            layout->mWidths.push_back(KEY_WIDTH);
+            layout->mHeights.push_back(KEY_HEIGHT);
+            layout->mCodes.push_back(QWERTY_ROWS[row][i]);
+        }
+    }
+    const int keyCount = static_cast<int>(layout->mCodes.size());
+    const int cellWidth = (KEYBOARD_WIDTH + GRID_WIDTH - 1) / GRID_WIDTH;
+    const int cellHeight = (KEYBOARD_HEIGHT + GRID_HEIGHT - 1) / GRID_HEIGHT;
+    const int thresholdBase = static_cast<int>(KEY_WIDTH * SEARCH_DISTANCE);
+    const int threshold = thresholdBase * thresholdBase;
+    layout->mProximityChars.assign(GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE,
+            NOT_A_CODE_POINT);
+    for (int cellY = 0; cellY < GRID_HEIGHT; ++cellY) {
+        for (int cellX = 0; cellX < GRID_WIDTH; ++cellX) {
+            const int centerX = cellX * cellWidth + cellWidth / 2;
+            const int centerY = cellY * cellHeight + cellHeight / 2;
+            const int cellStart = (cellY * GRID_WIDTH + cellX) * MAX_PROXIMITY_CHARS_SIZE;
+            int count = 0;
+            for (int key = 0; key < keyCount && count < MAX_PROXIMITY_CHARS_SIZE; ++key) {
+                if (squaredDistanceToEdge(*layout, key, centerX, centerY) < threshold) {
+                    layout->mProximityChars[cellStart + count++] = layout->mCodes[key];
+                }
+            }
+        }
+    }
+}
+
+static ProximityInfo *createProximityInfo(Layout *const layout) {
+    const int keyCount = static_cast<int>(layout->mCodes.size());
+    JNIEnv env;
+    _jstring locale = { "en_US" };
+    _jarray proximityChars = { &layout->mProximityChars[0],
+            static_cast<jsize>(layout->mProximityChars.size()) };
+    _jarray xs = { &layout->mXs[0], keyCount };
+    _jarray ys = { &layout->mYs[0], keyCount };
+    _jarray widths = { &layout->mWidths[0], keyCount };
+    _jarray heights = { &layout->mHeights[0], keyCount };
+    _jarray codes = { &layout->mCodes[0], keyCount };
+    // No sweet spots: touch position correction is off.
+    return new ProximityInfo(&env, &locale, KEYBOARD_WIDTH, KEYBOARD_HEIGHT, GRID_WIDTH,
+            GRID_HEIGHT, KEY_WIDTH, KEY_HEIGHT, &proximityChars, keyCount, &xs, &ys, &widths,
+            &heights, &codes, 0 /* sweetSpotCenterXs */, 0 /* sweetSpotCenterYs */,
+            0 /* sweetSpotRadii */);
+}
+
+// Reads the next line of the corpus as words of code points. Returns false at the end of the file.
+static bool readLine(FILE *const file, std::vector<std::vector<int> > *const words) {
+    words->clear();
+    std::vector<int> word;
+    int c;
+    while ((c = fgetc(file)) != EOF && c != '\n') {
+        int codePoint = c;
+        int continuationCount = 0;
+        if (c >= 0xF0) {
+            codePoint = c & 0x07;
+            continuationCount = 3;
+        } else if (c >= 0xE0) {
+            codePoint = c & 0x0F;
+            continuationCount = 2;
+        } else if (c >= 0xC0) {
+            codePoint = c & 0x1F;
+            continuationCount = 1;
+        }
+        for (int i = 0; i < continuationCount; ++i) {
+            codePoint = (codePoint << 6) | (fgetc(file) & 0x3F);
+        }
+        if (codePoint == ' ' || codePoint == '\t' || codePoint == '\r') {
+            if (!word.empty()) {
+                words->push_back(word);
+                word.clear();
+            }
+        } else {
+            word.push_back(codePoint);
+        }
+    }
+    if (!word.empty()) {
+        words->push_back(word);
+    }
+    return c != EOF || !words->empty();
+}
+
+static int getPercentile(const std::vector<int> &sortedValues, const int percentile) {
+    const int index = (static_cast<int>(sortedValues.size()) * percentile + 99) / 100 - 1;
+    return sortedValues[max(0, index)];
+}
+
+static void printStats(std::vector<LengthStats> *const statsPerLength) {
+    printf("%6s %8s %8s %8s %8s %12s %12s %12s\n", "length", "searches", "p50(us)", "p95(us)",
+            "p99(us)", "avg nodes", "max nodes", "arena(KiB)");
+    for (int length = 1; length < static_cast<int>(statsPerLength->size()); ++length) {
+        LengthStats *const stats = &(*statsPerLength)[length];
+        const int searchCount = static_cast<int>(stats->mLatenciesUs.size());
+        if (searchCount == 0) {
+            continue;
+        }
+        std::sort(stats->mLatenciesUs.begin(), stats->mLatenciesUs.end());
+        printf("%6d %8d %8d %8d %8d %12lld %12d %12d\n", length, searchCount,
+                getPercentile(stats->mLatenciesUs, 50), getPercentile(stats->mLatenciesUs, 95),
+                getPercentile(stats->mLatenciesUs, 99),
+                static_cast<long long>(stats->mExpandedDicNodeCount / searchCount),
+                stats->mMaxExpandedDicNodeCount,
+                stats->mMaxWordArenaSize * static_cast<int>(sizeof(int)) / 1024);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is in KiB on Linux, and is the peak of the whole process, not of any one length.
+    printf("peak resident memory of the run: %ld KiB\n", usage.ru_maxrss);
+}
+
+// Types the first wordLength code points of word at the key centers.
+static void typeWord(const Layout &layout, const std::vector<int> &word, const int wordLength,
+        int *const xs, int *const ys, int *const times, int *const pointerIds,
+        int *const inputCodePoints) {
+    const int keyCount = static_cast<int>(layout.mCodes.size());
+    for (int i = 0; i < wordLength; ++i) {
+        const int codePoint = word[i];
+        const int lowerCodePoint = toLowerCase(codePoint);
+        xs[i] = NOT_A_COORDINATE;
+        ys[i] = NOT_A_COORDINATE;
+        for (int key = 0; key < keyCount; ++key) {
+            if (layout.mCodes[key] == lowerCodePoint) {
+                xs[i] = layout.mXs[key] + KEY_WIDTH / 2;
+                ys[i] = layout.mYs[key] + KEY_HEIGHT / 2;
+                break;
+            }
+        }
+        times[i] = i * TIME_BETWEEN_KEYS_MS;
+        pointerIds[i] = 0;
+        inputCodePoints[i] = codePoint;
+    }
+}
+
+// Searches the prefixes of all the words of each replay of the corpus as one batch.
+static void runBatches(const Dictionary *const dictionary, ProximityInfo *const proximityInfo,
+        const Layout &layout, const std::vector<std::vector<int> > &lines,
+        const int repeatCount, const int threadCount) {
+    // The inputs, packed as BatchSuggest::getSuggestions() reads them
+    std::vector<int> inputStarts(1, 0);
+    std::vector<int> xs;
+    std::vector<int> ys;
+    std::vector<int> times;
+    std::vector<int> pointerIds;
+    std::vector<int> inputCodePoints;
+    std::vector<int> prevWordStarts(1, 0);
+    std::vector<int> prevWordCodePoints;
+    int wordXs[MAX_WORD_LENGTH];
+    int wordYs[MAX_WORD_LENGTH];
+    int wordTimes[MAX_WORD_LENGTH];
+    int wordPointerIds[MAX_WORD_LENGTH];
+    int wordCodePoints[MAX_WORD_LENGTH];
+    const std::vector<int> *prevWord = 0;
+    for (size_t wordIndex = 0; wordIndex < lines.size(); ++wordIndex) {
+        const std::vector<int> &word = lines[wordIndex];
+        if (word.empty()) {
+            prevWord = 0;
+            continue;
+        }
+        const int wordLength = min(static_cast<int>(word.size()), MAX_WORD_LENGTH - 1);
+        typeWord(layout, word, wordLength, wordXs, wordYs, wordTimes, wordPointerIds,
+                wordCodePoints);
+        const int prevWordLength =
+                prevWord ? min(static_cast<int>(prevWord->size()), MAX_WORD_LENGTH) : 0;
+        for (int inputSize = 1; inputSize <= wordLength; ++inputSize) {
+            xs.insert(xs.end(), wordXs, wordXs + inputSize);
+            ys.insert(ys.end(), wordYs, wordYs + inputSize);
+            times.insert(times.end(), wordTimes, wordTimes + inputSize);
+            pointerIds.insert(pointerIds.end(), wordPointerIds, wordPointerIds + inputSize);
+            inputCodePoints.insert(inputCodePoints.end(), wordCodePoints,
+                    wordCodePoints + inputSize);
+            inputStarts.push_back(static_cast<int>(xs.size()));
+            if (prevWord) {
+                prevWordCodePoints.insert(prevWordCodePoints.end(), prevWord->begin(),
+                        prevWord->begin() + prevWordLength);
+            }
+            prevWordStarts.push_back(static_cast<int>(prevWordCodePoints.size()));
+        }
+        prevWord = &word;
+    }
+    const int inputCount = static_cast<int>(inputStarts.size()) - 1;
+    if (inputCount == 0) {
+        return;
+    }
+    // One more element, so that the arrays have an address even when empty.
+    xs.push_back(0);
+    ys.push_back(0);
+    times.push_back(0);
+    pointerIds.push_back(0);
+    inputCodePoints.push_back(0);
+    prevWordCodePoints.push_back(0);
+
+    JNIEnv env;
+    _jstring locale = { "en_US" };
+    BatchSuggest batchSuggest(&env, &locale, threadCount);
+    if (batchSuggest.getThreadCount() != threadCount) {
+        fprintf(stderr, "Searching on %d threads only\n", batchSuggest.getThreadCount());
+    }
+    printf("%6s %8s %12s %10s %12s\n", "batch", "inputs", "suggestions", "time(ms)",
+            "inputs/s");
+    for (int repeat = 0; repeat < repeatCount; ++repeat) {
+        const int64_t startTimeUs = getMonotonicTimeUs();
+        const int suggestionCount = batchSuggest.getSuggestions(dictionary, proximityInfo,
+                inputCount, &inputStarts[0], &xs[0], &ys[0], &times[0], &pointerIds[0],
+                &inputCodePoints[0], &prevWordStarts[0], &prevWordCodePoints[0],
+                false /* isGesture */, false /* useFullEditDistance */);
+        const int64_t timeUs = max(static_cast<int64_t>(1), getMonotonicTimeUs() - startTimeUs);
+        printf("%6d %8d %12d %10lld %12lld\n", repeat, inputCount, suggestionCount,
+                static_cast<long long>(timeUs / 1000),
+                static_cast<long long>(static_cast<int64_t>(inputCount) * 1000000 / timeUs));
+    }
+}
+
+static int runBenchmark(const char *const dictPath, const char *const corpusPath,
+        const int repeatCount, const bool useCacheOptimizedLayout, const bool useLookupIndices,
+        const int threadCount, const int batchThreadCount) {
+    // Open the dictionary as latinime_BinaryDictionary_open() does.
+    const int fd = open(dictPath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Can't open %s: errno=%d\n", dictPath, errno);
+        return 1;
+    }
+    struct stat dictStat;
+    if (fstat(fd, &dictStat) != 0 || dictStat.st_size <= 0) {
+        fprintf(stderr, "Can't stat %s: errno=%d\n", dictPath, errno);
+        close(fd);
+        return 1;
+    }
+    const int dictSize = static_cast<int>(dictStat.st_size);
+    void *const dictBuf = mmap(0, dictSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (dictBuf == MAP_FAILED) {
+        fprintf(stderr, "Can't mmap %s: errno=%d\n", dictPath, errno);
+        close(fd);
+        return 1;
+    }
+    if (BinaryFormat::UNKNOWN_FORMAT
+            == BinaryFormat::detectFormat(static_cast<uint8_t *>(dictBuf), dictSize)) {
+        fprintf(stderr, "Unknown dictionary format: %s\n", dictPath);
+        munmap(dictBuf, dictSize);
+        close(fd);
+        return 1;
+    }
+    FILE *const corpus = fopen(corpusPath, "r");
+    if (!corpus) {
+        fprintf(stderr, "Can't open %s: errno=%d\n", corpusPath, errno);
+        munmap(dictBuf, dictSize);
+        close(fd);
+        return 1;
+    }
+    std::vector<std::vector<int> > lines;
+    std::vector<std::vector<int> > words;
+    while (readLine(corpus, &words)) {
+        lines.insert(lines.end(), words.begin(), words.end());
+        // An empty word marks the end of a line: the next word has no previous word.
+        lines.push_back(std::vector<int>());
+    }
+    fclose(corpus);
+
+    const int64_t openStartTimeUs = getMonotonicTimeUs();
+    Dictionary *const dictionary = new Dictionary(dictBuf, dictSize, fd, 0 /* dictBufAdjust */,
+            useCacheOptimizedLayout, useLookupIndices);
+    printf("opened in %lld us, lookup indices: %d KiB\n",
+            static_cast<long long>(getMonotonicTimeUs() - openStartTimeUs),
+            dictionary->getLookupIndicesMemorySize() / 1024);
+    Layout layout;
+    createQwertyLayout(&layout);
+    ProximityInfo *const proximityInfo = createProximityInfo(&layout);
+    JNIEnv env;
+    _jstring locale = { "en_US" };
+    void *const traverseSession = DicTraverseWrapper::getDicTraverseSession(&env, &locale);
+    DicTraverseSession *const session = static_cast<DicTraverseSession *>(traverseSession);
+    session->setExpansionThreadCount(threadCount);
+    if (session->getExpansionThreadCount() != threadCount) {
+        fprintf(stderr, "Expanding on %d threads only\n", session->getExpansionThreadCount());
+    }
+
+    if (batchThreadCount > 0) {
+        runBatches(dictionary, proximityInfo, layout, lines, repeatCount, batchThreadCount);
+    }
+    std::vector<LengthStats> statsPerLength(MAX_WORD_LENGTH);
+    int xs[MAX_WORD_LENGTH];
+    int ys[MAX_WORD_LENGTH];
+    int times[MAX_WORD_LENGTH];
+    int pointerIds[MAX_WORD_LENGTH];
+    int inputCodePoints[MAX_WORD_LENGTH];
+    int outputCodePoints[MAX_WORD_LENGTH * MAX_RESULTS];
+    int scores[MAX_RESULTS];
+    int spaceIndices[MAX_RESULTS];
+    int outputTypes[MAX_RESULTS];
+    for (int repeat = 0; batchThreadCount == 0 && repeat < repeatCount; ++repeat) {
+        const std::vector<int> *prevWord = 0;
+        for (size_t wordIndex = 0; wordIndex < lines.size(); ++wordIndex) {
+            const std::vector<int> &word = lines[wordIndex];
+            if (word.empty()) {
+                prevWord = 0;
+                continue;
+            }
+            // Longer words are not searched, like in BinaryDictionary.getSuggestions().
+            const int wordLength = min(static_cast<int>(word.size()), MAX_WORD_LENGTH - 1);
+            typeWord(layout, word, wordLength, xs, ys, times, pointerIds, inputCodePoints);
+            int prevWordCodePoints[MAX_WORD_LENGTH];
+            const int prevWordLength = prevWord
+                    ? min(static_cast<int>(prevWord->size()), MAX_WORD_LENGTH) : 0;
+            for (int i = 0; i < prevWordLength; ++i) {
+                prevWordCodePoints[i] = (*prevWord)[i];
+            }
+            for (int inputSize = 1; inputSize <= wordLength; ++inputSize) {
+                const int64_t startTimeUs = getMonotonicTimeUs();
+                dictionary->getSuggestions(proximityInfo, traverseSession, xs, ys, times,
+                        pointerIds, inputCodePoints, inputSize,
+                        prevWord ? prevWordCodePoints : 0, prevWordLength, 0 /* commitPoint */,
+                        false /* isGesture */, false /* useFullEditDistance */, outputCodePoints,
+                        scores, spaceIndices, outputTypes);
+                const int latencyUs = static_cast<int>(getMonotonicTimeUs() - startTimeUs);
+                LengthStats *const stats = &statsPerLength[inputSize];
+                stats->mLatenciesUs.push_back(latencyUs);
+                const int expandedDicNodeCount = session->getExpandedDicNodeCount();
+                stats->mExpandedDicNodeCount += expandedDicNodeCount;
+                stats->mMaxExpandedDicNodeCount =
+                        max(stats->mMaxExpandedDicNodeCount, expandedDicNodeCount);
+                stats->mMaxWordArenaSize = max(stats->mMaxWordArenaSize,
+                        session->getDicNodeWordArena()->getUsedSize());
+            }
+            prevWord = &word;
+        }
+    }
+    if (batchThreadCount == 0) {
+        printStats(&statsPerLength);
+    }
+
+    DicTraverseWrapper::releaseDicTraverseSession(traverseSession);
+    delete proximityInfo;
+    delete dictionary;
+    munmap(dictBuf, dictSize);
+    close(fd);
+    return 0;
+}
+} // namespace latinime
+
+int main(int argc, char **argv) {
+    int repeatCount = 1;
+    bool useCacheOptimizedLayout = false;
+    bool useLookupIndices = true;
+    int threadCount = 1;
+    int batchThreadCount = 0;
+    int argIndex = 1;
+    for (; argIndex < argc && argv[argIndex][0] == '-'; ++argIndex) {
+        if (strcmp(argv[argIndex], "-r") == 0 && argIndex + 1 < argc) {
+            repeatCount = atoi(argv[++argIndex]);
+        } else if (strcmp(argv[argIndex], "-o") == 0) {
+            useCacheOptimizedLayout = true;
+        } else if (strcmp(argv[argIndex], "-n") == 0) {
+            useLookupIndices = false;
+        } else if (strcmp(argv[argIndex], "-t") == 0 && argIndex + 1 < argc) {
+            threadCount = atoi(argv[++argIndex]);
+        } else if (strcmp(argv[argIndex], "-b") == 0 && argIndex + 1 < argc) {
+            batchThreadCount = atoi(argv[++argIndex]);
+            if (batchThreadCount <= 0) {
+                break;
+            }
+        } else {
+            break;
+        }
+    }
+    if (argc - argIndex != 2 || repeatCount <= 0 || threadCount <= 0) {
+        fprintf(stderr, "Usage: %s [-r <repeat count>] [-o] [-n] [-t <thread count>]"
+                " [-b <thread count>] <dictionary file> <corpus file>\n"
+                "Memory is reported per length for the word arena only; the peak resident"
+                " memory is for the whole run.\n", argv[0]);
+        return 1;
+    }
+    return latinime::runBenchmark(argv[argIndex], argv[argIndex + 1], repeatCount,
+            useCacheOptimizedLayout, useLookupIndices, threadCount, batchThreadCount);
+}
@@ -27,7 +27,13 @@
 
 namespace latinime {
 
-BigramDictionary::BigramDictionary(const uint8_t *const streamStart) : DICT_ROOT(streamStart) {
+BigramDictionary::BigramDictionary(const uint8_t *const streamStart,
+        const CharGroupLookupIndex *const lookupIndex,
+        const ParentLinkIndex *const parentLinkIndex, const bool supportsDynamicUpdate,
+        const int headerSize)
+        : DICT_ROOT(streamStart), LOOKUP_INDEX(lookupIndex),
+          PARENT_LINK_INDEX(parentLinkIndex), SUPPORTS_DYNAMIC_UPDATE(supportsDynamicUpdate),
+          HEADER_SIZE(headerSize) {
     if (DEBUG_DICT) {
         AKLOGI("BigramDictionary - constructor");
     }
@@ -122,7 +128,7 @@ int BigramDictionary::getBigrams(const int *prevWord, int prevWordLength, int *i
         const int bigramPos = BinaryFormat::getAttributeAddressAndForwardPointer(root, bigramFlags,
                 &pos);
         const int length = BinaryFormat::getWordAtAddress(root, bigramPos, MAX_WORD_LENGTH,
-                bigramBuffer, &unigramProbability);
+                PARENT_LINK_INDEX, SUPPORTS_DYNAMIC_UPDATE, bigramBuffer, &unigramProbability);
 
         // inputSize == 0 means we are trying to find bigram predictions.
         if (inputSize < 1 || checkFirstCharacter(bigramBuffer, inputCodePoints)) {
@@ -150,18 +156,19 @@ int BigramDictionary::getBigramListPositionForWord(const int *prevWord, const in
     if (0 >= prevWordLength) return 0;
     const uint8_t *const root = DICT_ROOT;
     int pos = BinaryFormat::getTerminalPosition(root, prevWord, prevWordLength,
-            forceLowerCaseSearch);
+            forceLowerCaseSearch, LOOKUP_INDEX, SUPPORTS_DYNAMIC_UPDATE, HEADER_SIZE);
 
     if (NOT_VALID_WORD == pos) return 0;
     const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
     if (0 == (flags & BinaryFormat::FLAG_HAS_BIGRAMS)) return 0;
+    pos = BinaryFormat::skipParentPosition(SUPPORTS_DYNAMIC_UPDATE, pos);
     if (0 == (flags & BinaryFormat::FLAG_HAS_MULTIPLE_CHARS)) {
         BinaryFormat::getCodePointAndForwardPointer(root, &pos);
     } else {
         pos = BinaryFormat::skipOtherCharacters(root, pos);
     }
     pos = BinaryFormat::skipProbability(flags, pos);
-    pos = BinaryFormat::skipChildrenPosition(flags, pos);
+    pos = BinaryFormat::skipChildrenPosition(flags, pos, SUPPORTS_DYNAMIC_UPDATE);
     pos = BinaryFormat::skipShortcuts(root, flags, pos);
     return pos;
 }
@@ -213,7 +220,7 @@ bool BigramDictionary::isValidBigram(const int *word1, int length1, const int *w
     // getBigramListPositionForWord returns 0 if this word isn't in the dictionary or has no bigrams
     if (0 == pos) return false;
     int nextWordPos = BinaryFormat::getTerminalPosition(root, word2, length2,
-            false /* forceLowerCaseSearch */);
+            false /* forceLowerCaseSearch */, LOOKUP_INDEX, SUPPORTS_DYNAMIC_UPDATE, HEADER_SIZE);
     if (NOT_VALID_WORD == nextWordPos) return false;
     uint8_t bigramFlags;
     do {
@@ -24,9 +24,15 @@
 
 namespace latinime {
 
+class CharGroupLookupIndex;
+class ParentLinkIndex;
+
 class BigramDictionary {
  public:
-    BigramDictionary(const uint8_t *const streamStart);
+    BigramDictionary(const uint8_t *const streamStart,
+            const CharGroupLookupIndex *const lookupIndex,
+            const ParentLinkIndex *const parentLinkIndex, const bool supportsDynamicUpdate,
+            const int headerSize);
     int getBigrams(const int *word, int length, int *inputCodePoints, int inputSize, int *outWords,
             int *frequencies, int *outputTypes) const;
     void fillBigramAddressToProbabilityMapAndFilter(const int *prevWord, const int prevWordLength,
@@ -42,6 +48,10 @@ class BigramDictionary {
             const bool forceLowerCaseSearch) const;
 
     const uint8_t *const DICT_ROOT;
+    const CharGroupLookupIndex *const LOOKUP_INDEX;
+    const ParentLinkIndex *const PARENT_LINK_INDEX;
+    const bool SUPPORTS_DYNAMIC_UPDATE;
+    const int HEADER_SIZE;
     // TODO: Re-implement proximity correction for bigram correction
     static const int MAX_ALTERNATIVES = 1;
 };
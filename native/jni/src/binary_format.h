@@ -23,7 +23,9 @@
 
 #include "bloom_filter.h"
 #include "char_utils.h"
-#include "hash_map_compat.h"
+#include "fixed_int_hash_map.h"
+#include "suggest/core/dictionary/char_group_lookup_index.h"
+#include "suggest/core/dictionary/parent_link_index.h"
 
 namespace latinime {
 
@@ -31,6 +33,10 @@ class BinaryFormat {
  public:
     // Mask and flags for children address type selection.
     static const int MASK_GROUP_ADDRESS_TYPE = 0xC0;
+    static const int FLAG_GROUP_ADDRESS_TYPE_NOADDRESS = 0x00;
+    static const int FLAG_GROUP_ADDRESS_TYPE_ONEBYTE = 0x40;
+    static const int FLAG_GROUP_ADDRESS_TYPE_TWOBYTES = 0x80;
+    static const int FLAG_GROUP_ADDRESS_TYPE_THREEBYTES = 0xC0;
 
     // Flag for single/multiple char group
     static const int FLAG_HAS_MULTIPLE_CHARS = 0x20;
@@ -60,13 +66,20 @@ class BinaryFormat {
 
     // Mask and flags for attribute address type selection.
     static const int MASK_ATTRIBUTE_ADDRESS_TYPE = 0x30;
+    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_ONEBYTE = 0x10;
+    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_TWOBYTES = 0x20;
+    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_THREEBYTES = 0x30;
 
     static const int UNKNOWN_FORMAT = -1;
     static const int SHORTCUT_LIST_SIZE_SIZE = 2;
 
+    // Bigram probabilities of a word, keyed by the position of the next word.
+    typedef FixedIntHashMap<int, BIGRAM_MAP_CAPACITY> BigramProbabilityMap;
+
     static int detectFormat(const uint8_t *const dict, const int dictSize);
     static int getHeaderSize(const uint8_t *const dict, const int dictSize);
     static int getFlags(const uint8_t *const dict, const int dictSize);
+    static bool supportsDynamicUpdate(const uint8_t *const dict, const int dictSize);
     static bool hasBlacklistedOrNotAWordFlag(const int flags);
     static void readHeaderValue(const uint8_t *const dict, const int dictSize,
             const char *const key, int *outValue, const int outValueSize);
@@ -78,50 +91,62 @@ class BinaryFormat {
     static int readProbabilityWithoutMovingPointer(const uint8_t *const dict, const int pos);
     static int skipOtherCharacters(const uint8_t *const dict, const int pos);
     static int skipChildrenPosition(const uint8_t flags, const int pos);
+    static int skipChildrenPosition(const uint8_t flags, const int pos,
+            const bool supportsDynamicUpdate);
     static int skipProbability(const uint8_t flags, const int pos);
     static int skipShortcuts(const uint8_t *const dict, const uint8_t flags, const int pos);
     static int skipChildrenPosAndAttributes(const uint8_t *const dict, const uint8_t flags,
             const int pos);
+    static int skipChildrenPosAndAttributes(const uint8_t *const dict, const uint8_t flags,
+            const int pos, const bool supportsDynamicUpdate);
     static int readChildrenPosition(const uint8_t *const dict, const uint8_t flags, const int pos);
+    static int readChildrenPosition(const uint8_t *const dict, const uint8_t flags, const int pos,
+            const bool supportsDynamicUpdate);
     static bool hasChildrenInFlags(const uint8_t flags);
+    static bool isMovedGroup(const uint8_t flags, const bool supportsDynamicUpdate);
+    static bool isDeletedGroup(const uint8_t flags, const bool supportsDynamicUpdate);
+    static int skipParentPosition(const bool supportsDynamicUpdate, const int pos);
+    static int readParentPosition(const uint8_t *const dict, const int charGroupPos);
+    static int readForwardLinkPosition(const uint8_t *const dict, const int pos,
+            const int headerSize);
     static int getAttributeAddressAndForwardPointer(const uint8_t *const dict, const uint8_t flags,
             int *pos);
     static int getAttributeProbabilityFromFlags(const int flags);
     static int getTerminalPosition(const uint8_t *const root, const int *const inWord,
-            const int length, const bool forceLowerCaseSearch);
+            const int length, const bool forceLowerCaseSearch,
+            const CharGroupLookupIndex *const lookupIndex, const bool supportsDynamicUpdate,
+            const int headerSize);
     static int getWordAtAddress(const uint8_t *const root, const int address, const int maxDepth,
+            const ParentLinkIndex *const parentLinkIndex, const bool supportsDynamicUpdate,
             int *outWord, int *outUnigramProbability);
     static int computeProbabilityForBigram(
             const int unigramProbability, const int bigramProbability);
     static int getProbability(const int position, const std::map<int, int> *bigramMap,
             const uint8_t *bigramFilter, const int unigramProbability);
     static int getBigramProbabilityFromHashMap(const int position,
-            const hash_map_compat<int, int> *bigramMap, const int unigramProbability);
+            const BigramProbabilityMap *bigramMap, const int unigramProbability);
     static float getMultiWordCostMultiplier(const uint8_t *const dict, const int dictSize);
-    static void fillBigramProbabilityToHashMap(const uint8_t *const root, int position,
-            hash_map_compat<int, int> *bigramMap);
+    static bool fillBigramProbabilityToHashMap(const uint8_t *const root, int position,
+            const bool supportsDynamicUpdate, BigramProbabilityMap *bigramMap);
     static int getBigramProbability(const uint8_t *const root, int position,
-            const int nextPosition, const int unigramProbability);
+            const int nextPosition, const int unigramProbability,
+            const bool supportsDynamicUpdate);
+    static int getMaxBigramProbability(const uint8_t *const root, int position,
+            const bool supportsDynamicUpdate);
 
     // Flags for special processing
     // Those *must* match the flags in makedict (BinaryDictInputOutput#*_PROCESSING_FLAG) or
     // something very bad (like, the apocalypse) will happen. Please update both at the same time.
     enum {
         REQUIRES_GERMAN_UMLAUT_PROCESSING = 0x1,
+        SUPPORTS_DYNAMIC_UPDATE = 0x2,
         REQUIRES_FRENCH_LIGATURES_PROCESSING = 0x4
     };
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(BinaryFormat);
-    static int getBigramListPositionForWordPosition(const uint8_t *const root, int position);
-
-    static const int FLAG_GROUP_ADDRESS_TYPE_NOADDRESS = 0x00;
-    static const int FLAG_GROUP_ADDRESS_TYPE_ONEBYTE = 0x40;
-    static const int FLAG_GROUP_ADDRESS_TYPE_TWOBYTES = 0x80;
-    static const int FLAG_GROUP_ADDRESS_TYPE_THREEBYTES = 0xC0;
-    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_ONEBYTE = 0x10;
-    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_TWOBYTES = 0x20;
-    static const int FLAG_ATTRIBUTE_ADDRESS_TYPE_THREEBYTES = 0x30;
+    static int getBigramListPositionForWordPosition(const uint8_t *const root, int position,
+            const bool supportsDynamicUpdate);
 
     // Any file smaller than this is not a dictionary.
     static const int DICTIONARY_MINIMUM_SIZE = 4;
@@ -136,6 +161,20 @@ class BinaryFormat {
     static const int FORMAT_VERSION_2_MAGIC_NUMBER = -1681835266; // 0x9BC13AFE
     // Magic number (4 bytes), version (2 bytes), options (2 bytes), header size (4 bytes) = 12
     static const int FORMAT_VERSION_2_MINIMUM_SIZE = 12;
+    // Version 3 has the same header as version 2. When SUPPORTS_DYNAMIC_UPDATE is set, each
+    // char group has a parent address after its flags, the children address is always a signed
+    // 3-byte offset, and each array of char groups ends with a forward link to the next array of
+    // the same node. The children address type bits of the flags then tell whether the group was
+    // moved or deleted. Those *must* match makedict (FormatSpec).
+    static const int FIRST_VERSION_WITH_DYNAMIC_UPDATE = 3;
+    static const int MASK_MOVE_AND_DELETE_FLAG = 0xC0;
+    static const int FLAG_IS_MOVED = 0x40;
+    static const int FLAG_IS_DELETED = 0x80;
+    static const int PARENT_ADDRESS_SIZE = 3;
+    static const int SIGNED_CHILDREN_ADDRESS_SIZE = 3;
+    static const int FORWARD_LINK_ADDRESS_SIZE = 3;
+    static const int MASK_SIGNED_INT24_SIGN = 0x800000;
+    static const int MASK_SIGNED_INT24_VALUE = 0x7FFFFF;
 
     static const int CHARACTER_ARRAY_TERMINATOR_SIZE = 1;
     static const int MINIMAL_ONE_BYTE_CHARACTER_VALUE = 0x20;
@@ -144,6 +183,15 @@ class BinaryFormat {
     static const int NO_FLAGS = 0;
     static int skipAllAttributes(const uint8_t *const dict, const uint8_t flags, const int pos);
     static int skipBigrams(const uint8_t *const dict, const uint8_t flags, const int pos);
+    static int readSignedInt24(const uint8_t *const dict, const int pos);
+    static int getWordAtAddressWithParentLinks(const uint8_t *const root, const int address,
+            const int maxDepth, const ParentLinkIndex *const parentLinkIndex, int *outWord,
+            int *outUnigramProbability);
+    static int getWordAtAddressWithParentAddresses(const uint8_t *const root, const int address,
+            const int maxDepth, int *outWord, int *outUnigramProbability);
+    static int getWordFromCharGroupPath(const uint8_t *const root, const int *const path,
+            const int pathLength, const int maxDepth, const bool supportsDynamicUpdate,
+            int *outWord, int *outUnigramProbability);
 };
 
 AK_FORCE_INLINE int BinaryFormat::detectFormat(const uint8_t *const dict, const int dictSize) {
@@ -193,6 +241,7 @@ inline int BinaryFormat::getHeaderSize(const uint8_t *const dict, const int dict
     case 1:
         return FORMAT_VERSION_1_HEADER_SIZE;
     case 2:
+    case FIRST_VERSION_WITH_DYNAMIC_UPDATE:
         // See the format of the header in the comment in detectFormat() above
         return (dict[8] << 24) + (dict[9] << 16) + (dict[10] << 8) + dict[11];
     default:
@@ -200,6 +249,11 @@ inline int BinaryFormat::getHeaderSize(const uint8_t *const dict, const int dict
     }
 }
 
+inline bool BinaryFormat::supportsDynamicUpdate(const uint8_t *const dict, const int dictSize) {
+    return detectFormat(dict, dictSize) >= FIRST_VERSION_WITH_DYNAMIC_UPDATE
+            && (getFlags(dict, dictSize) & SUPPORTS_DYNAMIC_UPDATE) != 0;
+}
+
 inline void BinaryFormat::readHeaderValue(const uint8_t *const dict, const int dictSize,
         const char *const key, int *outValue, const int outValueSize) {
     int outValueIndex = 0;
@@ -429,6 +483,62 @@ inline bool BinaryFormat::hasChildrenInFlags(const uint8_t flags) {
     return (FLAG_GROUP_ADDRESS_TYPE_NOADDRESS != (MASK_GROUP_ADDRESS_TYPE & flags));
 }
 
+// Signed 3-byte values of dynamic dictionaries are stored as a sign bit and a magnitude.
+inline int BinaryFormat::readSignedInt24(const uint8_t *const dict, const int pos) {
+    const int value = (dict[pos] << 16) + (dict[pos + 1] << 8) + dict[pos + 2];
+    return (value & MASK_SIGNED_INT24_SIGN) ? -(value & MASK_SIGNED_INT24_VALUE) : value;
+}
+
+inline bool BinaryFormat::isMovedGroup(const uint8_t flags, const bool supportsDynamicUpdate) {
+    return supportsDynamicUpdate && FLAG_IS_MOVED == (MASK_MOVE_AND_DELETE_FLAG & flags);
+}
+
+inline bool BinaryFormat::isDeletedGroup(const uint8_t flags, const bool supportsDynamicUpdate) {
+    return supportsDynamicUpdate && FLAG_IS_DELETED == (MASK_MOVE_AND_DELETE_FLAG & flags);
+}
+
+// pos must be right after the flags.
+inline int BinaryFormat::skipParentPosition(const bool supportsDynamicUpdate, const int pos) {
+    return supportsDynamicUpdate ? pos + PARENT_ADDRESS_SIZE : pos;
+}
+
+// Returns the position of the parent char group, or -1 for char groups of the root node. For a
+// moved char group, this is the position it was moved to instead.
+inline int BinaryFormat::readParentPosition(const uint8_t *const dict, const int charGroupPos) {
+    const int offset = readSignedInt24(dict, charGroupPos + 1 /* flags */);
+    return 0 == offset ? -1 : charGroupPos + offset;
+}
+
+// pos must be right after the last char group of an array. Returns the position of the next
+// array of char groups of the same node, or -1 if there is none. Forward links are written as
+// positions in the whole file, so they are shifted by headerSize to be relative to the root.
+inline int BinaryFormat::readForwardLinkPosition(const uint8_t *const dict, const int pos,
+        const int headerSize) {
+    const int linkPos = readSignedInt24(dict, pos);
+    return linkPos <= 0 ? -1 : linkPos - headerSize;
+}
+
+inline int BinaryFormat::skipChildrenPosition(const uint8_t flags, const int pos,
+        const bool supportsDynamicUpdate) {
+    return supportsDynamicUpdate
+            ? pos + SIGNED_CHILDREN_ADDRESS_SIZE : skipChildrenPosition(flags, pos);
+}
+
+AK_FORCE_INLINE int BinaryFormat::skipChildrenPosAndAttributes(const uint8_t *const dict,
+        const uint8_t flags, const int pos, const bool supportsDynamicUpdate) {
+    return skipAllAttributes(dict, flags, skipChildrenPosition(flags, pos, supportsDynamicUpdate));
+}
+
+// Returns -1 if the char group has no children.
+AK_FORCE_INLINE int BinaryFormat::readChildrenPosition(const uint8_t *const dict,
+        const uint8_t flags, const int pos, const bool supportsDynamicUpdate) {
+    if (!supportsDynamicUpdate) {
+        return readChildrenPosition(dict, flags, pos);
+    }
+    const int offset = readSignedInt24(dict, pos);
+    return 0 == offset ? -1 : pos + offset;
+}
+
 AK_FORCE_INLINE int BinaryFormat::getAttributeAddressAndForwardPointer(const uint8_t *const dict,
         const uint8_t flags, int *pos) {
     int offset = 0;
@@ -464,7 +574,9 @@ inline int BinaryFormat::getAttributeProbabilityFromFlags(const int flags) {
 // This function gets the byte position of the last chargroup of the exact matching word in the
 // dictionary. If no match is found, it returns NOT_VALID_WORD.
 AK_FORCE_INLINE int BinaryFormat::getTerminalPosition(const uint8_t *const root,
-        const int *const inWord, const int length, const bool forceLowerCaseSearch) {
+        const int *const inWord, const int length, const bool forceLowerCaseSearch,
+        const CharGroupLookupIndex *const lookupIndex, const bool supportsDynamicUpdate,
+        const int headerSize) {
     int pos = 0;
     int wordPos = 0;
 
@@ -472,16 +584,35 @@ AK_FORCE_INLINE int BinaryFormat::getTerminalPosition(const uint8_t *const root,
         // If we already traversed the tree further than the word is long, there means
         // there was no match (or we would have found it).
         if (wordPos >= length) return NOT_VALID_WORD;
-        int charGroupCount = BinaryFormat::getGroupCountAndForwardPointer(root, &pos);
         const int wChar = forceLowerCaseSearch ? toLowerCase(inWord[wordPos]) : inWord[wordPos];
+        // Wide nodes are looked up in the index instead of scanning all their siblings.
+        const int indexedCharGroupPos = lookupIndex
+                ? lookupIndex->getCharGroupPos(pos, wChar) : CharGroupLookupIndex::NOT_INDEXED;
+        if (NOT_VALID_WORD == indexedCharGroupPos) return NOT_VALID_WORD;
+        int charGroupCount;
+        if (CharGroupLookupIndex::NOT_INDEXED == indexedCharGroupPos) {
+            charGroupCount = BinaryFormat::getGroupCountAndForwardPointer(root, &pos);
+        } else {
+            pos = indexedCharGroupPos;
+            charGroupCount = 1;
+        }
         while (true) {
             // If there are no more character groups in this node, it means we could not
             // find a matching character for this depth, therefore there is no match.
-            if (0 >= charGroupCount) return NOT_VALID_WORD;
+            // Dynamic dictionaries may continue the node in another array of char groups.
+            if (0 >= charGroupCount) {
+                if (!supportsDynamicUpdate) return NOT_VALID_WORD;
+                pos = readForwardLinkPosition(root, pos, headerSize);
+                if (pos < 0) return NOT_VALID_WORD;
+                charGroupCount = BinaryFormat::getGroupCountAndForwardPointer(root, &pos);
+                continue;
+            }
             const int charGroupPos = pos;
             const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+            pos = skipParentPosition(supportsDynamicUpdate, pos);
             int character = BinaryFormat::getCodePointAndForwardPointer(root, &pos);
-            if (character == wChar) {
+            // A moved char group has a live copy in a later array of this node.
+            if (character == wChar && !isMovedGroup(flags, supportsDynamicUpdate)) {
                 // This is the correct node. Only one character group may start with the same
                 // char within a node, so either we found our match in this node, or there is
                 // no match and we can return NOT_VALID_WORD. So we will check all the characters
@@ -506,17 +637,18 @@ AK_FORCE_INLINE int BinaryFormat::getTerminalPosition(const uint8_t *const root,
                 ++wordPos;
                 if (FLAG_IS_TERMINAL & flags) {
                     if (wordPos == length) {
-                        return charGroupPos;
+                        return isDeletedGroup(flags, supportsDynamicUpdate)
+                                ? NOT_VALID_WORD : charGroupPos;
                     }
                     pos = BinaryFormat::skipProbability(FLAG_IS_TERMINAL, pos);
                 }
-                if (FLAG_GROUP_ADDRESS_TYPE_NOADDRESS == (MASK_GROUP_ADDRESS_TYPE & flags)) {
-                    return NOT_VALID_WORD;
-                }
                 // We have children and we are still shorter than the word we are searching for, so
                 // we need to traverse children. Put the pointer on the children position, and
                 // break
-                pos = BinaryFormat::readChildrenPosition(root, flags, pos);
+                pos = BinaryFormat::readChildrenPosition(root, flags, pos, supportsDynamicUpdate);
+                if (pos < 0) {
+                    return NOT_VALID_WORD;
+                }
                 break;
             } else {
                 // This chargroup does not match, so skip the remaining part and go to the next.
@@ -524,7 +656,8 @@ AK_FORCE_INLINE int BinaryFormat::getTerminalPosition(const uint8_t *const root,
                     pos = BinaryFormat::skipOtherCharacters(root, pos);
                 }
                 pos = BinaryFormat::skipProbability(flags, pos);
-                pos = BinaryFormat::skipChildrenPosAndAttributes(root, flags, pos);
+                pos = BinaryFormat::skipChildrenPosAndAttributes(root, flags, pos,
+                        supportsDynamicUpdate);
             }
             --charGroupCount;
         }
@@ -550,7 +683,16 @@ AK_FORCE_INLINE int BinaryFormat::getTerminalPosition(const uint8_t *const root,
  * Return value : the length of the word, of 0 if the word was not found.
  */
 AK_FORCE_INLINE int BinaryFormat::getWordAtAddress(const uint8_t *const root, const int address,
-        const int maxDepth, int *outWord, int *outUnigramProbability) {
+        const int maxDepth, const ParentLinkIndex *const parentLinkIndex,
+        const bool supportsDynamicUpdate, int *outWord, int *outUnigramProbability) {
+    if (supportsDynamicUpdate) {
+        return getWordAtAddressWithParentAddresses(root, address, maxDepth, outWord,
+                outUnigramProbability);
+    }
+    if (parentLinkIndex && !parentLinkIndex->isEmpty()) {
+        return getWordAtAddressWithParentLinks(root, address, maxDepth, parentLinkIndex, outWord,
+                outUnigramProbability);
+    }
     int pos = 0;
     int wordPos = 0;
 
@@ -677,6 +819,73 @@ AK_FORCE_INLINE int BinaryFormat::getWordAtAddress(const uint8_t *const root, co
     return 0;
 }
 
+// Same as getWordAtAddress, but climbs from the terminal to the root using the parent links and
+// then copies the characters of each char group on the path, so no sibling is ever scanned.
+inline int BinaryFormat::getWordAtAddressWithParentLinks(const uint8_t *const root,
+        const int address, const int maxDepth, const ParentLinkIndex *const parentLinkIndex,
+        int *outWord, int *outUnigramProbability) {
+    // Each char group holds at least one character, so the path is at most maxDepth long.
+    int path[MAX_WORD_LENGTH];
+    const int maxPathLength = min(maxDepth, MAX_WORD_LENGTH);
+    int pathLength = 0;
+    for (int charGroupPos = address; ParentLinkIndex::NO_PARENT != charGroupPos;
+            charGroupPos = parentLinkIndex->getParentCharGroupPos(charGroupPos)) {
+        // Stop on broken links rather than looping forever.
+        if (pathLength >= maxPathLength || charGroupPos < 0) return 0;
+        path[pathLength++] = charGroupPos;
+    }
+    return getWordFromCharGroupPath(root, path, pathLength, maxDepth,
+            false /* supportsDynamicUpdate */, outWord, outUnigramProbability);
+}
+
+// Same as getWordAtAddressWithParentLinks, but for dynamic dictionaries, which store the parent
+// address in each char group. Moved char groups are followed to their new position.
+inline int BinaryFormat::getWordAtAddressWithParentAddresses(const uint8_t *const root,
+        const int address, const int maxDepth, int *outWord, int *outUnigramProbability) {
+    int path[MAX_WORD_LENGTH];
+    const int maxPathLength = min(maxDepth, MAX_WORD_LENGTH);
+    int pathLength = 0;
+    int charGroupPos = address;
+    // Bounds the number of moves followed as well, in case the file is broken.
+    for (int loopCount = maxPathLength * 2; charGroupPos >= 0; --loopCount) {
+        if (loopCount <= 0) return 0;
+        const int parentPos = readParentPosition(root, charGroupPos);
+        if (isMovedGroup(root[charGroupPos], true /* supportsDynamicUpdate */)) {
+            charGroupPos = parentPos;
+            continue;
+        }
+        if (pathLength >= maxPathLength) return 0;
+        path[pathLength++] = charGroupPos;
+        charGroupPos = parentPos;
+    }
+    return getWordFromCharGroupPath(root, path, pathLength, maxDepth,
+            true /* supportsDynamicUpdate */, outWord, outUnigramProbability);
+}
+
+// Copies the characters of the char groups in path, which goes from a terminal up to the root,
+// and reads the probability of the terminal.
+inline int BinaryFormat::getWordFromCharGroupPath(const uint8_t *const root,
+        const int *const path, const int pathLength, const int maxDepth,
+        const bool supportsDynamicUpdate, int *outWord, int *outUnigramProbability) {
+    if (pathLength <= 0) return 0;
+    int wordPos = 0;
+    int pos = 0;
+    for (int i = pathLength - 1; i >= 0; --i) {
+        pos = path[i];
+        const uint8_t flags = getFlagsAndForwardPointer(root, &pos);
+        pos = skipParentPosition(supportsDynamicUpdate, pos);
+        int character = getCodePointAndForwardPointer(root, &pos);
+        while (NOT_A_CODE_POINT != character) {
+            if (wordPos >= maxDepth) return 0;
+            outWord[wordPos++] = character;
+            character = (FLAG_HAS_MULTIPLE_CHARS & flags)
+                    ? getCodePointAndForwardPointer(root, &pos) : NOT_A_CODE_POINT;
+        }
+    }
+    *outUnigramProbability = readProbabilityWithoutMovingPointer(root, pos);
+    return wordPos;
+}
+
 static inline int backoff(const int unigramProbability) {
     return unigramProbability;
     // For some reason, applying the backoff weight gives bad results in tests. To apply the
@@ -714,20 +923,21 @@ inline int BinaryFormat::getProbability(const int position, const std::map<int,
 
 // This returns a probability in log space.
 inline int BinaryFormat::getBigramProbabilityFromHashMap(const int position,
-        const hash_map_compat<int, int> *bigramMap, const int unigramProbability) {
+        const BigramProbabilityMap *bigramMap, const int unigramProbability) {
     if (!bigramMap) return backoff(unigramProbability);
-    const hash_map_compat<int, int>::const_iterator bigramProbabilityIt = bigramMap->find(position);
-    if (bigramProbabilityIt != bigramMap->end()) {
-        const int bigramProbability = bigramProbabilityIt->second;
-        return computeProbabilityForBigram(unigramProbability, bigramProbability);
+    const int *const bigramProbability = bigramMap->find(position);
+    if (bigramProbability) {
+        return computeProbabilityForBigram(unigramProbability, *bigramProbability);
     }
     return backoff(unigramProbability);
 }
 
-AK_FORCE_INLINE void BinaryFormat::fillBigramProbabilityToHashMap(
-        const uint8_t *const root, int position, hash_map_compat<int, int> *bigramMap) {
-    position = getBigramListPositionForWordPosition(root, position);
-    if (0 == position) return;
+// Returns false if the bigram list does not fit in bigramMap.
+AK_FORCE_INLINE bool BinaryFormat::fillBigramProbabilityToHashMap(
+        const uint8_t *const root, int position, const bool supportsDynamicUpdate,
+        BigramProbabilityMap *bigramMap) {
+    position = getBigramListPositionForWordPosition(root, position, supportsDynamicUpdate);
+    if (0 == position) return true;
 
     uint8_t bigramFlags;
     do {
@@ -735,13 +945,16 @@ AK_FORCE_INLINE void BinaryFormat::fillBigramProbabilityToHashMap(
         const int probability = MASK_ATTRIBUTE_PROBABILITY & bigramFlags;
         const int bigramPos = getAttributeAddressAndForwardPointer(root, bigramFlags,
                 &position);
-        (*bigramMap)[bigramPos] = probability;
+        if (!bigramMap->put(bigramPos, probability)) {
+            return false;
+        }
     } while (FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+    return true;
 }
 
 AK_FORCE_INLINE int BinaryFormat::getBigramProbability(const uint8_t *const root, int position,
-        const int nextPosition, const int unigramProbability) {
-    position = getBigramListPositionForWordPosition(root, position);
+        const int nextPosition, const int unigramProbability, const bool supportsDynamicUpdate) {
+    position = getBigramListPositionForWordPosition(root, position, supportsDynamicUpdate);
     if (0 == position) return backoff(unigramProbability);
 
     uint8_t bigramFlags;
@@ -757,19 +970,48 @@ AK_FORCE_INLINE int BinaryFormat::getBigramProbability(const uint8_t *const root
     return backoff(unigramProbability);
 }
 
+// Returns the highest probability of a bigram of the word at position, or NOT_A_PROBABILITY if it
+// has none.
+inline int BinaryFormat::getMaxBigramProbability(const uint8_t *const root, int position,
+        const bool supportsDynamicUpdate) {
+    position = getBigramListPositionForWordPosition(root, position, supportsDynamicUpdate);
+    if (0 == position) return NOT_A_PROBABILITY;
+
+    int maxProbability = NOT_A_PROBABILITY;
+    uint8_t bigramFlags;
+    do {
+        bigramFlags = getFlagsAndForwardPointer(root, &position);
+        int bigramPos = getAttributeAddressAndForwardPointer(root, bigramFlags, &position);
+        const uint8_t flags = getFlagsAndForwardPointer(root, &bigramPos);
+        if (!(FLAG_IS_TERMINAL & flags)) continue;
+        bigramPos = skipParentPosition(supportsDynamicUpdate, bigramPos);
+        if (flags & FLAG_HAS_MULTIPLE_CHARS) {
+            bigramPos = skipOtherCharacters(root, bigramPos);
+        } else {
+            getCodePointAndForwardPointer(root, &bigramPos);
+        }
+        const int unigramProbability = readProbabilityWithoutMovingPointer(root, bigramPos);
+        const int bigramProbability = MASK_ATTRIBUTE_PROBABILITY & bigramFlags;
+        maxProbability = max(maxProbability,
+                computeProbabilityForBigram(unigramProbability, bigramProbability));
+    } while (FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+    return maxProbability;
+}
+
 // Returns a pointer to the start of the bigram list.
 AK_FORCE_INLINE int BinaryFormat::getBigramListPositionForWordPosition(
-        const uint8_t *const root, int position) {
+        const uint8_t *const root, int position, const bool supportsDynamicUpdate) {
     if (NOT_VALID_WORD == position) return 0;
     const uint8_t flags = getFlagsAndForwardPointer(root, &position);
     if (!(flags & FLAG_HAS_BIGRAMS)) return 0;
+    position = skipParentPosition(supportsDynamicUpdate, position);
     if (flags & FLAG_HAS_MULTIPLE_CHARS) {
         position = skipOtherCharacters(root, position);
     } else {
         getCodePointAndForwardPointer(root, &position);
     }
     position = skipProbability(flags, position);
-    position = skipChildrenPosition(flags, position);
+    position = skipChildrenPosition(flags, position, supportsDynamicUpdate);
     position = skipShortcuts(root, flags, position);
     return position;
 }
@@ -55,6 +55,32 @@ inline static int toBaseCodePoint(int c) {
     return c;
 }
 
+/**
+ * Two-stage tables mapping the code points of the BMP to their lower case, and to the lower case
+ * of their base characters. The code points are split into blocks of CASE_TABLE_BLOCK_SIZE:
+ * *_CASE_BLOCKS[c >> CASE_TABLE_BLOCK_SHIFT] is the index of the block of deltas of c in
+ * *_CASE_DELTAS, where the mapping of c is c plus its delta, modulo 0x10000. Blocks with the same
+ * deltas, like all those without mappings, are shared. They are generated from latin_tolower() and
+ * BASE_CHARS, see char_utils.cpp.
+ */
+static const int CASE_TABLE_SIZE = 0x10000;
+static const int CASE_TABLE_BLOCK_SHIFT = 6;
+static const int CASE_TABLE_BLOCK_SIZE = 1 << CASE_TABLE_BLOCK_SHIFT;
+extern const unsigned char LOWER_CASE_BLOCKS[CASE_TABLE_SIZE >> CASE_TABLE_BLOCK_SHIFT];
+extern const unsigned short LOWER_CASE_DELTAS[];
+extern const unsigned char BASE_LOWER_CASE_BLOCKS[CASE_TABLE_SIZE >> CASE_TABLE_BLOCK_SHIFT];
+extern const unsigned short BASE_LOWER_CASE_DELTAS[];
+
+AK_FORCE_INLINE static bool isInCaseTables(const int c) {
+    return static_cast<unsigned int>(c) < static_cast<unsigned int>(CASE_TABLE_SIZE);
+}
+
+AK_FORCE_INLINE static int getCaseTableMapping(const unsigned char *const blocks,
+        const unsigned short *const deltas, const int c) {
+    const int blockStart = blocks[c >> CASE_TABLE_BLOCK_SHIFT] << CASE_TABLE_BLOCK_SHIFT;
+    return static_cast<unsigned short>(c + deltas[blockStart + (c & (CASE_TABLE_BLOCK_SIZE - 1))]);
+}
+
 AK_FORCE_INLINE static int toLowerCase(const int c) {
     if (isAsciiUpper(c)) {
         return toAsciiLower(c);
@@ -62,11 +88,18 @@ AK_FORCE_INLINE static int toLowerCase(const int c) {
     if (isAscii(c)) {
         return c;
     }
+    if (isInCaseTables(c)) {
+        return getCaseTableMapping(LOWER_CASE_BLOCKS, LOWER_CASE_DELTAS, c);
+    }
     return static_cast<int>(latin_tolower(static_cast<unsigned short>(c)));
 }
 
 AK_FORCE_INLINE static int toBaseLowerCase(const int c) {
-    return toLowerCase(toBaseCodePoint(c));
+    if (isInCaseTables(c)) {
+        return getCaseTableMapping(BASE_LOWER_CASE_BLOCKS, BASE_LOWER_CASE_DELTAS, c);
+    }
+    // There are no base characters outside the BMP.
+    return toLowerCase(c);
 }
 
 inline static bool isIntentionalOmissionCodePoint(const int codePoint) {
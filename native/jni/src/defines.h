@@ -34,6 +34,8 @@
 #define MAX_RESULTS 18
 // Must be equal to ProximityInfo.MAX_PROXIMITY_CHARS_SIZE in Java
 #define MAX_PROXIMITY_CHARS_SIZE 16
+// Must be equal to BinaryDictionary.MAX_SEARCHED_DICTIONARY_COUNT in Java
+#define MAX_SEARCHED_DICTIONARY_COUNT 4
 #define ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE 2
 
 #if defined(FLAG_DO_PROFILE) || defined(FLAG_DBG)
@@ -385,8 +387,9 @@ static inline void prof_out(void) {
 // the beginning of the input and are thus the first ones to be cached. Note that these bigrams
 // are reset for each new composing word.
 #define MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP 25
-// Most common previous word contexts currently have 100 bigrams
-#define DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP 100
+// Most common previous word contexts currently have 100 bigrams. This must be a power of two;
+// contexts with more bigrams than 3/4 of it are not cached and read from the dictionary instead.
+#define BIGRAM_MAP_CAPACITY 256
 
 template<typename T> AK_FORCE_INLINE const T &min(const T &a, const T &b) { return a < b ? a : b; }
 template<typename T> AK_FORCE_INLINE const T &max(const T &a, const T &b) { return a > b ? a : b; }
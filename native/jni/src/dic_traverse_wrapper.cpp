@@ -23,4 +23,7 @@ void *(*DicTraverseWrapper::sDicTraverseSessionFactoryMethod)(JNIEnv *, jstring)
 void (*DicTraverseWrapper::sDicTraverseSessionReleaseMethod)(void *) = 0;
 void (*DicTraverseWrapper::sDicTraverseSessionInitMethod)(
         void *, const Dictionary *const, const int *, const int) = 0;
+void (*DicTraverseWrapper::sDicTraverseSessionSearchLimitsMethod)(
+        void *, const int, const int) = 0;
+void (*DicTraverseWrapper::sDicTraverseSessionExpansionThreadCountMethod)(void *, const int) = 0;
 } // namespace latinime
@@ -37,6 +37,19 @@ class DicTraverseWrapper {
             sDicTraverseSessionInitMethod(traverseSession, dictionary, prevWord, prevWordLength);
         }
     }
+    static void setDicTraverseSessionSearchLimits(void *traverseSession,
+            const int maxSearchTimeMs, const int maxExpandedDicNodeCount) {
+        if (sDicTraverseSessionSearchLimitsMethod) {
+            sDicTraverseSessionSearchLimitsMethod(
+                    traverseSession, maxSearchTimeMs, maxExpandedDicNodeCount);
+        }
+    }
+    static void setDicTraverseSessionExpansionThreadCount(void *traverseSession,
+            const int threadCount) {
+        if (sDicTraverseSessionExpansionThreadCountMethod) {
+            sDicTraverseSessionExpansionThreadCountMethod(traverseSession, threadCount);
+        }
+    }
     static void releaseDicTraverseSession(void *traverseSession) {
         if (sDicTraverseSessionReleaseMethod) {
             sDicTraverseSessionReleaseMethod(traverseSession);
@@ -49,6 +62,14 @@ class DicTraverseWrapper {
             void (*initMethod)(void *, const Dictionary *const, const int *, const int)) {
         sDicTraverseSessionInitMethod = initMethod;
     }
+    static void setTraverseSessionSearchLimitsMethod(
+            void (*searchLimitsMethod)(void *, const int, const int)) {
+        sDicTraverseSessionSearchLimitsMethod = searchLimitsMethod;
+    }
+    static void setTraverseSessionExpansionThreadCountMethod(
+            void (*expansionThreadCountMethod)(void *, const int)) {
+        sDicTraverseSessionExpansionThreadCountMethod = expansionThreadCountMethod;
+    }
     static void setTraverseSessionReleaseMethod(void (*releaseMethod)(void *)) {
         sDicTraverseSessionReleaseMethod = releaseMethod;
     }
@@ -58,6 +79,8 @@ class DicTraverseWrapper {
     static void *(*sDicTraverseSessionFactoryMethod)(JNIEnv *, jstring);
     static void (*sDicTraverseSessionInitMethod)(
             void *, const Dictionary *const, const int *, const int);
+    static void (*sDicTraverseSessionSearchLimitsMethod)(void *, const int, const int);
+    static void (*sDicTraverseSessionExpansionThreadCountMethod)(void *, const int);
     static void (*sDicTraverseSessionReleaseMethod)(void *);
 };
 } // namespace latinime
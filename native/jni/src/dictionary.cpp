@@ -25,6 +25,13 @@
 #include "binary_format.h"
 #include "defines.h"
 #include "dic_traverse_wrapper.h"
+#include "suggest/core/dictionary/cache_optimized_trie.h"
+#include "suggest/core/dictionary/char_group_lookup_index.h"
+#include "suggest/core/dictionary/parent_link_index.h"
+#include "suggest/core/dictionary/subtree_probability_index.h"
+#include "suggest/core/dictionary/trie_walk.h"
+#include "suggest/core/session/dic_traverse_session.h"
+#include "suggest/core/session/dic_traverse_session_pool.h"
 #include "suggest/core/suggest.h"
 #include "suggest/policyimpl/gesture/gesture_suggest_policy_factory.h"
 #include "suggest/policyimpl/typing/typing_suggest_policy_factory.h"
@@ -32,16 +39,42 @@
 
 namespace latinime {
 
-Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust)
+Dictionary::Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust,
+        bool useCacheOptimizedLayout, bool useLookupIndices)
         : mDict(static_cast<unsigned char *>(dict)),
-          mOffsetDict((static_cast<unsigned char *>(dict))
-                  + BinaryFormat::getHeaderSize(mDict, dictSize)),
+          mHeaderSize(BinaryFormat::getHeaderSize(mDict, dictSize)),
+          mCacheOptimizedTrie(useCacheOptimizedLayout
+                  ? CacheOptimizedTrie::create(mDict, dictSize) : 0),
+          mOffsetDict((mCacheOptimizedTrie ? mCacheOptimizedTrie->getDict() : mDict)
+                  + mHeaderSize),
           mDictSize(dictSize), mMmapFd(mmapFd), mDictBufAdjust(dictBufAdjust),
-          mUnigramDictionary(new UnigramDictionary(mOffsetDict,
-                  BinaryFormat::getFlags(mDict, dictSize))),
-          mBigramDictionary(new BigramDictionary(mOffsetDict)),
+          mSupportsDynamicUpdate(BinaryFormat::supportsDynamicUpdate(mDict, dictSize)),
+          mDictBodySize((mCacheOptimizedTrie ? mCacheOptimizedTrie->getDictSize() : dictSize)
+                  - mHeaderSize),
+          mCharGroupLookupIndex(0), mParentLinkIndex(0), mSubtreeProbabilityIndex(0),
+          mUnigramDictionary(0), mBigramDictionary(0),
           mGestureSuggest(new Suggest(GestureSuggestPolicyFactory::getGestureSuggestPolicy())),
-          mTypingSuggest(new Suggest(TypingSuggestPolicyFactory::getTypingSuggestPolicy())) {
+          mTypingSuggest(new Suggest(TypingSuggestPolicyFactory::getTypingSuggestPolicy())),
+          mTraverseSessionPool(new DicTraverseSessionPool()) {
+    // Dynamic dictionaries change in place, so they are not indexed. The indices share one walk
+    // of the trie. The parent links are always built for the cache optimized layout, as finding
+    // the word at an address without them relies on the node order of makedict.
+    if ((useLookupIndices || mCacheOptimizedTrie) && !mSupportsDynamicUpdate) {
+        const TrieWalk trieWalk(mOffsetDict, mDictBodySize);
+        mParentLinkIndex = new ParentLinkIndex(trieWalk);
+        if (useLookupIndices) {
+            mCharGroupLookupIndex = new CharGroupLookupIndex(trieWalk);
+            mSubtreeProbabilityIndex = new SubtreeProbabilityIndex(trieWalk);
+        }
+        if (DEBUG_DICT) {
+            AKLOGI("Lookup indices: %d bytes.", getLookupIndicesMemorySize());
+        }
+    }
+    mUnigramDictionary = new UnigramDictionary(mOffsetDict,
+            BinaryFormat::getFlags(mDict, dictSize), mCharGroupLookupIndex,
+            mSupportsDynamicUpdate, getHeaderSize());
+    mBigramDictionary = new BigramDictionary(mOffsetDict, mCharGroupLookupIndex,
+            mParentLinkIndex, mSupportsDynamicUpdate, getHeaderSize());
 }
 
 Dictionary::~Dictionary() {
@@ -49,6 +82,11 @@ Dictionary::~Dictionary() {
     delete mBigramDictionary;
     delete mGestureSuggest;
     delete mTypingSuggest;
+    delete mTraverseSessionPool;
+    delete mCharGroupLookupIndex;
+    delete mParentLinkIndex;
+    delete mSubtreeProbabilityIndex;
+    delete mCacheOptimizedTrie;
 }
 
 int Dictionary::getSuggestions(ProximityInfo *proximityInfo, void *traverseSession,
@@ -56,6 +94,15 @@ int Dictionary::getSuggestions(ProximityInfo *proximityInfo, void *traverseSessi
         int inputSize, int *prevWordCodePoints, int prevWordLength, int commitPoint, bool isGesture,
         bool useFullEditDistance, int *outWords, int *frequencies, int *spaceIndices,
         int *outputTypes) const {
+    if (!traverseSession) {
+        DicTraverseSession *const lentTraverseSession = acquireTraverseSession();
+        const int result = getSuggestions(proximityInfo, lentTraverseSession, xcoordinates,
+                ycoordinates, times, pointerIds, inputCodePoints, inputSize, prevWordCodePoints,
+                prevWordLength, commitPoint, isGesture, useFullEditDistance, outWords,
+                frequencies, spaceIndices, outputTypes);
+        releaseTraverseSession(lentTraverseSession);
+        return result;
+    }
     int result = 0;
     if (isGesture) {
         DicTraverseWrapper::initDicTraverseSession(
@@ -68,7 +115,8 @@ int Dictionary::getSuggestions(ProximityInfo *proximityInfo, void *traverseSessi
         }
         return result;
     } else {
-        if (USE_SUGGEST_INTERFACE_FOR_TYPING) {
+        // The legacy unigram traversal only reads static dictionaries.
+        if (USE_SUGGEST_INTERFACE_FOR_TYPING || mSupportsDynamicUpdate) {
             DicTraverseWrapper::initDicTraverseSession(
                     traverseSession, this, prevWordCodePoints, prevWordLength);
             result = mTypingSuggest->getSuggestions(proximityInfo, traverseSession, xcoordinates,
@@ -91,6 +139,53 @@ int Dictionary::getSuggestions(ProximityInfo *proximityInfo, void *traverseSessi
     }
 }
 
+int Dictionary::getSuggestionsFromDictionaries(const Dictionary *const *additionalDictionaries,
+        int additionalDictionaryCount, const float *weights, ProximityInfo *proximityInfo,
+        void *traverseSession, int *xcoordinates, int *ycoordinates, int *times, int *pointerIds,
+        int *inputCodePoints, int inputSize, int *prevWordCodePoints, int prevWordLength,
+        int commitPoint, bool isGesture, int *outWords, int *frequencies, int *spaceIndices,
+        int *outputTypes, int *outputDictionaryIndices) const {
+    if (!traverseSession) {
+        DicTraverseSession *const lentTraverseSession = acquireTraverseSession();
+        const int result = getSuggestionsFromDictionaries(additionalDictionaries,
+                additionalDictionaryCount, weights, proximityInfo, lentTraverseSession,
+                xcoordinates, ycoordinates, times, pointerIds, inputCodePoints, inputSize,
+                prevWordCodePoints, prevWordLength, commitPoint, isGesture, outWords, frequencies,
+                spaceIndices, outputTypes, outputDictionaryIndices);
+        releaseTraverseSession(lentTraverseSession);
+        return result;
+    }
+    const Dictionary *dictionaries[MAX_SEARCHED_DICTIONARY_COUNT];
+    dictionaries[0] = this;
+    const int dictionaryCount =
+            min(1 + max(0, additionalDictionaryCount), MAX_SEARCHED_DICTIONARY_COUNT);
+    for (int i = 1; i < dictionaryCount; ++i) {
+        dictionaries[i] = additionalDictionaries[i - 1];
+    }
+    DicTraverseSession *const tSession = static_cast<DicTraverseSession *>(traverseSession);
+    tSession->init(dictionaries, weights, dictionaryCount, prevWordCodePoints, prevWordLength);
+    // Only the suggest interface reads several dictionaries at once.
+    const SuggestInterface *const suggest = isGesture ? mGestureSuggest : mTypingSuggest;
+    const int result = suggest->getSuggestions(proximityInfo, traverseSession, xcoordinates,
+            ycoordinates, times, pointerIds, inputCodePoints, inputSize, commitPoint, outWords,
+            frequencies, spaceIndices, outputTypes);
+    for (int i = 0; i < result; ++i) {
+        outputDictionaryIndices[i] = tSession->getOutputDictionaryIndex(i);
+    }
+    if (DEBUG_DICT) {
+        DUMP_RESULT(outWords, frequencies);
+    }
+    return result;
+}
+
+DicTraverseSession *Dictionary::acquireTraverseSession() const {
+    return mTraverseSessionPool->acquire();
+}
+
+void Dictionary::releaseTraverseSession(DicTraverseSession *traverseSession) const {
+    mTraverseSessionPool->release(traverseSession);
+}
+
 int Dictionary::getBigrams(const int *word, int length, int *inputCodePoints, int inputSize,
         int *outWords, int *frequencies, int *outputTypes) const {
     if (length <= 0) return 0;
@@ -110,4 +205,10 @@ int Dictionary::getDictFlags() const {
     return mUnigramDictionary->getDictFlags();
 }
 
+int Dictionary::getLookupIndicesMemorySize() const {
+    return (mCharGroupLookupIndex ? mCharGroupLookupIndex->getMemorySize() : 0)
+            + (mParentLinkIndex ? mParentLinkIndex->getMemorySize() : 0)
+            + (mSubtreeProbabilityIndex ? mSubtreeProbabilityIndex->getMemorySize() : 0);
+}
+
 } // namespace latinime
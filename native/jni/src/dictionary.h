@@ -24,7 +24,13 @@
 namespace latinime {
 
 class BigramDictionary;
+class CacheOptimizedTrie;
+class CharGroupLookupIndex;
+class DicTraverseSession;
+class DicTraverseSessionPool;
+class ParentLinkIndex;
 class ProximityInfo;
+class SubtreeProbabilityIndex;
 class SuggestInterface;
 class UnigramDictionary;
 
@@ -45,18 +51,45 @@ class Dictionary {
     static const int KIND_MASK_FLAGS = 0xFFFFFF00; // Mask to get the flags
     static const int KIND_FLAG_POSSIBLY_OFFENSIVE = 0x80000000;
     static const int KIND_FLAG_EXACT_MATCH = 0x40000000;
+    // The search was stopped by the limits of the session before its end.
+    static const int KIND_FLAG_PARTIAL_RESULT = 0x20000000;
 
-    Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust);
+    // useLookupIndices builds the char group lookup, parent link and subtree probability indices
+    // of a static dictionary. They speed up word lookups and bound the language cost of the
+    // searched prefixes, at the cost of memory and of a walk of the trie at open time. The parent
+    // link index is built even without useLookupIndices when useCacheOptimizedLayout takes effect,
+    // as the rearranged trie cannot be searched for the word at an address without it.
+    Dictionary(void *dict, int dictSize, int mmapFd, int dictBufAdjust,
+            bool useCacheOptimizedLayout, bool useLookupIndices);
 
+    // Searches on a session lent by the pool of the dictionary if traverseSession is null, so that
+    // concurrent callers without a session of their own can share the dictionary.
     int getSuggestions(ProximityInfo *proximityInfo, void *traverseSession, int *xcoordinates,
             int *ycoordinates, int *times, int *pointerIds, int *inputCodePoints, int inputSize,
             int *prevWordCodePoints, int prevWordLength, int commitPoint, bool isGesture,
             bool useFullEditDistance, int *outWords, int *frequencies, int *spaceIndices,
             int *outputTypes) const;
 
+    // Searches this dictionary and additionalDictionaries together, in one search sharing the
+    // input and the queues of dic nodes, up to MAX_SEARCHED_DICTIONARY_COUNT dictionaries in
+    // all. The words of each dictionary get its weight added to their compound distance, this
+    // dictionary coming first in weights. outputDictionaryIndices receives the dictionary of each
+    // suggestion: 0 for this one, i + 1 for additionalDictionaries[i].
+    int getSuggestionsFromDictionaries(const Dictionary *const *additionalDictionaries,
+            int additionalDictionaryCount, const float *weights, ProximityInfo *proximityInfo,
+            void *traverseSession, int *xcoordinates, int *ycoordinates, int *times,
+            int *pointerIds, int *inputCodePoints, int inputSize, int *prevWordCodePoints,
+            int prevWordLength, int commitPoint, bool isGesture, int *outWords, int *frequencies,
+            int *spaceIndices, int *outputTypes, int *outputDictionaryIndices) const;
+
     int getBigrams(const int *word, int length, int *inputCodePoints, int inputSize, int *outWords,
             int *frequencies, int *outputTypes) const;
 
+    // Lends a session of the pool of the dictionary, to give back with releaseTraverseSession().
+    // Both are thread safe and lock free.
+    DicTraverseSession *acquireTraverseSession() const;
+    void releaseTraverseSession(DicTraverseSession *traverseSession) const;
+
     int getProbability(const int *word, int length) const;
     bool isValidBigram(const int *word1, int length1, const int *word2, int length2) const;
     const uint8_t *getDict() const { // required to release dictionary buffer
@@ -68,12 +101,28 @@ class Dictionary {
     int getDictSize() const { return mDictSize; }
     int getMmapFd() const { return mMmapFd; }
     int getDictBufAdjust() const { return mDictBufAdjust; }
+    int getHeaderSize() const { return mHeaderSize; }
+    bool supportsDynamicUpdate() const { return mSupportsDynamicUpdate; }
+    const CharGroupLookupIndex *getCharGroupLookupIndex() const {
+        return mCharGroupLookupIndex;
+    }
+    const ParentLinkIndex *getParentLinkIndex() const {
+        return mParentLinkIndex;
+    }
+    const SubtreeProbabilityIndex *getSubtreeProbabilityIndex() const {
+        return mSubtreeProbabilityIndex;
+    }
     int getDictFlags() const;
+    // Bytes taken by the lookup indices.
+    int getLookupIndicesMemorySize() const;
     virtual ~Dictionary();
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(Dictionary);
     const uint8_t *mDict;
+    const int mHeaderSize;
+    // Rearranged copy of mDict that is read instead of it, or null to read mDict in place.
+    const CacheOptimizedTrie *mCacheOptimizedTrie;
     const uint8_t *mOffsetDict;
 
     // Used only for the mmap version of dictionary loading, but we use these as dummy variables
@@ -81,11 +130,17 @@ class Dictionary {
     const int mDictSize;
     const int mMmapFd;
     const int mDictBufAdjust;
+    const bool mSupportsDynamicUpdate;
+    const int mDictBodySize;
 
+    const CharGroupLookupIndex *mCharGroupLookupIndex;
+    const ParentLinkIndex *mParentLinkIndex;
+    const SubtreeProbabilityIndex *mSubtreeProbabilityIndex;
     const UnigramDictionary *mUnigramDictionary;
     const BigramDictionary *mBigramDictionary;
     SuggestInterface *mGestureSuggest;
     SuggestInterface *mTypingSuggest;
+    DicTraverseSessionPool *mTraverseSessionPool;
 };
 } // namespace latinime
 #endif // LATINIME_DICTIONARY_H
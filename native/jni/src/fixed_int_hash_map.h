@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_FIXED_INT_HASH_MAP_H
+#define LATINIME_FIXED_INT_HASH_MAP_H
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Open addressing hash map from int keys to TValue with linear probing. The slots are stored in
+ * the object itself, so the map never allocates, unlike hash_map_compat that allocates a node per
+ * entry. It is meant for the small maps of the hot paths, like key indices or bigram
+ * probabilities. CAPACITY must be a power of two; once the map is 3/4 full, put() fails and the
+ * caller has to deal with it. S_INT_MIN cannot be used as a key.
+ *
+ * The slots can be iterated as follows, in slot order.
+ *   for (int i = 0; i < map.getSlotCount(); ++i) {
+ *       if (map.isUsedSlotAt(i)) { use(map.getKeyAt(i), map.getValueAt(i)); }
+ *   }
+ */
+template<typename TValue, int CAPACITY>
+class FixedIntHashMap {
+ public:
+    static const int MAX_SIZE = CAPACITY / 4 * 3;
+
+    FixedIntHashMap() : mSlots(), mSize(0) {
+        ASSERT((CAPACITY & (CAPACITY - 1)) == 0);
+        for (int i = 0; i < CAPACITY; ++i) {
+            mSlots[i].mKey = EMPTY_KEY;
+        }
+    }
+
+    // Default copy constructor and assignment are fine: there is no pointer to share.
+
+    int size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+    int getSlotCount() const { return CAPACITY; }
+
+    void clear() {
+        if (mSize == 0) {
+            return;
+        }
+        for (int i = 0; i < CAPACITY; ++i) {
+            mSlots[i].mKey = EMPTY_KEY;
+        }
+        mSize = 0;
+    }
+
+    // Returns a pointer to the value of key, or null if there is none.
+    AK_FORCE_INLINE const TValue *find(const int key) const {
+        const int slot = findSlot(key);
+        return mSlots[slot].mKey == EMPTY_KEY ? 0 : &mSlots[slot].mValue;
+    }
+
+    AK_FORCE_INLINE TValue *find(const int key) {
+        const int slot = findSlot(key);
+        return mSlots[slot].mKey == EMPTY_KEY ? 0 : &mSlots[slot].mValue;
+    }
+
+    // Sets the value of key. Returns false if key is new and the map is full.
+    AK_FORCE_INLINE bool put(const int key, const TValue value) {
+        ASSERT(key != EMPTY_KEY);
+        const int slot = findSlot(key);
+        if (mSlots[slot].mKey == EMPTY_KEY) {
+            if (mSize >= MAX_SIZE) {
+                return false;
+            }
+            mSlots[slot].mKey = key;
+            ++mSize;
+        }
+        mSlots[slot].mValue = value;
+        return true;
+    }
+
+    // Removes key, shifting back the following slots of its probe sequence so that no tombstone
+    // is needed. Returns false if there was no such key.
+    bool erase(const int key) {
+        int emptiedSlot = findSlot(key);
+        if (mSlots[emptiedSlot].mKey == EMPTY_KEY) {
+            return false;
+        }
+        for (int slot = nextSlot(emptiedSlot); mSlots[slot].mKey != EMPTY_KEY;
+                slot = nextSlot(slot)) {
+            // The entry in slot can fill the hole unless its home slot lies cyclically in
+            // (emptiedSlot, slot].
+            const int homeSlot = getHomeSlot(mSlots[slot].mKey);
+            const bool isHomeInRange = emptiedSlot <= slot
+                    ? (emptiedSlot < homeSlot && homeSlot <= slot)
+                    : (emptiedSlot < homeSlot || homeSlot <= slot);
+            if (!isHomeInRange) {
+                mSlots[emptiedSlot] = mSlots[slot];
+                emptiedSlot = slot;
+            }
+        }
+        mSlots[emptiedSlot].mKey = EMPTY_KEY;
+        --mSize;
+        return true;
+    }
+
+    bool isUsedSlotAt(const int slot) const { return mSlots[slot].mKey != EMPTY_KEY; }
+    int getKeyAt(const int slot) const { return mSlots[slot].mKey; }
+    const TValue &getValueAt(const int slot) const { return mSlots[slot].mValue; }
+    TValue &getValueAt(const int slot) { return mSlots[slot].mValue; }
+
+ private:
+    static const int EMPTY_KEY = S_INT_MIN;
+
+    struct Slot {
+        int mKey;
+        TValue mValue;
+    };
+
+    // Keys are their own hash: the keys of these maps, like key indices, code points or
+    // dictionary positions, are spread enough over the low bits. This also makes small key
+    // indices iterate in increasing order.
+    static AK_FORCE_INLINE int getHomeSlot(const int key) {
+        return key & (CAPACITY - 1);
+    }
+
+    static AK_FORCE_INLINE int nextSlot(const int slot) {
+        return (slot + 1) & (CAPACITY - 1);
+    }
+
+    // Returns the slot of key, or the empty slot where it would be inserted. The map is never
+    // full, so the loop always ends.
+    AK_FORCE_INLINE int findSlot(const int key) const {
+        int slot = getHomeSlot(key);
+        while (mSlots[slot].mKey != key && mSlots[slot].mKey != EMPTY_KEY) {
+            slot = nextSlot(slot);
+        }
+        return slot;
+    }
+
+    Slot mSlots[CAPACITY];
+    int mSize;
+};
+} // namespace latinime
+#endif // LATINIME_FIXED_INT_HASH_MAP_H
@@ -22,38 +22,71 @@
 
 #include "defines.h"
 #include "binary_format.h"
-#include "hash_map_compat.h"
+#include "fixed_int_hash_map.h"
 
 namespace latinime {
 
 // Class for caching bigram maps for multiple previous word contexts. This is useful since the
 // algorithm needs to look up the set of bigrams for every word pair that occurs in every
-// multi-word suggestion.
+// multi-word suggestion. All the maps are stored in this object, so caching does not allocate.
 class MultiBigramMap {
  public:
-    MultiBigramMap() : mBigramMaps() {}
+    MultiBigramMap() : mBigramMapIndices(), mBigramMaps(), mBigramMapCount(0) {}
     ~MultiBigramMap() {}
 
     // Look up the bigram probability for the given word pair from the cached bigram maps.
     // Also caches the bigrams if there is space remaining and they have not been cached already.
-    int getBigramProbability(const uint8_t *const dicRoot, const int wordPosition,
-            const int nextWordPosition, const int unigramProbability) {
-        hash_map_compat<int, BigramMap>::const_iterator mapPosition =
-                mBigramMaps.find(wordPosition);
-        if (mapPosition != mBigramMaps.end()) {
-            return mapPosition->second.getBigramProbability(nextWordPosition, unigramProbability);
-        }
-        if (mBigramMaps.size() < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
-            addBigramsForWordPosition(dicRoot, wordPosition);
-            return mBigramMaps[wordPosition].getBigramProbability(
-                    nextWordPosition, unigramProbability);
+    // The words are in dicRoot, the dictionary at dictionaryIndex in the traverse session.
+    int getBigramProbability(const uint8_t *const dicRoot, const bool supportsDynamicUpdate,
+            const int dictionaryIndex, const int wordPosition, const int nextWordPosition,
+            const int unigramProbability) {
+        const int key = getKey(dictionaryIndex, wordPosition);
+        const int *const mapIndex = mBigramMapIndices.find(key);
+        if (mapIndex) {
+            const BigramMap &bigramMap = mBigramMaps[*mapIndex];
+            if (bigramMap.isComplete()) {
+                return bigramMap.getBigramProbability(nextWordPosition, unigramProbability);
+            }
+        } else if (mBigramMapCount < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
+            BigramMap *const bigramMap = &mBigramMaps[mBigramMapCount];
+            mBigramMapIndices.put(key, mBigramMapCount);
+            ++mBigramMapCount;
+            bigramMap->init(dicRoot, supportsDynamicUpdate, wordPosition);
+            if (bigramMap->isComplete()) {
+                return bigramMap->getBigramProbability(nextWordPosition, unigramProbability);
+            }
         }
         return BinaryFormat::getBigramProbability(
-                dicRoot, wordPosition, nextWordPosition, unigramProbability);
+                dicRoot, wordPosition, nextWordPosition, unigramProbability,
+                supportsDynamicUpdate);
+    }
+
+    // Returns the highest probability of a bigram of the given word, or NOT_A_PROBABILITY if it
+    // has none. It is cached with the bigrams of the word.
+    int getMaxBigramProbability(const uint8_t *const dicRoot, const bool supportsDynamicUpdate,
+            const int dictionaryIndex, const int wordPosition) {
+        if (NOT_VALID_WORD == wordPosition) {
+            return NOT_A_PROBABILITY;
+        }
+        const int key = getKey(dictionaryIndex, wordPosition);
+        const int *const mapIndex = mBigramMapIndices.find(key);
+        if (mapIndex) {
+            return mBigramMaps[*mapIndex].getMaxBigramProbability(
+                    dicRoot, supportsDynamicUpdate, wordPosition);
+        } else if (mBigramMapCount < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
+            BigramMap *const bigramMap = &mBigramMaps[mBigramMapCount];
+            mBigramMapIndices.put(key, mBigramMapCount);
+            ++mBigramMapCount;
+            bigramMap->init(dicRoot, supportsDynamicUpdate, wordPosition);
+            return bigramMap->getMaxBigramProbability(
+                    dicRoot, supportsDynamicUpdate, wordPosition);
+        }
+        return BinaryFormat::getMaxBigramProbability(dicRoot, wordPosition, supportsDynamicUpdate);
     }
 
     void clear() {
-        mBigramMaps.clear();
+        mBigramMapIndices.clear();
+        mBigramMapCount = 0;
     }
 
  private:
@@ -61,29 +94,59 @@ class MultiBigramMap {
 
     class BigramMap {
      public:
-        BigramMap() : mBigramMap(DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP) {}
+        BigramMap()
+                : mBigramMap(), mIsComplete(false), mMaxBigramProbability(NOT_A_PROBABILITY),
+                  mHasMaxBigramProbability(false) {}
         ~BigramMap() {}
 
-        void init(const uint8_t *const dicRoot, int position) {
-            BinaryFormat::fillBigramProbabilityToHashMap(dicRoot, position, &mBigramMap);
+        void init(const uint8_t *const dicRoot, const bool supportsDynamicUpdate, int position) {
+            mBigramMap.clear();
+            mIsComplete = BinaryFormat::fillBigramProbabilityToHashMap(
+                    dicRoot, position, supportsDynamicUpdate, &mBigramMap);
+            mHasMaxBigramProbability = false;
         }
 
+        // False if the word has too many bigrams to be cached.
+        bool isComplete() const { return mIsComplete; }
+
         inline int getBigramProbability(const int nextWordPosition, const int unigramProbability)
                 const {
            return BinaryFormat::getBigramProbabilityFromHashMap(
                    nextWordPosition, &mBigramMap, unigramProbability);
         }
 
+        // Only read when the search first needs it.
+        int getMaxBigramProbability(const uint8_t *const dicRoot, const bool supportsDynamicUpdate,
+                const int position) {
+            if (!mHasMaxBigramProbability) {
+                mMaxBigramProbability = BinaryFormat::getMaxBigramProbability(
+                        dicRoot, position, supportsDynamicUpdate);
+                mHasMaxBigramProbability = true;
+            }
+            return mMaxBigramProbability;
+        }
+
      private:
-        // Note: Default copy constructor needed for use in hash_map.
-        hash_map_compat<int, int> mBigramMap;
+        DISALLOW_COPY_AND_ASSIGN(BigramMap);
+
+        BinaryFormat::BigramProbabilityMap mBigramMap;
+        bool mIsComplete;
+        int mMaxBigramProbability;
+        bool mHasMaxBigramProbability;
     };
 
-    void addBigramsForWordPosition(const uint8_t *const dicRoot, const int position) {
-        mBigramMaps[position].init(dicRoot, position);
+    // The same word position can be found in several dictionaries.
+    static int getKey(const int dictionaryIndex, const int wordPosition) {
+        return wordPosition * MAX_SEARCHED_DICTIONARY_COUNT + dictionaryIndex;
     }
 
-    hash_map_compat<int, BigramMap> mBigramMaps;
+    // Power of two with room for MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP indices.
+    static const int BIGRAM_MAP_INDICES_CAPACITY = 64;
+
+    // Index in mBigramMaps of the bigram map of each cached word, by key.
+    FixedIntHashMap<int, BIGRAM_MAP_INDICES_CAPACITY> mBigramMapIndices;
+    BigramMap mBigramMaps[MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP];
+    int mBigramMapCount;
 };
 } // namespace latinime
 #endif // LATINIME_MULTI_BIGRAM_MAP_H
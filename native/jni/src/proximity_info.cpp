@@ -16,6 +16,11 @@
 
 #include <cstring>
 #include <cmath>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #define LOG_TAG "LatinIME: proximity_info.cpp"
 
@@ -70,7 +75,7 @@ ProximityInfo::ProximityInfo(JNIEnv *env, const jstring localeJStr,
                   && sweetSpotCenterYs && sweetSpotRadii),
           mProximityCharsArray(new int[GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE
                   /* proximityCharsLength */]),
-          mCodeToKeyMap() {
+          mCodeToKeyMap(), mMostCommonKeyWidthSquareFloat(0.0f) {
     /* Let's check the input array length here to make sure */
     const jsize proximityCharsLength = env->GetArrayLength(proximityChars);
     if (proximityCharsLength != GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE) {
@@ -134,23 +139,65 @@ bool ProximityInfo::hasSpaceProximity(const int x, const int y) const {
 
 float ProximityInfo::getNormalizedSquaredDistanceFromCenterFloatG(
         const int keyId, const int x, const int y, const float verticalScale) const {
-    const bool correctTouchPosition = hasTouchPositionCorrectionData();
-    const float centerX = static_cast<float>(correctTouchPosition ? getSweetSpotCenterXAt(keyId)
-            : getKeyCenterXOfKeyIdG(keyId));
-    const float visualKeyCenterY = static_cast<float>(getKeyCenterYOfKeyIdG(keyId));
-    float centerY;
-    if (correctTouchPosition) {
-        const float sweetSpotCenterY = static_cast<float>(getSweetSpotCenterYAt(keyId));
-        const float gapY = sweetSpotCenterY - visualKeyCenterY;
-        centerY = visualKeyCenterY + gapY * verticalScale;
-    } else {
-        centerY = visualKeyCenterY;
-    }
+    const float centerY =
+            mVisualKeyCenterYsG[keyId] + mSweetSpotCenterYGapsG[keyId] * verticalScale;
+    return ProximityInfoUtils::getSquaredDistanceFloat(mSweetSpotCenterXsG[keyId], centerY,
+            static_cast<float>(x), static_cast<float>(y)) / mMostCommonKeyWidthSquareFloat;
+}
+
+void ProximityInfo::getNormalizedSquaredDistancesFromCentersG(const int x, const int y,
+        const float verticalScale, float *const normalizedSquaredDistances) const {
     const float touchX = static_cast<float>(x);
     const float touchY = static_cast<float>(y);
-    const float keyWidth = static_cast<float>(getMostCommonKeyWidth());
-    return ProximityInfoUtils::getSquaredDistanceFloat(centerX, centerY, touchX, touchY)
-            / SQUARE_FLOAT(keyWidth);
+    int keyId = 0;
+    // Four keys at a time, with the same operations as the loop below so that the distances
+    // don't depend on the instruction set.
+#if defined(__SSE__)
+    const __m128 touchXs = _mm_set1_ps(touchX);
+    const __m128 touchYs = _mm_set1_ps(touchY);
+    const __m128 verticalScales = _mm_set1_ps(verticalScale);
+    const __m128 keyWidthSquares = _mm_set1_ps(mMostCommonKeyWidthSquareFloat);
+    for (; keyId + 4 <= KEY_COUNT; keyId += 4) {
+        const __m128 centerYs = _mm_add_ps(_mm_loadu_ps(&mVisualKeyCenterYsG[keyId]),
+                _mm_mul_ps(_mm_loadu_ps(&mSweetSpotCenterYGapsG[keyId]), verticalScales));
+        const __m128 deltaXs = _mm_sub_ps(_mm_loadu_ps(&mSweetSpotCenterXsG[keyId]), touchXs);
+        const __m128 deltaYs = _mm_sub_ps(centerYs, touchYs);
+        const __m128 squaredDistances =
+                _mm_add_ps(_mm_mul_ps(deltaXs, deltaXs), _mm_mul_ps(deltaYs, deltaYs));
+        _mm_storeu_ps(&normalizedSquaredDistances[keyId],
+                _mm_div_ps(squaredDistances, keyWidthSquares));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t touchXs = vdupq_n_f32(touchX);
+    const float32x4_t touchYs = vdupq_n_f32(touchY);
+    const float32x4_t verticalScales = vdupq_n_f32(verticalScale);
+    for (; keyId + 4 <= KEY_COUNT; keyId += 4) {
+        // Not vmlaq_f32(), which may be fused.
+        const float32x4_t centerYs = vaddq_f32(vld1q_f32(&mVisualKeyCenterYsG[keyId]),
+                vmulq_f32(vld1q_f32(&mSweetSpotCenterYGapsG[keyId]), verticalScales));
+        const float32x4_t deltaXs = vsubq_f32(vld1q_f32(&mSweetSpotCenterXsG[keyId]), touchXs);
+        const float32x4_t deltaYs = vsubq_f32(centerYs, touchYs);
+        const float32x4_t squaredDistances =
+                vaddq_f32(vmulq_f32(deltaXs, deltaXs), vmulq_f32(deltaYs, deltaYs));
+#if defined(__aarch64__)
+        vst1q_f32(&normalizedSquaredDistances[keyId],
+                vdivq_f32(squaredDistances, vdupq_n_f32(mMostCommonKeyWidthSquareFloat)));
+#else // defined(__aarch64__)
+        // ARMv7 NEON only has approximate reciprocals: divide one key at a time.
+        vst1q_f32(&normalizedSquaredDistances[keyId], squaredDistances);
+        for (int i = keyId; i < keyId + 4; ++i) {
+            normalizedSquaredDistances[i] /= mMostCommonKeyWidthSquareFloat;
+        }
+#endif // defined(__aarch64__)
+    }
+#endif
+    for (; keyId < KEY_COUNT; ++keyId) {
+        const float centerY =
+                mVisualKeyCenterYsG[keyId] + mSweetSpotCenterYGapsG[keyId] * verticalScale;
+        normalizedSquaredDistances[keyId] = ProximityInfoUtils::getSquaredDistanceFloat(
+                mSweetSpotCenterXsG[keyId], centerY, touchX, touchY)
+                        / mMostCommonKeyWidthSquareFloat;
+    }
 }
 
 int ProximityInfo::getCodePointOf(const int keyIndex) const {
@@ -167,9 +214,26 @@ void ProximityInfo::initializeG() {
         const int lowerCode = toLowerCase(code);
         mCenterXsG[i] = mKeyXCoordinates[i] + mKeyWidths[i] / 2;
         mCenterYsG[i] = mKeyYCoordinates[i] + mKeyHeights[i] / 2;
-        mCodeToKeyMap[lowerCode] = i;
+        mCodeToKeyMap.put(lowerCode, i);
         mKeyIndexToCodePointG[i] = lowerCode;
     }
+    const bool correctTouchPosition = hasTouchPositionCorrectionData();
+    for (int i = 0; i < KEY_COUNT; ++i) {
+        mSweetSpotCenterXsG[i] = correctTouchPosition
+                ? getSweetSpotCenterXAt(i) : static_cast<float>(mCenterXsG[i]);
+        mVisualKeyCenterYsG[i] = static_cast<float>(mCenterYsG[i]);
+        mSweetSpotCenterYGapsG[i] =
+                correctTouchPosition ? getSweetSpotCenterYAt(i) - mVisualKeyCenterYsG[i] : 0.0f;
+    }
+    mMostCommonKeyWidthSquareFloat = SQUARE_FLOAT(static_cast<float>(MOST_COMMON_KEY_WIDTH));
+    for (int i = 0; i < KEY_COUNT; ++i) {
+        mSameCodePointKeyIdsG[i].reset();
+        for (int j = 0; j < KEY_COUNT; ++j) {
+            if (mKeyIndexToCodePointG[j] == mKeyIndexToCodePointG[i]) {
+                mSameCodePointKeyIdsG[i].set(j);
+            }
+        }
+    }
     for (int i = 0; i < KEY_COUNT; i++) {
         mKeyKeyDistancesG[i][i] = 0;
         for (int j = i + 1; j < KEY_COUNT; j++) {
@@ -17,8 +17,9 @@
 #ifndef LATINIME_PROXIMITY_INFO_H
 #define LATINIME_PROXIMITY_INFO_H
 
+#include <bitset>
+
 #include "defines.h"
-#include "hash_map_compat.h"
 #include "jni.h"
 #include "proximity_info_utils.h"
 
@@ -41,6 +42,10 @@ class ProximityInfo {
     float getNormalizedSquaredDistanceFromCenterFloatG(
             const int keyId, const int x, const int y,
             const float verticalScale) const;
+    // Computes getNormalizedSquaredDistanceFromCenterFloatG() for all the keys at once into
+    // normalizedSquaredDistances, indexed by key id.
+    void getNormalizedSquaredDistancesFromCentersG(const int x, const int y,
+            const float verticalScale, float *const normalizedSquaredDistances) const;
     bool sameAsTyped(const unsigned short *word, int length) const;
     int getCodePointOf(const int keyIndex) const;
     bool hasSweetSpotData(const int keyIndex) const {
@@ -91,6 +96,13 @@ class ProximityInfo {
         return getKeyIndexOf(codePoint) != NOT_AN_INDEX;
     }
 
+    // Returns whether keyIds, a set of key ids, has a key of codePoint.
+    AK_FORCE_INLINE bool hasKeyOfCodePoint(const std::bitset<MAX_KEY_COUNT_IN_A_KEYBOARD> &keyIds,
+            const int codePoint) const {
+        const int keyIndex = getKeyIndexOf(codePoint);
+        return keyIndex != NOT_AN_INDEX && (keyIds & mSameCodePointKeyIdsG[keyIndex]).any();
+    }
+
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityInfo);
 
@@ -121,12 +133,22 @@ class ProximityInfo {
     float mSweetSpotCenterXs[MAX_KEY_COUNT_IN_A_KEYBOARD];
     float mSweetSpotCenterYs[MAX_KEY_COUNT_IN_A_KEYBOARD];
     float mSweetSpotRadii[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    hash_map_compat<int, int> mCodeToKeyMap;
+    ProximityInfoUtils::CodeToKeyMap mCodeToKeyMap;
 
     int mKeyIndexToCodePointG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mCenterXsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mCenterYsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mKeyKeyDistancesG[MAX_KEY_COUNT_IN_A_KEYBOARD][MAX_KEY_COUNT_IN_A_KEYBOARD];
+    // The centers the touch points are measured from, computed once per keyboard. The vertical
+    // center is mVisualKeyCenterYsG + mSweetSpotCenterYGapsG * verticalScale, the gap being 0
+    // without touch position correction data.
+    float mSweetSpotCenterXsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
+    float mVisualKeyCenterYsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
+    float mSweetSpotCenterYGapsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
+    float mMostCommonKeyWidthSquareFloat;
+    // The ids of the keys that have the same code point as each key, as a few keyboards have
+    // several keys of a code point.
+    std::bitset<MAX_KEY_COUNT_IN_A_KEYBOARD> mSameCodePointKeyIdsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     // TODO: move to correction.h
 };
 } // namespace latinime
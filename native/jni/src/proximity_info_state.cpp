@@ -34,10 +34,19 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
         const int *const xCoordinates, const int *const yCoordinates, const int *const times,
         const int *const pointerIds, const bool isGeometric) {
     ASSERT(isGeometric || (inputSize < MAX_WORD_LENGTH));
-    mIsContinuousSuggestionPossible =
-            ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
-                    inputSize, xCoordinates, yCoordinates, times, mSampledInputSize,
-                    &mSampledInputXs, &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+    mSharedSampledInputSize = ProximityInfoStateUtils::getSharedSampledInputSize(
+            inputSize, xCoordinates, yCoordinates, times, mSampledInputSize, &mSampledInputXs,
+            &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+    if (!isGeometric && pointerId == 0) {
+        // Points without coordinates only differ by their code points.
+        for (int i = 0; i < mSharedSampledInputSize; ++i) {
+            if (inputCodes[i] != mPrimaryInputWord[i]) {
+                mSharedSampledInputSize = i;
+                break;
+            }
+        }
+    }
+    mIsContinuousSuggestionPossible = mSharedSampledInputSize == mSampledInputSize;
     if (DEBUG_DICT) {
         AKLOGI("isContinuousSuggestionPossible = %s",
                 (mIsContinuousSuggestionPossible ? "true" : "false"));
@@ -85,8 +94,10 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
         mSampledNearKeySets.clear();
         mSampledSearchKeySets.clear();
         mSpeedRates.clear();
-        mBeelineSpeedPercentiles.clear();
+        mBeelineSpeeds.clear();
         mCharProbabilities.clear();
+        mMostProbableStringLengths.clear();
+        mMostProbableStringLogProbabilities.clear();
         mDirections.clear();
     }
 
@@ -113,10 +124,10 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
                 yCoordinates, times, lastSavedInputSize, mSampledInputSize, &mSampledInputXs,
                 &mSampledInputYs, &mSampledTimes, &mSampledLengthCache, &mSampledInputIndice,
                 &mSpeedRates, &mDirections);
-        ProximityInfoStateUtils::refreshBeelineSpeedRates(mProximityInfo->getMostCommonKeyWidth(),
-                mAverageSpeed, inputSize, xCoordinates, yCoordinates, times, mSampledInputSize,
-                &mSampledInputXs, &mSampledInputYs, &mSampledInputIndice,
-                &mBeelineSpeedPercentiles);
+        ProximityInfoStateUtils::refreshBeelineSpeeds(mProximityInfo->getMostCommonKeyWidth(),
+                inputSize, xCoordinates, yCoordinates, times, lastSavedInputSize,
+                mSampledInputSize, &mSampledInputXs, &mSampledInputYs, &mSampledInputIndice,
+                &mBeelineSpeeds);
     }
 
     if (mSampledInputSize > 0) {
@@ -133,10 +144,11 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
                     &mCharProbabilities);
             ProximityInfoStateUtils::updateSampledSearchKeySets(mProximityInfo,
                     mSampledInputSize, lastSavedInputSize, &mSampledLengthCache,
-                    &mSampledNearKeySets, &mSampledSearchKeySets,
-                    &mSampledSearchKeyVectors);
+                    &mSampledNearKeySets, &mSampledSearchKeySets);
             mMostProbableStringProbability = ProximityInfoStateUtils::getMostProbableString(
-                    mProximityInfo, mSampledInputSize, &mCharProbabilities, mMostProbableString);
+                    mProximityInfo, mSampledInputSize, lastSavedInputSize, &mCharProbabilities,
+                    &mMostProbableStringLengths, &mMostProbableStringLogProbabilities,
+                    mMostProbableString);
 
         }
     }
@@ -144,7 +156,7 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
     if (DEBUG_SAMPLING_POINTS) {
         ProximityInfoStateUtils::dump(isGeometric, inputSize, xCoordinates, yCoordinates,
                 mSampledInputSize, &mSampledInputXs, &mSampledInputYs, &mSampledTimes, &mSpeedRates,
-                &mBeelineSpeedPercentiles);
+                mAverageSpeed, &mBeelineSpeeds);
     }
     // end
     ///////////////////////
@@ -258,11 +270,10 @@ ProximityType ProximityInfoState::getProximityTypeG(const int index, const int c
     }
     const int lowerCodePoint = toLowerCase(codePoint);
     const int baseLowerCodePoint = toBaseCodePoint(lowerCodePoint);
-    for (int i = 0; i < static_cast<int>(mSampledSearchKeyVectors[index].size()); ++i) {
-        if (mSampledSearchKeyVectors[index][i] == lowerCodePoint
-                || mSampledSearchKeyVectors[index][i] == baseLowerCodePoint) {
-            return MATCH_CHAR;
-        }
+    const ProximityInfoStateUtils::NearKeycodesSet &searchKeySet = mSampledSearchKeySets[index];
+    if (mProximityInfo->hasKeyOfCodePoint(searchKeySet, lowerCodePoint)
+            || mProximityInfo->hasKeyOfCodePoint(searchKeySet, baseLowerCodePoint)) {
+        return MATCH_CHAR;
     }
     return UNRELATED_CHAR;
 }
@@ -310,10 +321,8 @@ bool ProximityInfoState::hasSpaceProximity(const int index) const {
 // Returns a probability of mapping index to keyIndex.
 float ProximityInfoState::getProbability(const int index, const int keyIndex) const {
     ASSERT(0 <= index && index < mSampledInputSize);
-    hash_map_compat<int, float>::const_iterator it = mCharProbabilities[index].find(keyIndex);
-    if (it != mCharProbabilities[index].end()) {
-        return it->second;
-    }
-    return static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
+    ASSERT(NOT_AN_INDEX <= keyIndex && keyIndex < mKeyCount);
+    return mCharProbabilities[
+            ProximityInfoStateUtils::getCharProbabilityIndex(mKeyCount, index, keyIndex)];
 }
 } // namespace latinime
@@ -22,7 +22,6 @@
 
 #include "char_utils.h"
 #include "defines.h"
-#include "hash_map_compat.h"
 #include "proximity_info_params.h"
 #include "proximity_info_state_utils.h"
 
@@ -47,11 +46,13 @@ class ProximityInfoState {
             : mProximityInfo(0), mMaxPointToKeyLength(0.0f), mAverageSpeed(0.0f),
               mHasTouchPositionCorrectionData(false), mMostCommonKeyWidthSquare(0),
               mKeyCount(0), mCellHeight(0), mCellWidth(0), mGridHeight(0), mGridWidth(0),
-              mIsContinuousSuggestionPossible(false), mSampledInputXs(), mSampledInputYs(),
+              mSharedSampledInputSize(0), mIsContinuousSuggestionPossible(false),
+              mSampledInputXs(), mSampledInputYs(),
               mSampledTimes(), mSampledInputIndice(), mSampledLengthCache(),
-              mBeelineSpeedPercentiles(), mSampledNormalizedSquaredLengthCache(), mSpeedRates(),
+              mBeelineSpeeds(), mSampledNormalizedSquaredLengthCache(), mSpeedRates(),
               mDirections(), mCharProbabilities(), mSampledNearKeySets(), mSampledSearchKeySets(),
-              mSampledSearchKeyVectors(), mTouchPositionCorrectionEnabled(false),
+              mMostProbableStringLengths(), mMostProbableStringLogProbabilities(),
+              mTouchPositionCorrectionEnabled(false),
               mSampledInputSize(0), mMostProbableStringProbability(0.0f) {
         memset(mInputProximities, 0, sizeof(mInputProximities));
         memset(mNormalizedSquaredDistances, 0, sizeof(mNormalizedSquaredDistances));
@@ -143,6 +144,11 @@ class ProximityInfoState {
         return mSampledLengthCache[index];
     }
 
+    // The number of leading sampled points that the input shares with the previous one
+    int getSharedSampledInputSize() const {
+        return mSharedSampledInputSize;
+    }
+
     bool isContinuousSuggestionPossible() const {
         return mIsContinuousSuggestionPossible;
     }
@@ -157,8 +163,9 @@ class ProximityInfoState {
 
     ProximityType getProximityTypeG(const int index, const int codePoint) const;
 
-    const std::vector<int> *getSearchKeyVector(const int index) const {
-        return &mSampledSearchKeyVectors[index];
+    // The ids of the keys to search from the index-th sampled point.
+    const ProximityInfoStateUtils::NearKeycodesSet *getSearchKeySet(const int index) const {
+        return &mSampledSearchKeySets[index];
     }
 
     float getSpeedRate(const int index) const {
@@ -166,7 +173,8 @@ class ProximityInfoState {
     }
 
     AK_FORCE_INLINE int getBeelineSpeedPercentile(const int id) const {
-        return mBeelineSpeedPercentiles[id];
+        return ProximityInfoStateUtils::getBeelineSpeedPercentile(
+                mAverageSpeed, mBeelineSpeeds[id]);
     }
 
     AK_FORCE_INLINE DoubleLetterLevel getDoubleLetterLevel(const int id) const {
@@ -225,6 +233,7 @@ class ProximityInfoState {
     int mCellWidth;
     int mGridHeight;
     int mGridWidth;
+    int mSharedSampledInputSize;
     bool mIsContinuousSuggestionPossible;
 
     std::vector<int> mSampledInputXs;
@@ -232,12 +241,13 @@ class ProximityInfoState {
     std::vector<int> mSampledTimes;
     std::vector<int> mSampledInputIndice;
     std::vector<int> mSampledLengthCache;
-    std::vector<int> mBeelineSpeedPercentiles;
+    std::vector<ProximityInfoStateUtils::BeelineSpeed> mBeelineSpeeds;
     std::vector<float> mSampledNormalizedSquaredLengthCache;
     std::vector<float> mSpeedRates;
     std::vector<float> mDirections;
     // probabilities of skipping or mapping to a key for each point.
-    std::vector<hash_map_compat<int, float> > mCharProbabilities;
+    // Laid out as described at ProximityInfoStateUtils::getCharProbabilityIndex().
+    std::vector<float> mCharProbabilities;
     // The vector for the key code set which holds nearby keys for each sampled input point
     // 1. Used to calculate the probability of the key
     // 2. Used to calculate mSampledSearchKeySets
@@ -247,7 +257,10 @@ class ProximityInfoState {
     // the dictionary. Specifically, currently we are looking for keys nearby trailing sampled
     // inputs including the current input point.
     std::vector<ProximityInfoStateUtils::NearKeycodesSet> mSampledSearchKeySets;
-    std::vector<std::vector<int> > mSampledSearchKeyVectors;
+    // The length and the log probability of mMostProbableString before each sampled input point,
+    // from which ProximityInfoStateUtils::getMostProbableString() resumes.
+    std::vector<int> mMostProbableStringLengths;
+    std::vector<float> mMostProbableStringLogProbabilities;
     bool mTouchPositionCorrectionEnabled;
     int mInputProximities[MAX_PROXIMITY_CHARS_SIZE * MAX_WORD_LENGTH];
     int mNormalizedSquaredDistances[MAX_PROXIMITY_CHARS_SIZE * MAX_WORD_LENGTH];
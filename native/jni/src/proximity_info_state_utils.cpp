@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm> // for std::fill()
 #include <cmath>
 #include <cstring> // for memset()
 #include <sstream> // for debug prints
@@ -232,15 +233,12 @@ namespace latinime {
     sampledNormalizedSquaredLengthCache->resize(sampledInputSize * keyCount);
     for (int i = lastSavedInputSize; i < sampledInputSize; ++i) {
         (*sampledNearKeySets)[i].reset();
+        float *const normalizedSquaredDistances = &(*sampledNormalizedSquaredLengthCache)[
+                i * keyCount];
+        proximityInfo->getNormalizedSquaredDistancesFromCentersG((*sampledInputXs)[i],
+                (*sampledInputYs)[i], verticalSweetSpotScale, normalizedSquaredDistances);
         for (int k = 0; k < keyCount; ++k) {
-            const int index = i * keyCount + k;
-            const int x = (*sampledInputXs)[i];
-            const int y = (*sampledInputYs)[i];
-            const float normalizedSquaredDistance =
-                    proximityInfo->getNormalizedSquaredDistanceFromCenterFloatG(
-                            k, x, y, verticalSweetSpotScale);
-            (*sampledNormalizedSquaredLengthCache)[index] = normalizedSquaredDistance;
-            if (normalizedSquaredDistance
+            if (normalizedSquaredDistances[k]
                     < ProximityInfoParams::NEAR_KEY_NORMALIZED_SQUARED_THRESHOLD) {
                 (*sampledNearKeySets)[i][k] = true;
             }
@@ -317,20 +315,25 @@ namespace latinime {
     return averageSpeed;
 }
 
-/* static */ void ProximityInfoStateUtils::refreshBeelineSpeedRates(const int mostCommonKeyWidth,
-        const float averageSpeed, const int inputSize, const int *const xCoordinates,
-        const int *const yCoordinates, const int *times, const int sampledInputSize,
+// Updates the beeline speeds of the points from lastSavedInputSize, and the ones of the saved
+// points that looked up the last input point, which may have moved since.
+/* static */ void ProximityInfoStateUtils::refreshBeelineSpeeds(const int mostCommonKeyWidth,
+        const int inputSize, const int *const xCoordinates, const int *const yCoordinates,
+        const int *times, const int lastSavedInputSize, const int sampledInputSize,
         const std::vector<int> *const sampledInputXs,
         const std::vector<int> *const sampledInputYs, const std::vector<int> *const inputIndice,
-        std::vector<int> *beelineSpeedPercentiles) {
+        std::vector<BeelineSpeed> *beelineSpeeds) {
     if (DEBUG_SAMPLING_POINTS) {
-        AKLOGI("--- refresh beeline speed rates");
+        AKLOGI("--- refresh beeline speeds");
     }
-    beelineSpeedPercentiles->resize(sampledInputSize);
+    const int savedSize = min(lastSavedInputSize, static_cast<int>(beelineSpeeds->size()));
+    beelineSpeeds->resize(sampledInputSize);
     for (int i = 0; i < sampledInputSize; ++i) {
-        (*beelineSpeedPercentiles)[i] = static_cast<int>(calculateBeelineSpeedRate(
-                mostCommonKeyWidth, averageSpeed, i, inputSize, xCoordinates, yCoordinates, times,
-                sampledInputSize, sampledInputXs, sampledInputYs, inputIndice) * MAX_PERCENTILE);
+        if (i < savedSize && !(*beelineSpeeds)[i].mReachesLastInputPoint) {
+            continue;
+        }
+        (*beelineSpeeds)[i] = calculateBeelineSpeed(mostCommonKeyWidth, i, inputSize,
+                xCoordinates, yCoordinates, times, sampledInputXs, sampledInputYs, inputIndice);
     }
 }
 
@@ -360,10 +363,12 @@ namespace latinime {
         NearKeysDistanceMap *const currentNearKeysDistances) {
     currentNearKeysDistances->clear();
     const int keyCount = proximityInfo->getKeyCount();
+    float normalizedSquaredDistances[MAX_KEY_COUNT_IN_A_KEYBOARD];
+    proximityInfo->getNormalizedSquaredDistancesFromCentersG(x, y, verticalSweetspotScale,
+            normalizedSquaredDistances);
     float nearestKeyDistance = maxPointToKeyLength;
     for (int k = 0; k < keyCount; ++k) {
-        const float dist = proximityInfo->getNormalizedSquaredDistanceFromCenterFloatG(k, x, y,
-                verticalSweetspotScale);
+        const float dist = normalizedSquaredDistances[k];
         if (dist < ProximityInfoParams::NEAR_KEY_THRESHOLD_FOR_DISTANCE) {
             currentNearKeysDistances->insert(std::pair<int, float>(k, dist));
         }
@@ -515,19 +520,12 @@ namespace latinime {
     return popped;
 }
 
-/* static */ float ProximityInfoStateUtils::calculateBeelineSpeedRate(const int mostCommonKeyWidth,
-        const float averageSpeed, const int id, const int inputSize, const int *const xCoordinates,
-        const int *const yCoordinates, const int *times, const int sampledInputSize,
+/* static */ ProximityInfoStateUtils::BeelineSpeed ProximityInfoStateUtils::calculateBeelineSpeed(
+        const int mostCommonKeyWidth, const int id, const int inputSize,
+        const int *const xCoordinates, const int *const yCoordinates, const int *times,
         const std::vector<int> *const sampledInputXs,
         const std::vector<int> *const sampledInputYs,
         const std::vector<int> *const sampledInputIndices) {
-    if (sampledInputSize <= 0 || averageSpeed < 0.001f) {
-        if (DEBUG_SAMPLING_POINTS) {
-            AKLOGI("--- invalid state: cancel. size = %d, ave = %f",
-                    sampledInputSize, averageSpeed);
-        }
-        return 1.0f;
-    }
     const int lookupRadius = mostCommonKeyWidth
             * ProximityInfoParams::LOOKUP_RADIUS_PERCENTILE / MAX_PERCENTILE;
     const int x0 = (*sampledInputXs)[id];
@@ -555,6 +553,7 @@ namespace latinime {
         ++end;
         tempBeelineDistance = getDistanceInt(x0, y0, xCoordinates[end], yCoordinates[end]);
     }
+    BeelineSpeed beelineSpeed = { 1.0f, 0.0f, end == (inputSize - 1) };
     // Exclusive unless this is an edge point
     if (end > actualInputIndex && end < (inputSize - 1)) {
         --end;
@@ -564,7 +563,7 @@ namespace latinime {
         if (DEBUG_DOUBLE_LETTER) {
             AKLOGI("--- double letter: start == end %d", start);
         }
-        return 1.0f;
+        return beelineSpeed;
     }
 
     const int x2 = xCoordinates[start];
@@ -582,23 +581,23 @@ namespace latinime {
     }
     const int time = adjustedEndTime - adjustedStartTime;
     if (time <= 0) {
-        return 1.0f;
+        return beelineSpeed;
     }
 
     if (time >= ProximityInfoParams::STRONG_DOUBLE_LETTER_TIME_MILLIS){
-        return 0.0f;
+        beelineSpeed.mFixedRate = 0.0f;
+        return beelineSpeed;
     }
     if (DEBUG_DOUBLE_LETTER) {
         AKLOGI("--- (%d, %d) double letter: start = %d, end = %d, dist = %d, time = %d,"
-                " speed = %f, ave = %f, val = %f, start time = %d, end time = %d",
+                " speed = %f, start time = %d, end time = %d",
                 id, (*sampledInputIndices)[id], start, end, beelineDistance, time,
-                (static_cast<float>(beelineDistance) / static_cast<float>(time)), averageSpeed,
-                ((static_cast<float>(beelineDistance) / static_cast<float>(time))
-                        / averageSpeed), adjustedStartTime, adjustedEndTime);
+                (static_cast<float>(beelineDistance) / static_cast<float>(time)),
+                adjustedStartTime, adjustedEndTime);
     }
-    // Offset 1%
-    // TODO: Detect double letter more smartly
-    return 0.01f + static_cast<float>(beelineDistance) / static_cast<float>(time) / averageSpeed;
+    beelineSpeed.mFixedRate = -1.0f;
+    beelineSpeed.mSpeed = static_cast<float>(beelineDistance) / static_cast<float>(time);
+    return beelineSpeed;
 }
 
 /* static */ float ProximityInfoStateUtils::getPointAngle(
@@ -662,12 +661,15 @@ namespace latinime {
         const std::vector<int> *const sampledLengthCache,
         const std::vector<float> *const sampledNormalizedSquaredLengthCache,
         std::vector<NearKeycodesSet> *sampledNearKeySets,
-        std::vector<hash_map_compat<int, float> > *charProbabilities) {
-    charProbabilities->resize(sampledInputSize);
+        std::vector<float> *charProbabilities) {
+    const float farKeyProbability = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
+    charProbabilities->resize(sampledInputSize * (keyCount + 1));
     // Calculates probabilities of using a point as a correlated point with the character
     // for each point.
     for (int i = start; i < sampledInputSize; ++i) {
-        (*charProbabilities)[i].clear();
+        float *const probabilities =
+                &(*charProbabilities)[getCharProbabilityIndex(keyCount, i, NOT_AN_INDEX)];
+        std::fill(probabilities + 1, probabilities + 1 + keyCount, farKeyProbability);
         // First, calculates skip probability. Starts from MAX_SKIP_PROBABILITY.
         // Note that all values that are multiplied to this probability should be in [0.0, 1.0];
         float skipProbability = ProximityInfoParams::MAX_SKIP_PROBABILITY;
@@ -738,7 +740,7 @@ namespace latinime {
         // probabilities must be in [0.0, ProximityInfoParams::MAX_SKIP_PROBABILITY];
         ASSERT(skipProbability >= 0.0f);
         ASSERT(skipProbability <= ProximityInfoParams::MAX_SKIP_PROBABILITY);
-        (*charProbabilities)[i][NOT_AN_INDEX] = skipProbability;
+        probabilities[NOT_AN_INDEX + 1] = skipProbability;
 
         // Second, calculates key probabilities by dividing the rest probability
         // (1.0f - skipProbability).
@@ -829,7 +831,7 @@ namespace latinime {
                 const float probabilityDensity = distribution.getProbabilityDensity(distance);
                 const float probability = inputCharProbability * probabilityDensity
                         / sumOfProbabilityDensities;
-                (*charProbabilities)[i][j] = probability;
+                probabilities[j + 1] = probability;
             }
         }
     }
@@ -842,22 +844,22 @@ namespace latinime {
             sstream << "Speed: "<< (*sampledSpeedRates)[i] << ", ";
             sstream << "Angle: "<< getPointAngle(sampledInputXs, sampledInputYs, i) << ", \n";
 
-            for (hash_map_compat<int, float>::iterator it = (*charProbabilities)[i].begin();
-                    it != (*charProbabilities)[i].end(); ++it) {
-                if (it->first == NOT_AN_INDEX) {
-                    sstream << it->first
-                            << "(skip):"
-                            << it->second
-                            << "\n";
-                } else {
-                    sstream << it->first
+            const float *const probabilities =
+                    &(*charProbabilities)[getCharProbabilityIndex(keyCount, i, NOT_AN_INDEX)];
+            for (int j = 0; j < keyCount; ++j) {
+                if (probabilities[j + 1] < farKeyProbability) {
+                    sstream << j
                             << "("
-                            //<< static_cast<char>(mProximityInfo->getCodePointOf(it->first))
+                            //<< static_cast<char>(mProximityInfo->getCodePointOf(j))
                             << "):"
-                            << it->second
+                            << probabilities[j + 1]
                             << "\n";
                 }
             }
+            sstream << NOT_AN_INDEX
+                    << "(skip):"
+                    << probabilities[NOT_AN_INDEX + 1]
+                    << "\n";
             AKLOGI("%s", sstream.str().c_str());
         }
     }
@@ -867,14 +869,14 @@ namespace latinime {
     for (int i = max(start, 1); i < sampledInputSize; ++i) {
         for (int j = i + 1; j < sampledInputSize; ++j) {
             if (!suppressCharProbabilities(
-                    mostCommonKeyWidth, sampledInputSize, sampledLengthCache, i, j,
+                    mostCommonKeyWidth, keyCount, sampledInputSize, sampledLengthCache, i, j,
                     charProbabilities)) {
                 break;
             }
         }
         for (int j = i - 1; j >= max(start, 0); --j) {
             if (!suppressCharProbabilities(
-                    mostCommonKeyWidth, sampledInputSize, sampledLengthCache, i, j,
+                    mostCommonKeyWidth, keyCount, sampledInputSize, sampledLengthCache, i, j,
                     charProbabilities)) {
                 break;
             }
@@ -883,19 +885,21 @@ namespace latinime {
 
     // Converting from raw probabilities to log probabilities to calculate spatial distance.
     for (int i = start; i < sampledInputSize; ++i) {
+        float *const probabilities =
+                &(*charProbabilities)[getCharProbabilityIndex(keyCount, i, NOT_AN_INDEX)];
         for (int j = 0; j < keyCount; ++j) {
-            hash_map_compat<int, float>::iterator it = (*charProbabilities)[i].find(j);
-            if (it == (*charProbabilities)[i].end()){
+            float *const probability = &probabilities[j + 1];
+            if (*probability >= farKeyProbability) {
                 (*sampledNearKeySets)[i].reset(j);
-            } else if(it->second < ProximityInfoParams::MIN_PROBABILITY) {
+            } else if(*probability < ProximityInfoParams::MIN_PROBABILITY) {
                 // Erases from near keys vector because it has very low probability.
                 (*sampledNearKeySets)[i].reset(j);
-                (*charProbabilities)[i].erase(j);
+                *probability = farKeyProbability;
             } else {
-                it->second = -logf(it->second);
+                *probability = -logf(*probability);
             }
         }
-        (*charProbabilities)[i][NOT_AN_INDEX] = -logf((*charProbabilities)[i][NOT_AN_INDEX]);
+        probabilities[NOT_AN_INDEX + 1] = -logf(probabilities[NOT_AN_INDEX + 1]);
     }
 }
 
@@ -904,14 +908,21 @@ namespace latinime {
         const int lastSavedInputSize,
         const std::vector<int> *const sampledLengthCache,
         const std::vector<NearKeycodesSet> *const sampledNearKeySets,
-        std::vector<NearKeycodesSet> *sampledSearchKeySets,
-        std::vector<std::vector<int> > *sampledSearchKeyVectors) {
+        std::vector<NearKeycodesSet> *sampledSearchKeySets) {
     sampledSearchKeySets->resize(sampledInputSize);
-    sampledSearchKeyVectors->resize(sampledInputSize);
     const int readForwordLength = static_cast<int>(
             hypotf(proximityInfo->getKeyboardWidth(), proximityInfo->getKeyboardHeight())
                     * ProximityInfoParams::SEARCH_KEY_RADIUS_RATIO);
-    for (int i = 0; i < sampledInputSize; ++i) {
+    // The lengths only grow along the points, so the saved points that are too far behind the
+    // new ones to search their keys are the leading ones.
+    int start = lastSavedInputSize;
+    if (lastSavedInputSize < sampledInputSize) {
+        while (start > 0 && (*sampledLengthCache)[lastSavedInputSize]
+                - (*sampledLengthCache)[start - 1] < readForwordLength) {
+            --start;
+        }
+    }
+    for (int i = start; i < sampledInputSize; ++i) {
         if (i >= lastSavedInputSize) {
             (*sampledSearchKeySets)[i].reset();
         }
@@ -923,28 +934,13 @@ namespace latinime {
             (*sampledSearchKeySets)[i] |= (*sampledNearKeySets)[j];
         }
     }
-    const int keyCount = proximityInfo->getKeyCount();
-    for (int i = 0; i < sampledInputSize; ++i) {
-        std::vector<int> *searchKeyVector = &(*sampledSearchKeyVectors)[i];
-        searchKeyVector->clear();
-        for (int j = 0; j < keyCount; ++j) {
-            if ((*sampledSearchKeySets)[i].test(j)) {
-                const int keyCodePoint = proximityInfo->getCodePointOf(j);
-                if (std::find(searchKeyVector->begin(), searchKeyVector->end(), keyCodePoint)
-                        == searchKeyVector->end()) {
-                    searchKeyVector->push_back(keyCodePoint);
-                }
-            }
-        }
-    }
 }
 
 // Decreases char probabilities of index0 by checking probabilities of a near point (index1) and
 // increases char probabilities of index1 by checking probabilities of index0.
 /* static */ bool ProximityInfoStateUtils::suppressCharProbabilities(const int mostCommonKeyWidth,
-        const int sampledInputSize, const std::vector<int> *const lengthCache,
-        const int index0, const int index1,
-        std::vector<hash_map_compat<int, float> > *charProbabilities) {
+        const int keyCount, const int sampledInputSize, const std::vector<int> *const lengthCache,
+        const int index0, const int index1, std::vector<float> *charProbabilities) {
     ASSERT(0 <= index0 && index0 < sampledInputSize);
     ASSERT(0 <= index1 && index1 < sampledInputSize);
     const float keyWidthFloat = static_cast<float>(mostCommonKeyWidth);
@@ -955,77 +951,105 @@ namespace latinime {
     const float suppressionRate = ProximityInfoParams::MIN_SUPPRESSION_RATE
             + diff / keyWidthFloat / ProximityInfoParams::SUPPRESSION_LENGTH_WEIGHT
                     * ProximityInfoParams::SUPPRESSION_WEIGHT;
-    for (hash_map_compat<int, float>::iterator it = (*charProbabilities)[index0].begin();
-            it != (*charProbabilities)[index0].end(); ++it) {
-        hash_map_compat<int, float>::iterator it2 =  (*charProbabilities)[index1].find(it->first);
-        if (it2 != (*charProbabilities)[index1].end() && it->second < it2->second) {
-            const float newProbability = it->second * suppressionRate;
-            const float suppression = it->second - newProbability;
-            it->second = newProbability;
-            // mCharProbabilities[index0][NOT_AN_INDEX] is the probability of skipping this point.
-            (*charProbabilities)[index0][NOT_AN_INDEX] += suppression;
+    const float farKeyProbability = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
+    float *const probabilities0 =
+            &(*charProbabilities)[getCharProbabilityIndex(keyCount, index0, NOT_AN_INDEX)];
+    float *const probabilities1 =
+            &(*charProbabilities)[getCharProbabilityIndex(keyCount, index1, NOT_AN_INDEX)];
+    float *const skipProbability0 = &probabilities0[NOT_AN_INDEX + 1];
+    float *const skipProbability1 = &probabilities1[NOT_AN_INDEX + 1];
+    // The keys come first and the skip probability last, which is suppressed like the keys.
+    for (int k = 0; k <= keyCount; ++k) {
+        const int column = k < keyCount ? k + 1 : NOT_AN_INDEX + 1;
+        float *const probability0 = &probabilities0[column];
+        float *const probability1 = &probabilities1[column];
+        if (*probability0 < farKeyProbability && *probability1 < farKeyProbability
+                && *probability0 < *probability1) {
+            const float newProbability = *probability0 * suppressionRate;
+            const float suppression = *probability0 - newProbability;
+            *probability0 = newProbability;
+            *skipProbability0 += suppression;
 
             // Add the probability of the same key nearby index1
             const float probabilityGain = min(suppression
                     * ProximityInfoParams::SUPPRESSION_WEIGHT_FOR_PROBABILITY_GAIN,
-                    (*charProbabilities)[index1][NOT_AN_INDEX]
+                    *skipProbability1
                             * ProximityInfoParams::SKIP_PROBABALITY_WEIGHT_FOR_PROBABILITY_GAIN);
-            it2->second += probabilityGain;
-            (*charProbabilities)[index1][NOT_AN_INDEX] -= probabilityGain;
+            *probability1 += probabilityGain;
+            *skipProbability1 -= probabilityGain;
         }
     }
     return true;
 }
 
-/* static */ bool ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
+// Returns the number of leading sampled points of the previous input that the input still has.
+/* static */ int ProximityInfoStateUtils::getSharedSampledInputSize(
         const int inputSize, const int *const xCoordinates, const int *const yCoordinates,
         const int *const times, const int sampledInputSize,
         const std::vector<int> *const sampledInputXs, const std::vector<int> *const sampledInputYs,
         const std::vector<int> *const sampledTimes,
         const std::vector<int> *const sampledInputIndices) {
-    if (inputSize < sampledInputSize) {
-        return false;
-    }
     for (int i = 0; i < sampledInputSize; ++i) {
         const int index = (*sampledInputIndices)[i];
         if (index >= inputSize) {
-            return false;
+            return i;
         }
         if (xCoordinates[index] != (*sampledInputXs)[i]
                 || yCoordinates[index] != (*sampledInputYs)[i]) {
-            return false;
+            return i;
         }
         if (!times) {
             continue;
         }
         if (times[index] != (*sampledTimes)[i]) {
-            return false;
+            return i;
         }
     }
-    return true;
+    return sampledInputSize;
 }
 
 // Get a word that is detected by tracing the most probable string into codePointBuf and
-// returns probability of generating the word.
+// returns probability of generating the word. The probabilities of the points before
+// lastSavedInputSize don't change, so the tracing resumes from there: mostProbableStringLengths
+// and mostProbableStringLogProbabilities keep the length and the probability of the word traced
+// before each point, and codePointBuf the word of the previous call.
 /* static */ float ProximityInfoStateUtils::getMostProbableString(
         const ProximityInfo *const proximityInfo, const int sampledInputSize,
-        const std::vector<hash_map_compat<int, float> > *const charProbabilities,
-        int *const codePointBuf) {
+        const int lastSavedInputSize, const std::vector<float> *const charProbabilities,
+        std::vector<int> *mostProbableStringLengths,
+        std::vector<float> *mostProbableStringLogProbabilities, int *const codePointBuf) {
     ASSERT(sampledInputSize >= 0);
-    memset(codePointBuf, 0, sizeof(codePointBuf[0]) * MAX_WORD_LENGTH);
-    int index = 0;
-    float sumLogProbability = 0.0f;
+    const int keyCount = proximityInfo->getKeyCount();
+    const float farKeyProbability = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
+    if (mostProbableStringLengths->empty()) {
+        mostProbableStringLengths->push_back(0);
+        mostProbableStringLogProbabilities->push_back(0.0f);
+    }
+    const int start = min(lastSavedInputSize,
+            static_cast<int>(mostProbableStringLengths->size()) - 1);
+    mostProbableStringLengths->resize(start + 1);
+    mostProbableStringLogProbabilities->resize(start + 1);
+    int index = (*mostProbableStringLengths)[start];
+    float sumLogProbability = (*mostProbableStringLogProbabilities)[start];
+    memset(&codePointBuf[index], 0, sizeof(codePointBuf[0]) * (MAX_WORD_LENGTH - index));
     // TODO: Current implementation is greedy algorithm. DP would be efficient for many cases.
-    for (int i = 0; i < sampledInputSize && index < MAX_WORD_LENGTH - 1; ++i) {
+    for (int i = start; i < sampledInputSize && index < MAX_WORD_LENGTH - 1; ++i) {
         float minLogProbability = static_cast<float>(MAX_VALUE_FOR_WEIGHTING);
         int character = NOT_AN_INDEX;
-        for (hash_map_compat<int, float>::const_iterator it = (*charProbabilities)[i].begin();
-                it != (*charProbabilities)[i].end(); ++it) {
-            const float logProbability = (it->first != NOT_AN_INDEX)
-                    ? it->second + ProximityInfoParams::DEMOTION_LOG_PROBABILITY : it->second;
+        const float *const probabilities =
+                &(*charProbabilities)[getCharProbabilityIndex(keyCount, i, NOT_AN_INDEX)];
+        // The keys first, then skipping the point.
+        for (int k = 0; k <= keyCount; ++k) {
+            const int keyIndex = k < keyCount ? k : NOT_AN_INDEX;
+            const float probability = probabilities[keyIndex + 1];
+            if (probability >= farKeyProbability) {
+                continue;
+            }
+            const float logProbability = (keyIndex != NOT_AN_INDEX)
+                    ? probability + ProximityInfoParams::DEMOTION_LOG_PROBABILITY : probability;
             if (logProbability < minLogProbability) {
                 minLogProbability = logProbability;
-                character = it->first;
+                character = keyIndex;
             }
         }
         if (character != NOT_AN_INDEX) {
@@ -1033,6 +1057,8 @@ namespace latinime {
             index++;
         }
         sumLogProbability += minLogProbability;
+        mostProbableStringLengths->push_back(index);
+        mostProbableStringLogProbabilities->push_back(sumLogProbability);
     }
     codePointBuf[index] = '\0';
     return sumLogProbability;
@@ -1043,8 +1069,8 @@ namespace latinime {
         const int sampledInputSize, const std::vector<int> *const sampledInputXs,
         const std::vector<int> *const sampledInputYs,
         const std::vector<int> *const sampledTimes,
-        const std::vector<float> *const sampledSpeedRates,
-        const std::vector<int> *const sampledBeelineSpeedPercentiles) {
+        const std::vector<float> *const sampledSpeedRates, const float averageSpeed,
+        const std::vector<BeelineSpeed> *const sampledBeelineSpeeds) {
     if (DEBUG_GEO_FULL) {
         for (int i = 0; i < sampledInputSize; ++i) {
             AKLOGI("Sampled(%d): x = %d, y = %d, time = %d", i, (*sampledInputXs)[i],
@@ -1066,7 +1092,8 @@ namespace latinime {
         if (isGeometric) {
             AKLOGI("%d: x = %d, y = %d, time = %d, relative speed = %.4f, beeline speed = %d",
                     i, (*sampledInputXs)[i], (*sampledInputYs)[i], (*sampledTimes)[i],
-                    (*sampledSpeedRates)[i], (*sampledBeelineSpeedPercentiles)[i]);
+                    (*sampledSpeedRates)[i],
+                    getBeelineSpeedPercentile(averageSpeed, (*sampledBeelineSpeeds)[i]));
         }
         sampledX << (*sampledInputXs)[i];
         sampledY << (*sampledInputYs)[i];
@@ -32,6 +32,41 @@ class ProximityInfoStateUtils {
     typedef hash_map_compat<int, float> NearKeysDistanceMap;
     typedef std::bitset<MAX_KEY_COUNT_IN_A_KEYBOARD> NearKeycodesSet;
 
+    // The char probabilities of the sampled points are rows of keyCount + 1 floats: the
+    // probability of skipping the point, then the probabilities of the keys. The keys that are
+    // not near the point have MAX_VALUE_FOR_WEIGHTING.
+    static AK_FORCE_INLINE int getCharProbabilityIndex(const int keyCount, const int index,
+            const int keyIndex) {
+        // The skip probability is the one of NOT_AN_INDEX, which is -1.
+        return index * (keyCount + 1) + keyIndex + 1;
+    }
+
+    // The beeline speed around a sampled point. Its rate relative to the average speed of the
+    // input is only computed when asked, so that appending points doesn't update every point.
+    struct BeelineSpeed {
+        // The rate of a point whose rate doesn't depend on the average speed, or a negative
+        // value if it does.
+        float mFixedRate;
+        float mSpeed;
+        // Whether the last input point was looked up, which appending points changes.
+        bool mReachesLastInputPoint;
+    };
+
+    static AK_FORCE_INLINE int getBeelineSpeedPercentile(const float averageSpeed,
+            const BeelineSpeed &beelineSpeed) {
+        float rate = 1.0f;
+        if (averageSpeed < 0.001f) {
+            // Invalid state: every point has the average rate.
+        } else if (beelineSpeed.mFixedRate >= 0.0f) {
+            rate = beelineSpeed.mFixedRate;
+        } else {
+            // Offset 1%
+            // TODO: Detect double letter more smartly
+            rate = 0.01f + beelineSpeed.mSpeed / averageSpeed;
+        }
+        return static_cast<int>(rate * MAX_PERCENTILE);
+    }
+
     static int trimLastTwoTouchPoints(std::vector<int> *sampledInputXs,
             std::vector<int> *sampledInputYs, std::vector<int> *sampledInputTimes,
             std::vector<int> *sampledLengthCache, std::vector<int> *sampledInputIndice);
@@ -57,12 +92,12 @@ class ProximityInfoStateUtils {
             const std::vector<int> *const sampledLengthCache,
             const std::vector<int> *const sampledInputIndice,
             std::vector<float> *sampledSpeedRates, std::vector<float> *sampledDirections);
-    static void refreshBeelineSpeedRates(const int mostCommonKeyWidth,  const float averageSpeed,
-            const int inputSize, const int *const xCoordinates, const int *const yCoordinates,
-            const int *times, const int sampledInputSize,
+    static void refreshBeelineSpeeds(const int mostCommonKeyWidth, const int inputSize,
+            const int *const xCoordinates, const int *const yCoordinates, const int *times,
+            const int lastSavedInputSize, const int sampledInputSize,
             const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs, const std::vector<int> *const inputIndice,
-            std::vector<int> *beelineSpeedPercentiles);
+            std::vector<BeelineSpeed> *beelineSpeeds);
     static float getDirection(const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs, const int index0, const int index1);
     static void updateAlignPointProbabilities(const float maxPointToKeyLength,
@@ -73,13 +108,12 @@ class ProximityInfoStateUtils {
             const std::vector<int> *const sampledLengthCache,
             const std::vector<float> *const sampledNormalizedSquaredLengthCache,
             std::vector<NearKeycodesSet> *sampledNearKeySets,
-            std::vector<hash_map_compat<int, float> > *charProbabilities);
+            std::vector<float> *charProbabilities);
     static void updateSampledSearchKeySets(const ProximityInfo *const proximityInfo,
             const int sampledInputSize, const int lastSavedInputSize,
             const std::vector<int> *const sampledLengthCache,
             const std::vector<NearKeycodesSet> *const sampledNearKeySets,
-            std::vector<NearKeycodesSet> *sampledSearchKeySets,
-            std::vector<std::vector<int> > *sampledSearchKeyVectors);
+            std::vector<NearKeycodesSet> *sampledSearchKeySets);
     static float getPointToKeyByIdLength(const float maxPointToKeyLength,
             const std::vector<float> *const sampledNormalizedSquaredLengthCache, const int keyCount,
             const int inputIndex, const int keyId);
@@ -101,9 +135,9 @@ class ProximityInfoStateUtils {
             const int sampledInputSize, const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs,
             const std::vector<int> *const sampledTimes,
-            const std::vector<float> *const sampledSpeedRates,
-            const std::vector<int> *const sampledBeelineSpeedPercentiles);
-    static bool checkAndReturnIsContinuousSuggestionPossible(const int inputSize,
+            const std::vector<float> *const sampledSpeedRates, const float averageSpeed,
+            const std::vector<BeelineSpeed> *const sampledBeelineSpeeds);
+    static int getSharedSampledInputSize(const int inputSize,
             const int *const xCoordinates, const int *const yCoordinates, const int *const times,
             const int sampledInputSize, const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs,
@@ -111,9 +145,10 @@ class ProximityInfoStateUtils {
             const std::vector<int> *const sampledInputIndices);
     // TODO: Move to most_probable_string_utils.h
     static float getMostProbableString(const ProximityInfo *const proximityInfo,
-            const int sampledInputSize,
-            const std::vector<hash_map_compat<int, float> > *const charProbabilities,
-            int *const codePointBuf);
+            const int sampledInputSize, const int lastSavedInputSize,
+            const std::vector<float> *const charProbabilities,
+            std::vector<int> *mostProbableStringLengths,
+            std::vector<float> *mostProbableStringLogProbabilities, int *const codePointBuf);
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityInfoStateUtils);
@@ -141,10 +176,9 @@ class ProximityInfoStateUtils {
             std::vector<int> *sampledInputXs, std::vector<int> *sampledInputYs,
             std::vector<int> *sampledInputTimes, std::vector<int> *sampledLengthCache,
             std::vector<int> *sampledInputIndice);
-    static float calculateBeelineSpeedRate(const int mostCommonKeyWidth, const float averageSpeed,
-            const int id, const int inputSize, const int *const xCoordinates,
-            const int *const yCoordinates, const int *times, const int sampledInputSize,
-            const std::vector<int> *const sampledInputXs,
+    static BeelineSpeed calculateBeelineSpeed(const int mostCommonKeyWidth, const int id,
+            const int inputSize, const int *const xCoordinates, const int *const yCoordinates,
+            const int *times, const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs,
             const std::vector<int> *const inputIndice);
     static float getPointAngle(const std::vector<int> *const sampledInputXs,
@@ -152,9 +186,9 @@ class ProximityInfoStateUtils {
     static float getPointsAngle(const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs, const int index0, const int index1,
             const int index2);
-    static bool suppressCharProbabilities(const int mostCommonKeyWidth,
+    static bool suppressCharProbabilities(const int mostCommonKeyWidth, const int keyCount,
             const int sampledInputSize, const std::vector<int> *const lengthCache, const int index0,
-            const int index1, std::vector<hash_map_compat<int, float> > *charProbabilities);
+            const int index1, std::vector<float> *charProbabilities);
     static float calculateSquaredDistanceFromSweetSpotCenter(
             const ProximityInfo *const proximityInfo, const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs, const int keyIndex,
@@ -22,14 +22,17 @@
 #include "additional_proximity_chars.h"
 #include "char_utils.h"
 #include "defines.h"
+#include "fixed_int_hash_map.h"
 #include "geometry_utils.h"
-#include "hash_map_compat.h"
 
 namespace latinime {
 class ProximityInfoUtils {
  public:
+    // Maps the lower case code point of each key to its index.
+    typedef FixedIntHashMap<int, MAX_KEY_COUNT_IN_A_KEYBOARD * 2> CodeToKeyMap;
+
     static AK_FORCE_INLINE int getKeyIndexOf(const int keyCount, const int c,
-            const hash_map_compat<int, int> *const codeToKeyMap) {
+            const CodeToKeyMap *const codeToKeyMap) {
         if (keyCount == 0) {
             // We do not have the coordinate data
             return NOT_AN_INDEX;
@@ -38,11 +41,8 @@ class ProximityInfoUtils {
             return NOT_AN_INDEX;
         }
         const int lowerCode = toLowerCase(c);
-        hash_map_compat<int, int>::const_iterator mapPos = codeToKeyMap->find(lowerCode);
-        if (mapPos != codeToKeyMap->end()) {
-            return mapPos->second;
-        }
-        return NOT_AN_INDEX;
+        const int *const keyIndex = codeToKeyMap->find(lowerCode);
+        return keyIndex ? *keyIndex : NOT_AN_INDEX;
     }
 
     static AK_FORCE_INLINE void initializeProximities(const int *const inputCodes,
@@ -52,7 +52,7 @@ class ProximityInfoUtils {
             const int *const proximityCharsArray, const int cellHeight, const int cellWidth,
             const int gridWidth, const int mostCommonKeyWidth, const int keyCount,
             const char *const localeStr,
-            const hash_map_compat<int, int> *const codeToKeyMap, int *inputProximities) {
+            const CodeToKeyMap *const codeToKeyMap, int *inputProximities) {
         // Initialize
         // - mInputCodes
         // - mNormalizedSquaredDistances
@@ -156,7 +156,7 @@ class ProximityInfoUtils {
             const int *const proximityCharsArray, const int cellHeight, const int cellWidth,
             const int gridWidth, const int mostCommonKeyWidth, const int keyCount,
             const int x, const int y, const int primaryKey, const char *const localeStr,
-            const hash_map_compat<int, int> *const codeToKeyMap, int *proximities) {
+            const CodeToKeyMap *const codeToKeyMap, int *proximities) {
         const int mostCommonKeyWidthSquare = mostCommonKeyWidth * mostCommonKeyWidth;
         int insertPos = 0;
         proximities[insertPos++] = primaryKey;
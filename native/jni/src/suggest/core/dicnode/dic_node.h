@@ -27,16 +27,19 @@
 
 #if DEBUG_DICT
 #define LOGI_SHOW_ADD_COST_PROP \
-        do { char charBuf[50]; \
-        INTS_TO_CHARS(getOutputWordBuf(), getDepth(), charBuf); \
+        do { char charBuf[50]; int wordBuf[MAX_WORD_LENGTH]; \
+        outputCurrentWord(wordBuf); \
+        INTS_TO_CHARS(wordBuf, getDepth(), charBuf); \
         AKLOGI("%20s, \"%c\", size = %03d, total = %03d, index(0) = %02d, dist = %.4f, %s,,", \
                 __FUNCTION__, getNodeCodePoint(), inputSize, getTotalInputIndex(), \
                 getInputIndex(0), getNormalizedCompoundDistance(), charBuf); } while (0)
 #define DUMP_WORD_AND_SCORE(header) \
-        do { char charBuf[50]; char prevWordCharBuf[50]; \
-        INTS_TO_CHARS(getOutputWordBuf(), getDepth(), charBuf); \
-        INTS_TO_CHARS(mDicNodeState.mDicNodeStatePrevWord.mPrevWord, \
-                mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(), prevWordCharBuf); \
+        do { char charBuf[50]; char prevWordCharBuf[50]; int wordBuf[MAX_WORD_LENGTH]; \
+        const int prevWordLength = mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(); \
+        outputCurrentWord(wordBuf); \
+        INTS_TO_CHARS(wordBuf, getDepth(), charBuf); \
+        mDicNodeState.mDicNodeStateOutput.outputCodePoints(-prevWordLength, 0, wordBuf); \
+        INTS_TO_CHARS(wordBuf, prevWordLength, prevWordCharBuf); \
         AKLOGI("#%8s, %5f, %5f, %5f, %5f, %s, %s, %d,,", header, \
                 getSpatialDistanceForScoring(), getLanguageDistanceForScoring(), \
                 getNormalizedCompoundDistance(), getRawLength(), prevWordCharBuf, charBuf, \
@@ -105,12 +108,13 @@ class DicNode {
     // TODO: minimize arguments by looking binary_format
     // Init for root with prevWordNodePos which is used for bigram
     void initAsRoot(const int pos, const int childrenPos, const int childrenCount,
-            const int prevWordNodePos) {
+            const int prevWordNodePos, const int16_t prevWordMaxBigramProbability,
+            const int dictionaryIndex, DicNodeWordArena *const wordArena) {
         mIsUsed = true;
         mIsCachedForNextSuggestion = false;
-        mDicNodeProperties.init(
-                pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false, true, 0, 0);
-        mDicNodeState.init(prevWordNodePos);
+        mDicNodeProperties.init(pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false,
+                true, 0, 0, dictionaryIndex);
+        mDicNodeState.init(prevWordNodePos, prevWordMaxBigramProbability, wordArena);
         PROF_NODE_RESET(mProfiler);
     }
 
@@ -126,27 +130,28 @@ class DicNode {
     // TODO: minimize arguments by looking binary_format
     // Init for root with previous word
     void initAsRootWithPreviousWord(DicNode *dicNode, const int pos, const int childrenPos,
-            const int childrenCount) {
+            const int childrenCount, const int16_t prevWordMaxBigramProbability) {
         mIsUsed = true;
         mIsCachedForNextSuggestion = false;
-        mDicNodeProperties.init(
-                pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false, true, 0, 0);
+        // The next word is searched in the dictionary of the previous one.
+        mDicNodeProperties.init(pos, 0, childrenPos, 0, 0, 0, childrenCount, 0, 0, false, false,
+                true, 0, 0, dicNode->getDictionaryIndex());
         // TODO: Move to dicNodeState?
-        mDicNodeState.mDicNodeStateOutput.init(); // reset for next word
+        // The current word of dicNode and a space become part of the previous words.
+        mDicNodeState.mDicNodeStateOutput.init(&dicNode->mDicNodeState.mDicNodeStateOutput,
+                dicNode->getDepth(), KEYCODE_SPACE);
         mDicNodeState.mDicNodeStateInput.init(
                 &dicNode->mDicNodeState.mDicNodeStateInput, true /* resetTerminalDiffCost */);
         mDicNodeState.mDicNodeStateScoring.init(
                 &dicNode->mDicNodeState.mDicNodeStateScoring);
         mDicNodeState.mDicNodeStatePrevWord.init(
-                dicNode->mDicNodeState.mDicNodeStatePrevWord.getPrevWordCount() + 1,
+                &dicNode->mDicNodeState.mDicNodeStatePrevWord,
                 dicNode->mDicNodeProperties.getProbability(),
+                prevWordMaxBigramProbability,
                 dicNode->mDicNodeProperties.getPos(),
-                dicNode->mDicNodeState.mDicNodeStatePrevWord.mPrevWord,
-                dicNode->mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength(),
-                dicNode->getOutputWordBuf(),
                 dicNode->mDicNodeProperties.getDepth(),
-                dicNode->mDicNodeState.mDicNodeStatePrevWord.mPrevSpacePositions,
-                mDicNodeState.mDicNodeStateInput.getInputIndex(0) /* lastInputIndex */);
+                mDicNodeState.mDicNodeStateInput.getInputIndex(0) /* lastInputIndex */,
+                mDicNodeState.mDicNodeStateOutput.getWordArena());
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
     }
 
@@ -163,7 +168,7 @@ class DicNode {
                 dicNode->mDicNodeProperties.getLeavingDepth() + additionalSubwordLength);
         mDicNodeProperties.init(pos, flags, childrenPos, attributesPos, siblingPos, nodeCodePoint,
                 childrenCount, probability, bigramProbability, isTerminal, hasMultipleChars,
-                hasChildren, newDepth, newLeavingDepth);
+                hasChildren, newDepth, newLeavingDepth, dicNode->getDictionaryIndex());
         mDicNodeState.init(&dicNode->mDicNodeState, additionalSubwordLength, additionalSubword);
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
     }
@@ -220,7 +225,7 @@ class DicNode {
     }
 
     bool isFirstCharUppercase() const {
-        const int c = getOutputWordBuf()[0];
+        const int c = getFirstCodePoint();
         return isAsciiUpper(c);
     }
 
@@ -241,11 +246,21 @@ class DicNode {
         return mDicNodeProperties.getPos();
     }
 
+    // The positions of the node are in this dictionary of the traverse session.
+    int getDictionaryIndex() const {
+        return mDicNodeProperties.getDictionaryIndex();
+    }
+
     // Used to get bigram probability in DicNodeUtils
     int getPrevWordPos() const {
         return mDicNodeState.mDicNodeStatePrevWord.getPrevWordNodePos();
     }
 
+    // Used to bound the language cost in Weighting
+    int getPrevWordMaxBigramProbability() const {
+        return mDicNodeState.mDicNodeStatePrevWord.getMaxBigramProbability();
+    }
+
     // Used in DicNodeUtils
     int getChildrenPos() const {
         return mDicNodeProperties.getChildrenPos();
@@ -294,7 +309,7 @@ class DicNode {
         int charCount = 0;
         // Find new word start index
         for (int i = 0; i < prevWordLenOfTop; ++i) {
-            const int c = mDicNodeState.mDicNodeStatePrevWord.getPrevWordCodePointAt(i);
+            const int c = getPrevWordCodePointAt(i);
             // TODO: Check other separators.
             if (c != KEYCODE_SPACE && c != KEYCODE_SINGLE_QUOTE) {
                 if (charCount == inputCommitPoint) {
@@ -304,8 +319,7 @@ class DicNode {
                 ++charCount;
             }
         }
-        if (!mDicNodeState.mDicNodeStatePrevWord.startsWith(
-                &topNode->mDicNodeState.mDicNodeStatePrevWord, newPrevWordStartIndex - 1)) {
+        if (!prevWordsStartWith(topNode, newPrevWordStartIndex - 1)) {
             // Node mismatch.
             return false;
         }
@@ -314,16 +328,46 @@ class DicNode {
         return true;
     }
 
+    void relocateInWordArena() {
+        mDicNodeState.mDicNodeStatePrevWord.relocateInWordArena(
+                mDicNodeState.mDicNodeStateOutput.getWordArena());
+        mDicNodeState.mDicNodeStateOutput.relocateInWordArena();
+    }
+
+    // Makes the nodes expanded from this one append their code points to wordArena, a region of
+    // the word arena of this node.
+    void setWordArena(DicNodeWordArena *const wordArena) {
+        mDicNodeState.mDicNodeStateOutput.setWordArena(wordArena);
+    }
+
+    // Moves this node from a word arena region to its base arena, once the region is merged.
+    void moveToBaseWordArena() {
+        mDicNodeState.mDicNodeStatePrevWord.moveToBaseWordArena(
+                mDicNodeState.mDicNodeStateOutput.getWordArena());
+        mDicNodeState.mDicNodeStateOutput.moveToBaseWordArena();
+    }
+
+    // Materializes the previous words and the current word from the word arena.
     void outputResult(int *dest) const {
-        const uint16_t prevWordLength = mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength();
-        const uint16_t currentDepth = getDepth();
-        DicNodeUtils::appendTwoWords(mDicNodeState.mDicNodeStatePrevWord.mPrevWord,
-                   prevWordLength, getOutputWordBuf(), currentDepth, dest);
+        const int prevWordLength = min(
+                static_cast<int>(mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength()),
+                MAX_WORD_LENGTH);
+        const int currentWordLength = min(static_cast<int>(getDepth()),
+                MAX_WORD_LENGTH - prevWordLength - 1);
+        mDicNodeState.mDicNodeStateOutput.outputCodePoints(-prevWordLength, 0, dest);
+        mDicNodeState.mDicNodeStateOutput.outputCodePoints(0, currentWordLength,
+                &dest[prevWordLength]);
         DUMP_WORD_AND_SCORE("OUTPUT");
     }
 
+    // Outputs the code points of the current word up to the current depth.
+    void outputCurrentWord(int *dest) const {
+        mDicNodeState.mDicNodeStateOutput.outputCodePoints(0, getDepth(), dest);
+    }
+
     void outputSpacePositionsResult(int *spaceIndices) const {
-        mDicNodeState.mDicNodeStatePrevWord.outputSpacePositions(spaceIndices);
+        mDicNodeState.mDicNodeStatePrevWord.outputSpacePositions(
+                mDicNodeState.mDicNodeStateOutput.getWordArena(), spaceIndices);
     }
 
     bool hasMultipleWords() const {
@@ -364,8 +408,8 @@ class DicNode {
         return mDicNodeState.mDicNodeStatePrevWord.getPrevWordNodePos();
     }
 
-    AK_FORCE_INLINE const int *getOutputWordBuf() const {
-        return mDicNodeState.mDicNodeStateOutput.mWordBuf;
+    int getFirstCodePoint() const {
+        return mDicNodeState.mDicNodeStateOutput.getFirstCodePoint();
     }
 
     int getPrevCodePointG(int pointerId) const {
@@ -492,7 +536,7 @@ class DicNode {
         mReleaseListener = releaseListener;
     }
 
-    AK_FORCE_INLINE bool compare(const DicNode *right) {
+    AK_FORCE_INLINE bool compare(const DicNode *right) const {
         if (!isUsed() && !right->isUsed()) {
             // Compare pointer values here for stable comparison
             return this > right;
@@ -516,17 +560,50 @@ class DicNode {
         if (depthDiff != 0) {
             return depthDiff > 0;
         }
-        for (int i = 0; i < depth; ++i) {
-            const int codePoint = mDicNodeState.mDicNodeStateOutput.getCodePointAt(i);
-            const int rightCodePoint = right->mDicNodeState.mDicNodeStateOutput.getCodePointAt(i);
-            if (codePoint != rightCodePoint) {
-                return rightCodePoint > codePoint;
-            }
+        const int codePointDiff = mDicNodeState.mDicNodeStateOutput.compareCodePoints(
+                &right->mDicNodeState.mDicNodeStateOutput, depth);
+        if (codePointDiff != 0) {
+            return codePointDiff > 0;
         }
         // Compare pointer values here for stable comparison
         return this > right;
     }
 
+    // Whether this node and right are at the same state of the search, reached through different
+    // corrections: they output the same words, are at the same position of the lexicon and go on
+    // from the same input indices. Only the better one is worth expanding.
+    AK_FORCE_INLINE bool isSameSearchState(const DicNode *right) const {
+        if (getPos() != right->getPos() || getDictionaryIndex() != right->getDictionaryIndex()
+                || getDepth() != right->getDepth()
+                || getPrevWordNodePos() != right->getPrevWordNodePos()
+                || mDicNodeState.mDicNodeStatePrevWord.getPrevWordCount()
+                        != right->mDicNodeState.mDicNodeStatePrevWord.getPrevWordCount()
+                || getDoubleLetterLevel() != right->getDoubleLetterLevel()
+                || mDicNodeState.mDicNodeStateScoring.getDigraphIndex()
+                        != right->mDicNodeState.mDicNodeStateScoring.getDigraphIndex()) {
+            return false;
+        }
+        for (int i = 0; i < MAX_POINTER_COUNT_G; ++i) {
+            if (getInputIndex(i) != right->getInputIndex(i)) {
+                return false;
+            }
+        }
+        return mDicNodeState.mDicNodeStateOutput.hasSameCodePoints(
+                &right->mDicNodeState.mDicNodeStateOutput);
+    }
+
+    // Hash of the state compared by isSameSearchState()
+    AK_FORCE_INLINE uint32_t getSearchStateHash() const {
+        uint32_t hash = static_cast<uint32_t>(getPos());
+        hash = hash * 31 + getDepth();
+        hash = hash * 31 + static_cast<uint32_t>(getPrevWordNodePos());
+        for (int i = 0; i < MAX_POINTER_COUNT_G; ++i) {
+            hash = hash * 31 + static_cast<uint32_t>(getInputIndex(i));
+        }
+        // Nodes of the main dictionary, at index 0, hash like when it is searched alone.
+        return hash ^ static_cast<uint32_t>(getDictionaryIndex());
+    }
+
  private:
     DicNodeProperties mDicNodeProperties;
     DicNodeState mDicNodeState;
@@ -535,6 +612,23 @@ class DicNode {
     bool mIsUsed;
     DicNodeReleaseListener *mReleaseListener;
 
+    int getPrevWordCodePointAt(const int id) const {
+        return mDicNodeState.mDicNodeStateOutput.getCodePointAt(
+                id - mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength());
+    }
+
+    bool prevWordsStartWith(const DicNode *const prefixNode, const int prefixLen) const {
+        if (prefixLen > mDicNodeState.mDicNodeStatePrevWord.getPrevWordLength()) {
+            return false;
+        }
+        for (int i = 0; i < prefixLen; ++i) {
+            if (getPrevWordCodePointAt(i) != prefixNode->getPrevWordCodePointAt(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     AK_FORCE_INLINE int getTotalInputIndex() const {
         int index = 0;
         for (int i = 0; i < MAX_POINTER_COUNT_G; i++) {
@@ -554,6 +648,14 @@ class DicNode {
                 inputSize, getTotalInputIndex(), errorType);
     }
 
+    // Caveat: Must not be called outside Weighting
+    // This restriction is guaranteed by "friend"
+    AK_FORCE_INLINE void setLanguageLookAheadCost(const float languageLookAheadCost,
+            const bool doNormalization) {
+        mDicNodeState.mDicNodeStateScoring.setLanguageLookAheadCost(languageLookAheadCost,
+                doNormalization, getTotalInputIndex());
+    }
+
     // Caveat: Must not be called outside Weighting
     // This restriction is guaranteed by "friend"
     AK_FORCE_INLINE void forwardInputIndex(const int pointerId, const int count,
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_CHILD_ITERATOR_H
+#define LATINIME_DIC_NODE_CHILD_ITERATOR_H
+
+#include <stdint.h>
+
+#include "binary_format.h"
+#include "defines.h"
+#include "dic_node.h"
+
+namespace latinime {
+
+/**
+ * Reads the children of a dic node one at a time as lightweight descriptors, so that they can be
+ * filtered on their code point before a full DicNode is built for the ones that are kept.
+ *
+ * The children of a passing node (in the middle of a multiple chars group) are its next code
+ * point only. The children of a leaving node are the live char groups of its children array,
+ * following the forward links of dynamic dictionaries. The children count of a child, which lives
+ * in another part of the dictionary, is only read when the child is built.
+ *
+ * Usage:
+ *   DicNodeChildIterator childIterator(dicNode, dicRoot, supportsDynamicUpdate, headerSize);
+ *   while (childIterator.next()) {
+ *       if (isWanted(childIterator.getNodeCodePoint())) {
+ *           childIterator.initChildDicNode(dicNode, &childDicNode);
+ *       }
+ *   }
+ */
+class DicNodeChildIterator {
+ public:
+    AK_FORCE_INLINE DicNodeChildIterator(const DicNode *const dicNode,
+            const uint8_t *const dicRoot, const bool supportsDynamicUpdate, const int headerSize)
+            : mDicRoot(dicRoot), mSupportsDynamicUpdate(supportsDynamicUpdate),
+              mHeaderSize(headerSize), mIsPassing(!dicNode->isLeavingNode()),
+              mRemainingGroupCount(0), mNextPos(NOT_A_POSITION), mPos(NOT_A_POSITION), mFlags(0),
+              mNodeCodePoint(NOT_A_CODE_POINT), mSubwordLength(0), mProbability(-1),
+              mChildrenPos(NOT_A_POSITION), mAttributesPos(NOT_A_POSITION),
+              mSiblingPos(NOT_A_POSITION), mIsTerminal(false), mHasMultipleChars(false) {
+        if (mIsPassing) {
+            mNodeCodePoint = dicNode->getNodeTypedCodePoint();
+            mRemainingGroupCount = 1;
+        } else if (dicNode->getChildrenCount() > 0) {
+            // A node without children has no array of char groups, hence no forward link either.
+            mNextPos = dicNode->getChildrenPos();
+            mRemainingGroupCount = dicNode->getChildrenCount();
+        }
+    }
+
+    // Non virtual inline destructor -- never inherit this class
+    AK_FORCE_INLINE ~DicNodeChildIterator() {}
+
+    // Moves to the next child. Returns false when there is none left.
+    AK_FORCE_INLINE bool next() {
+        if (mIsPassing) {
+            return mRemainingGroupCount-- > 0;
+        }
+        while (true) {
+            if (mRemainingGroupCount <= 0) {
+                if (mNextPos == NOT_A_POSITION || !mSupportsDynamicUpdate) {
+                    return false;
+                }
+                // Dynamic dictionaries may continue the node in another array of char groups.
+                mNextPos = BinaryFormat::readForwardLinkPosition(mDicRoot, mNextPos, mHeaderSize);
+                if (mNextPos < 0) {
+                    mNextPos = NOT_A_POSITION;
+                    return false;
+                }
+                mRemainingGroupCount =
+                        BinaryFormat::getGroupCountAndForwardPointer(mDicRoot, &mNextPos);
+                continue;
+            }
+            --mRemainingGroupCount;
+            readCharGroup();
+            // A moved char group has a live copy in a later array of the same node.
+            if (!BinaryFormat::isMovedGroup(mFlags, mSupportsDynamicUpdate)) {
+                return true;
+            }
+        }
+    }
+
+    // The code point of the current child, which is all the traversal needs to filter it.
+    int getNodeCodePoint() const {
+        return mNodeCodePoint;
+    }
+
+    // Builds the current child of dicNode, the node this iterator was created for.
+    AK_FORCE_INLINE void initChildDicNode(DicNode *const dicNode,
+            DicNode *const childDicNode) const {
+        if (mIsPassing) {
+            childDicNode->initAsPassingChild(dicNode);
+            return;
+        }
+        const bool hasChildren = mChildrenPos >= 0;
+        int childrenPos = hasChildren ? mChildrenPos : 0;
+        const int childrenCount = hasChildren
+                ? BinaryFormat::getGroupCountAndForwardPointer(mDicRoot, &childrenPos) : 0;
+        childDicNode->initAsChild(dicNode, mPos, mFlags, childrenPos, mAttributesPos, mSiblingPos,
+                mNodeCodePoint, childrenCount, mProbability, -1 /* bigramProbability */,
+                mIsTerminal, mHasMultipleChars, hasChildren, mSubwordLength, mSubword);
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodeChildIterator);
+
+    static const int NOT_A_POSITION = -1;
+
+    const uint8_t *const mDicRoot;
+    const bool mSupportsDynamicUpdate;
+    const int mHeaderSize;
+    const bool mIsPassing;
+    int mRemainingGroupCount;
+    int mNextPos;
+
+    // Descriptor of the current child
+    int mPos;
+    uint8_t mFlags;
+    int mNodeCodePoint;
+    uint16_t mSubwordLength;
+    int mSubword[MAX_WORD_LENGTH];
+    int mProbability;
+    // Position of the children array, or a negative value if there is none.
+    int mChildrenPos;
+    int mAttributesPos;
+    int mSiblingPos;
+    bool mIsTerminal;
+    bool mHasMultipleChars;
+
+    AK_FORCE_INLINE void readCharGroup() {
+        int pos = mNextPos;
+        mPos = pos;
+        mFlags = BinaryFormat::getFlagsAndForwardPointer(mDicRoot, &pos);
+        pos = BinaryFormat::skipParentPosition(mSupportsDynamicUpdate, pos);
+        mHasMultipleChars = (0 != (BinaryFormat::FLAG_HAS_MULTIPLE_CHARS & mFlags));
+        // A deleted char group is kept only to hold its children.
+        mIsTerminal = (0 != (BinaryFormat::FLAG_IS_TERMINAL & mFlags))
+                && !BinaryFormat::isDeletedGroup(mFlags, mSupportsDynamicUpdate);
+
+        int codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+        ASSERT(NOT_A_CODE_POINT != codePoint);
+        mNodeCodePoint = codePoint;
+        mSubwordLength = 0;
+        mSubword[mSubwordLength++] = codePoint;
+        if (mHasMultipleChars) {
+            codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+            while (NOT_A_CODE_POINT != codePoint) {
+                mSubword[mSubwordLength++] = codePoint;
+                codePoint = BinaryFormat::getCodePointAndForwardPointer(mDicRoot, &pos);
+            }
+        }
+
+        mProbability = mIsTerminal
+                ? BinaryFormat::readProbabilityWithoutMovingPointer(mDicRoot, pos) : -1;
+        pos = BinaryFormat::skipProbability(mFlags, pos);
+        mChildrenPos = BinaryFormat::readChildrenPosition(mDicRoot, mFlags, pos,
+                mSupportsDynamicUpdate);
+        mAttributesPos = BinaryFormat::skipChildrenPosition(mFlags, pos, mSupportsDynamicUpdate);
+        mSiblingPos = BinaryFormat::skipChildrenPosAndAttributes(mDicRoot, mFlags, pos,
+                mSupportsDynamicUpdate);
+        mNextPos = mSiblingPos;
+    }
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_CHILD_ITERATOR_H
@@ -17,25 +17,33 @@
 #ifndef LATINIME_DIC_NODE_PRIORITY_QUEUE_H
 #define LATINIME_DIC_NODE_PRIORITY_QUEUE_H
 
-#include <queue>
 #include <vector>
 
 #include "defines.h"
 #include "dic_node.h"
 #include "dic_node_release_listener.h"
+#include "dic_node_search_state_map.h"
+#include "dic_node_utils.h"
 
 #define MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY 200
 
 namespace latinime {
 
+/**
+ * Bounded priority queue of dic nodes that keeps the best ones. The nodes are stored in
+ * mDicNodesBuf and ordered by a min-max heap of their indices, with the best node at the root and
+ * the worst one among its children, so that both ends can be read in O(1) and popped or replaced
+ * in O(log n).
+ */
 class DicNodePriorityQueue : public DicNodeReleaseListener {
  public:
     AK_FORCE_INLINE DicNodePriorityQueue()
             : MAX_CAPACITY(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY),
               mMaxSize(MAX_DIC_NODE_PRIORITY_QUEUE_CAPACITY), mDicNodesBuf(), mUnusedNodeIndices(),
-              mNextUnusedNodeId(0), mDicNodesQueue() {
+              mNextUnusedNodeId(0), mHeap(), mHeapSize(0), mSearchStateMap() {
         mDicNodesBuf.resize(MAX_CAPACITY + 1);
         mUnusedNodeIndices.resize(MAX_CAPACITY + 1);
+        mHeap.resize(MAX_CAPACITY + 1);
         reset();
     }
 
@@ -43,7 +51,7 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
     AK_FORCE_INLINE ~DicNodePriorityQueue() {}
 
     int getSize() const {
-        return static_cast<int>(mDicNodesQueue.size());
+        return mHeapSize;
     }
 
     int getMaxSize() const {
@@ -63,9 +71,7 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
     }
 
     AK_FORCE_INLINE void clearAndResize(const int maxSize) {
-        while (!mDicNodesQueue.empty()) {
-            mDicNodesQueue.pop();
-        }
+        mHeapSize = 0;
         setMaxSize(maxSize);
         for (int i = 0; i < MAX_CAPACITY + 1; ++i) {
             mDicNodesBuf[i].remove();
@@ -73,6 +79,7 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
             mUnusedNodeIndices[i] = i == MAX_CAPACITY ? NOT_A_NODE_ID : static_cast<int>(i) + 1;
         }
         mNextUnusedNodeId = 0;
+        mSearchStateMap.clear();
     }
 
     AK_FORCE_INLINE DicNode *newDicNode(DicNode *dicNode) {
@@ -89,17 +96,74 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
         return copyPush(dicNode, mMaxSize);
     }
 
+    // Copy, unless a node at the same search state is queued: only the better of the two is then
+    // kept, in the place of the queued one. Returns the node kept from dicNode, or null.
+    AK_FORCE_INLINE DicNode *copyPushMergingSearchState(DicNode *dicNode) {
+        const bool isQueueFull = isFull(mMaxSize);
+        if (isQueueFull && !betterThanWorstDicNode(dicNode)) {
+            // Not better than any node of the same state either
+            return 0;
+        }
+        const uint32_t stateHash = dicNode->getSearchStateHash();
+        DicNode *const queuedDicNode = mSearchStateMap.find(dicNode, stateHash);
+        if (queuedDicNode) {
+            // On a tie the queued node is kept, so that the result does not depend on addresses.
+            if (dicNode->getNormalizedCompoundDistance()
+                    >= queuedDicNode->getNormalizedCompoundDistance()) {
+                return 0;
+            }
+            DicNodeUtils::initByCopy(dicNode, queuedDicNode);
+            restoreHeap(getHeapPos(queuedDicNode));
+            return queuedDicNode;
+        }
+        DicNode *const pushedDicNode = newDicNode(dicNode);
+        if (!pushedDicNode) {
+            return 0;
+        }
+        if (isQueueFull) {
+            copyPop(0);
+        }
+        pushToHeap(pushedDicNode);
+        mSearchStateMap.put(pushedDicNode, stateHash);
+        return pushedDicNode;
+    }
+
+    void relocateInWordArena() {
+        for (int i = 0; i < mHeapSize; ++i) {
+            mDicNodesBuf[mHeap[i]].relocateInWordArena();
+        }
+    }
+
+    // Pops the worst node.
     AK_FORCE_INLINE void copyPop(DicNode *dest) {
-        if (mDicNodesQueue.empty()) {
+        if (mHeapSize == 0) {
             ASSERT(false);
             return;
         }
-        DicNode *node = mDicNodesQueue.top();
-        if (dest) {
-            DicNodeUtils::initByCopy(node, dest);
+        copyPopAt(getWorstHeapPos(), dest);
+    }
+
+    AK_FORCE_INLINE void copyPopBest(DicNode *dest) {
+        if (mHeapSize == 0) {
+            ASSERT(false);
+            return;
         }
-        node->remove();
-        mDicNodesQueue.pop();
+        copyPopAt(0 /* root */, dest);
+    }
+
+    // Returns the best node, or null if the queue is empty.
+    AK_FORCE_INLINE const DicNode *peekBest() const {
+        return mHeapSize == 0 ? 0 : &mDicNodesBuf[mHeap[0]];
+    }
+
+    // Returns the worst node, or null if the queue is empty.
+    AK_FORCE_INLINE const DicNode *peekWorst() const {
+        return mHeapSize == 0 ? 0 : &mDicNodesBuf[mHeap[getWorstHeapPos()]];
+    }
+
+    // Returns the node at index, for 0 <= index < getSize(), in no particular order.
+    AK_FORCE_INLINE const DicNode *getDicNodeAt(const int index) const {
+        return &mDicNodesBuf[mHeap[index]];
     }
 
     void onReleased(DicNode *dicNode) {
@@ -127,38 +191,174 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
     DISALLOW_COPY_AND_ASSIGN(DicNodePriorityQueue);
     static const int NOT_A_NODE_ID = -1;
 
-    AK_FORCE_INLINE static bool compareDicNode(DicNode *left, DicNode *right) {
-        return left->compare(right);
-    }
-
-    struct DicNodeComparator {
-        bool operator ()(DicNode *left, DicNode *right) {
-            return compareDicNode(left, right);
-        }
-    };
-
-    typedef std::priority_queue<DicNode *, std::vector<DicNode *>, DicNodeComparator> DicNodesQueue;
     const int MAX_CAPACITY;
     int mMaxSize;
     std::vector<DicNode> mDicNodesBuf; // of each element of mDicNodesBuf respectively
     std::vector<int> mUnusedNodeIndices;
     int mNextUnusedNodeId;
-    DicNodesQueue mDicNodesQueue;
+    // Min-max heap of indices in mDicNodesBuf. Nodes on even levels are better than all their
+    // descendants, and nodes on odd levels are worse than all their descendants.
+    std::vector<int> mHeap;
+    int mHeapSize;
+    // Queued nodes by search state, for copyPushMergingSearchState()
+    DicNodeSearchStateMap mSearchStateMap;
 
     inline bool isFull(const int maxSize) const {
         return getSize() >= maxSize;
     }
 
-    AK_FORCE_INLINE void pop() {
-        copyPop(0);
+    AK_FORCE_INLINE bool isBetter(const int leftHeapPos, const int rightHeapPos) const {
+        return mDicNodesBuf[mHeap[leftHeapPos]].compare(&mDicNodesBuf[mHeap[rightHeapPos]]);
+    }
+
+    AK_FORCE_INLINE void swapHeapPos(const int heapPos0, const int heapPos1) {
+        const int tmp = mHeap[heapPos0];
+        mHeap[heapPos0] = mHeap[heapPos1];
+        mHeap[heapPos1] = tmp;
+    }
+
+    // Returns the position in the heap of dicNode, a queued node. Only used by the rare
+    // replacements, so that the swaps do not have to track the positions.
+    int getHeapPos(const DicNode *const dicNode) const {
+        const int index = static_cast<int>(dicNode - &mDicNodesBuf[0]);
+        for (int heapPos = 0; heapPos < mHeapSize; ++heapPos) {
+            if (mHeap[heapPos] == index) {
+                return heapPos;
+            }
+        }
+        ASSERT(false);
+        return 0;
+    }
+
+    static AK_FORCE_INLINE int getParentHeapPos(const int heapPos) {
+        return (heapPos - 1) / 2;
+    }
+
+    static AK_FORCE_INLINE bool isOnMinLevel(const int heapPos) {
+        int level = 0;
+        for (int pos = heapPos + 1; pos > 1; pos >>= 1) {
+            ++level;
+        }
+        return (level & 1) == 0;
+    }
+
+    AK_FORCE_INLINE int getWorstHeapPos() const {
+        if (mHeapSize <= 2) {
+            return mHeapSize - 1;
+        }
+        return isBetter(1, 2) ? 2 : 1;
+    }
+
+    AK_FORCE_INLINE void copyPopAt(const int heapPos, DicNode *dest) {
+        DicNode *node = &mDicNodesBuf[mHeap[heapPos]];
+        if (dest) {
+            DicNodeUtils::initByCopy(node, dest);
+        }
+        node->remove();
+        --mHeapSize;
+        if (heapPos < mHeapSize) {
+            mHeap[heapPos] = mHeap[mHeapSize];
+            trickleDown(heapPos);
+        }
+    }
+
+    AK_FORCE_INLINE void pushToHeap(DicNode *dicNode) {
+        const int heapPos = mHeapSize++;
+        mHeap[heapPos] = static_cast<int>(dicNode - &mDicNodesBuf[0]);
+        siftUp(heapPos);
+    }
+
+    // Restores the heap property around heapPos after its node was replaced by any other.
+    AK_FORCE_INLINE void restoreHeap(const int heapPos) {
+        siftUp(heapPos);
+        // Whatever is at heapPos now may be out of order with the descendants.
+        trickleDown(heapPos);
+    }
+
+    // Moves the node at heapPos up until it is in order with its ancestors.
+    AK_FORCE_INLINE void siftUp(const int heapPos) {
+        if (heapPos == 0) {
+            return;
+        }
+        const int parentHeapPos = getParentHeapPos(heapPos);
+        if (isOnMinLevel(heapPos)) {
+            if (isBetter(parentHeapPos, heapPos)) {
+                swapHeapPos(heapPos, parentHeapPos);
+                bubbleUp(parentHeapPos, false /* towardsBest */);
+            } else {
+                bubbleUp(heapPos, true /* towardsBest */);
+            }
+        } else {
+            if (isBetter(heapPos, parentHeapPos)) {
+                swapHeapPos(heapPos, parentHeapPos);
+                bubbleUp(parentHeapPos, true /* towardsBest */);
+            } else {
+                bubbleUp(heapPos, false /* towardsBest */);
+            }
+        }
+    }
+
+    // Moves the node at heapPos up through its grandparents, which are on levels of the same
+    // kind.
+    AK_FORCE_INLINE void bubbleUp(int heapPos, const bool towardsBest) {
+        while (heapPos >= 3) {
+            const int grandparentHeapPos = getParentHeapPos(getParentHeapPos(heapPos));
+            if (towardsBest ? !isBetter(heapPos, grandparentHeapPos)
+                    : !isBetter(grandparentHeapPos, heapPos)) {
+                return;
+            }
+            swapHeapPos(heapPos, grandparentHeapPos);
+            heapPos = grandparentHeapPos;
+        }
+    }
+
+    // Restores the heap property below heapPos after its node was replaced.
+    AK_FORCE_INLINE void trickleDown(int heapPos) {
+        const bool isMin = isOnMinLevel(heapPos);
+        while (true) {
+            const int firstChildHeapPos = heapPos * 2 + 1;
+            if (firstChildHeapPos >= mHeapSize) {
+                return;
+            }
+            // Find the best (on a min level) or worst (on a max level) of the children and
+            // grandchildren.
+            int extremeHeapPos = firstChildHeapPos;
+            const int lastDescendantHeapPos = min(firstChildHeapPos * 2 + 4, mHeapSize - 1);
+            for (int pos = firstChildHeapPos + 1; pos <= lastDescendantHeapPos; ++pos) {
+                if (pos == firstChildHeapPos + 2) {
+                    // Skip to the grandchildren.
+                    pos = firstChildHeapPos * 2 + 1;
+                    if (pos > lastDescendantHeapPos) {
+                        break;
+                    }
+                }
+                if (isMin ? isBetter(pos, extremeHeapPos) : isBetter(extremeHeapPos, pos)) {
+                    extremeHeapPos = pos;
+                }
+            }
+            if (isMin ? !isBetter(extremeHeapPos, heapPos) : !isBetter(heapPos, extremeHeapPos)) {
+                return;
+            }
+            swapHeapPos(extremeHeapPos, heapPos);
+            if (extremeHeapPos <= firstChildHeapPos + 1) {
+                // A child has no descendant that could be out of order with it.
+                return;
+            }
+            const int parentHeapPos = getParentHeapPos(extremeHeapPos);
+            if (isMin ? isBetter(parentHeapPos, extremeHeapPos)
+                    : isBetter(extremeHeapPos, parentHeapPos)) {
+                swapHeapPos(extremeHeapPos, parentHeapPos);
+            }
+            heapPos = extremeHeapPos;
+        }
     }
 
     AK_FORCE_INLINE bool betterThanWorstDicNode(DicNode *dicNode) const {
-        DicNode *worstNode = mDicNodesQueue.top();
+        const DicNode *worstNode = peekWorst();
         if (!worstNode) {
             return true;
         }
-        return compareDicNode(dicNode, worstNode);
+        return dicNode->compare(worstNode);
     }
 
     AK_FORCE_INLINE DicNode *searchEmptyDicNode() {
@@ -192,12 +392,12 @@ class DicNodePriorityQueue : public DicNodeReleaseListener {
             return 0;
         }
         if (!isFull(maxSize)) {
-            mDicNodesQueue.push(dicNode);
+            pushToHeap(dicNode);
             return dicNode;
         }
         if (betterThanWorstDicNode(dicNode)) {
-            pop();
-            mDicNodesQueue.push(dicNode);
+            copyPop(0);
+            pushToHeap(dicNode);
             return dicNode;
         }
         dicNode->remove();
@@ -33,7 +33,7 @@ class DicNodeProperties {
             : mPos(0), mFlags(0), mChildrenPos(0), mAttributesPos(0), mSiblingPos(0),
               mChildrenCount(0), mProbability(0), mBigramProbability(0), mNodeCodePoint(0),
               mDepth(0), mLeavingDepth(0), mIsTerminal(false), mHasMultipleChars(false),
-              mHasChildren(false) {
+              mHasChildren(false), mDictionaryIndex(0) {
     }
 
     virtual ~DicNodeProperties() {}
@@ -43,7 +43,7 @@ class DicNodeProperties {
             const int siblingPos, const int nodeCodePoint, const int childrenCount,
             const int probability, const int bigramProbability, const bool isTerminal,
             const bool hasMultipleChars, const bool hasChildren, const uint16_t depth,
-            const uint16_t terminalDepth) {
+            const uint16_t terminalDepth, const int dictionaryIndex) {
         mPos = pos;
         mFlags = flags;
         mChildrenPos = childrenPos;
@@ -58,6 +58,7 @@ class DicNodeProperties {
         mHasChildren = hasChildren;
         mDepth = depth;
         mLeavingDepth = terminalDepth;
+        mDictionaryIndex = static_cast<uint8_t>(dictionaryIndex);
     }
 
     // Init for copy
@@ -76,6 +77,7 @@ class DicNodeProperties {
         mHasChildren = nodeProp->mHasChildren;
         mDepth = nodeProp->mDepth;
         mLeavingDepth = nodeProp->mLeavingDepth;
+        mDictionaryIndex = nodeProp->mDictionaryIndex;
     }
 
     // Init as passing child
@@ -94,6 +96,7 @@ class DicNodeProperties {
         mHasChildren = nodeProp->mHasChildren;
         mDepth = nodeProp->mDepth + 1; // Increment the depth of a passing child
         mLeavingDepth = nodeProp->mLeavingDepth;
+        mDictionaryIndex = nodeProp->mDictionaryIndex;
     }
 
     int getPos() const {
@@ -137,6 +140,11 @@ class DicNodeProperties {
         return mIsTerminal;
     }
 
+    // Index of the dictionary of the node among the ones searched together
+    int getDictionaryIndex() const {
+        return mDictionaryIndex;
+    }
+
     bool hasMultipleChars() const {
         return mHasMultipleChars;
     }
@@ -173,6 +181,7 @@ class DicNodeProperties {
     bool mIsTerminal;
     bool mHasMultipleChars;
     bool mHasChildren;
+    uint8_t mDictionaryIndex;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_PROPERTIES_H
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_SEARCH_STATE_MAP_H
+#define LATINIME_DIC_NODE_SEARCH_STATE_MAP_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+#include "dic_node.h"
+
+namespace latinime {
+
+/**
+ * Queued dic nodes by search state (see DicNode::isSameSearchState()), in a direct-mapped table:
+ * a node replaces the one of the same slot, so that a lookup reads one slot only. The rare nodes
+ * of the same state that are not found this way are merely not merged.
+ *
+ * The node of a slot may have been dropped from its queue since, or its buffer slot reused by
+ * another node, so the nodes found are checked against the searched state. Clearing only starts
+ * a new generation of slots, so that it does not depend on the capacity.
+ */
+class DicNodeSearchStateMap {
+ public:
+    AK_FORCE_INLINE DicNodeSearchStateMap() : mEntries(CAPACITY), mGeneration(1) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    AK_FORCE_INLINE ~DicNodeSearchStateMap() {}
+
+    AK_FORCE_INLINE void clear() {
+        ++mGeneration;
+        if (mGeneration == 0) {
+            // The generation wrapped around: slots of the new one may be left over.
+            for (int i = 0; i < CAPACITY; ++i) {
+                mEntries[i].mGeneration = 0;
+            }
+            mGeneration = 1;
+        }
+    }
+
+    // Returns the queued node at the same search state as dicNode, whose hash is stateHash, or
+    // null if there is none.
+    AK_FORCE_INLINE DicNode *find(const DicNode *const dicNode, const uint32_t stateHash) const {
+        const Entry *const entry = &mEntries[getIndex(stateHash)];
+        if (entry->mGeneration != mGeneration || entry->mStateHash != stateHash) {
+            return 0;
+        }
+        DicNode *const entryDicNode = entry->mDicNode;
+        return entryDicNode->isUsed() && entryDicNode->isSameSearchState(dicNode)
+                ? entryDicNode : 0;
+    }
+
+    // Adds dicNode, whose state hash is stateHash.
+    AK_FORCE_INLINE void put(DicNode *const dicNode, const uint32_t stateHash) {
+        Entry *const entry = &mEntries[getIndex(stateHash)];
+        entry->mDicNode = dicNode;
+        entry->mStateHash = stateHash;
+        entry->mGeneration = mGeneration;
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodeSearchStateMap);
+
+    struct Entry {
+        Entry() : mDicNode(0), mStateHash(0), mGeneration(0) {}
+
+        DicNode *mDicNode;
+        uint32_t mStateHash;
+        // The slot is used if this is the current generation.
+        uint32_t mGeneration;
+    };
+
+    static const int CAPACITY_BITS = 10;
+    static const int CAPACITY = 1 << CAPACITY_BITS;
+
+    std::vector<Entry> mEntries;
+    uint32_t mGeneration;
+
+    static AK_FORCE_INLINE int getIndex(const uint32_t stateHash) {
+        // Fibonacci hashing spreads the close positions of the lexicon.
+        return static_cast<int>((stateHash * 2654435769U) >> (32 - CAPACITY_BITS));
+    }
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_SEARCH_STATE_MAP_H
@@ -22,6 +22,7 @@
 #include "dic_node_state_output.h"
 #include "dic_node_state_prevword.h"
 #include "dic_node_state_scoring.h"
+#include "dic_node_word_arena.h"
 
 namespace latinime {
 
@@ -40,10 +41,11 @@ class DicNodeState {
     virtual ~DicNodeState() {}
 
     // Init with prevWordPos
-    void init(const int prevWordPos) {
+    void init(const int prevWordPos, const int16_t prevWordMaxBigramProbability,
+            DicNodeWordArena *const wordArena) {
         mDicNodeStateInput.init();
-        mDicNodeStateOutput.init();
-        mDicNodeStatePrevWord.init(prevWordPos);
+        mDicNodeStateOutput.init(wordArena);
+        mDicNodeStatePrevWord.init(prevWordPos, prevWordMaxBigramProbability);
         mDicNodeStateScoring.init();
     }
 
@@ -17,59 +17,162 @@
 #ifndef LATINIME_DIC_NODE_STATE_OUTPUT_H
 #define LATINIME_DIC_NODE_STATE_OUTPUT_H
 
-#include <cstring> // for memcpy()
 #include <stdint.h>
 
 #include "defines.h"
+#include "dic_node_word_arena.h"
 
 namespace latinime {
 
+/**
+ * Code points output by a dic node. They are stored in a DicNodeWordArena shared by all the nodes
+ * of the session, as a chain of segments that goes on from the chain of the previous words, so
+ * that copying this state only copies a handle. Indices are relative to the start of the current
+ * word: negative indices read the previous words.
+ */
 class DicNodeStateOutput {
  public:
-    DicNodeStateOutput() : mOutputtedLength(0) {
-        init();
+    DicNodeStateOutput()
+            : mWordArena(0), mLastSegment(DicNodeWordArena::NO_SEGMENT), mFirstCodePoint(0),
+              mOutputtedLength(0) {}
+
+    // Copies share the word arena.
+    DicNodeStateOutput(const DicNodeStateOutput &stateOutput)
+            : mWordArena(stateOutput.mWordArena), mLastSegment(stateOutput.mLastSegment),
+              mFirstCodePoint(stateOutput.mFirstCodePoint),
+              mOutputtedLength(stateOutput.mOutputtedLength) {}
+
+    DicNodeStateOutput &operator=(const DicNodeStateOutput &stateOutput) {
+        init(&stateOutput);
+        return *this;
     }
 
     virtual ~DicNodeStateOutput() {}
 
-    void init() {
+    void init(DicNodeWordArena *const wordArena) {
+        mWordArena = wordArena;
+        mLastSegment = DicNodeWordArena::NO_SEGMENT;
+        mFirstCodePoint = 0;
         mOutputtedLength = 0;
-        mWordBuf[0] = 0;
     }
 
     void init(const DicNodeStateOutput *const stateOutput) {
-        memcpy(mWordBuf, stateOutput->mWordBuf,
-                stateOutput->mOutputtedLength * sizeof(mWordBuf[0]));
+        mWordArena = stateOutput->mWordArena;
+        mLastSegment = stateOutput->mLastSegment;
+        mFirstCodePoint = stateOutput->mFirstCodePoint;
         mOutputtedLength = stateOutput->mOutputtedLength;
-        if (mOutputtedLength < MAX_WORD_LENGTH) {
-            mWordBuf[mOutputtedLength] = 0;
-        }
+    }
+
+    // Init for the next word: the first wordLength code points of the current word of
+    // stateOutput and separator become part of the previous words.
+    void init(const DicNodeStateOutput *const stateOutput, const int wordLength,
+            const int separator) {
+        mWordArena = stateOutput->mWordArena;
+        mLastSegment = mWordArena->append(stateOutput->mLastSegment,
+                stateOutput->getWordStartIndex() + wordLength, &separator, 1);
+        mFirstCodePoint = 0;
+        mOutputtedLength = 0;
     }
 
     void addSubword(const uint16_t additionalSubwordLength, const int *const additionalSubword) {
         if (additionalSubword) {
-            memcpy(&mWordBuf[mOutputtedLength], additionalSubword,
-                    additionalSubwordLength * sizeof(mWordBuf[0]));
-            mOutputtedLength = static_cast<uint16_t>(mOutputtedLength + additionalSubwordLength);
-            if (mOutputtedLength < MAX_WORD_LENGTH) {
-                mWordBuf[mOutputtedLength] = 0;
+            if (mOutputtedLength == 0 && additionalSubwordLength > 0) {
+                mFirstCodePoint = additionalSubword[0];
             }
+            mLastSegment = mWordArena->append(mLastSegment, getWordStartIndex() + mOutputtedLength,
+                    additionalSubword, additionalSubwordLength);
+            mOutputtedLength = static_cast<uint16_t>(mOutputtedLength + additionalSubwordLength);
+        }
+    }
+
+    // Must be called for every live node during a compaction of the word arena.
+    void relocateInWordArena() {
+        if (mWordArena) {
+            mLastSegment = mWordArena->relocateChain(mLastSegment);
+        }
+    }
+
+    // Makes the nodes created from this one append to wordArena, a region of the current one.
+    void setWordArena(DicNodeWordArena *const wordArena) {
+        mWordArena = wordArena;
+    }
+
+    // Must be called for every live node reading a region once it is merged into its base.
+    void moveToBaseWordArena() {
+        if (mWordArena) {
+            mLastSegment = mWordArena->getMergedSegment(mLastSegment);
+            mWordArena = mWordArena->getBaseArena();
         }
     }
 
+    DicNodeWordArena *getWordArena() const {
+        return mWordArena;
+    }
+
+    int getFirstCodePoint() const {
+        return mFirstCodePoint;
+    }
+
     // TODO: Remove
     int getCodePointAt(const int id) const {
-        return mWordBuf[id];
+        if (id >= mOutputtedLength) {
+            return 0;
+        }
+        return mWordArena->getCodePointAt(mLastSegment, getWordStartIndex() + id);
     }
 
-    // TODO: Move to private
-    int mWordBuf[MAX_WORD_LENGTH];
+    // Compares the first length code points of the current words. Returns the difference between
+    // the first pair of different code points (the other one minus this one), or 0 if there is
+    // none.
+    int compareCodePoints(const DicNodeStateOutput *const other, const int length) const {
+        if (length <= 0) {
+            return 0;
+        }
+        if (mFirstCodePoint != other->mFirstCodePoint) {
+            return other->mFirstCodePoint - mFirstCodePoint;
+        }
+        return mWordArena->compareCodePoints(mLastSegment, getWordStartIndex(),
+                other->mLastSegment, other->getWordStartIndex(), length);
+    }
+
+    // Whether the previous words and the current word are the same as the ones of other.
+    bool hasSameCodePoints(const DicNodeStateOutput *const other) const {
+        if (mOutputtedLength != other->mOutputtedLength
+                || mFirstCodePoint != other->mFirstCodePoint) {
+            return false;
+        }
+        if (!mWordArena || !other->mWordArena) {
+            return mWordArena == other->mWordArena;
+        }
+        const int length = mWordArena->getChainLength(mLastSegment);
+        return length == mWordArena->getChainLength(other->mLastSegment)
+                && mWordArena->compareCodePoints(mLastSegment, 0, other->mLastSegment, 0,
+                        length) == 0;
+    }
+
+    // Copies the code points from begin to end (excluded) to dest.
+    void outputCodePoints(const int begin, const int end, int *const dest) const {
+        if (begin >= end) {
+            return;
+        }
+        const int wordStartIndex = getWordStartIndex();
+        mWordArena->copyCodePoints(mLastSegment, wordStartIndex + begin, wordStartIndex + end,
+                dest);
+    }
 
  private:
     // Caution!!!
     // Use a default copy constructor and an assign operator because shallow copies are ok
     // for this class
+    DicNodeWordArena *mWordArena;
+    int mLastSegment;
+    // Cached as most words already differ there
+    int mFirstCodePoint;
     uint16_t mOutputtedLength;
+
+    AK_FORCE_INLINE int getWordStartIndex() const {
+        return mWordArena ? mWordArena->getChainLength(mLastSegment) - mOutputtedLength : 0;
+    }
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_STATE_OUTPUT_H
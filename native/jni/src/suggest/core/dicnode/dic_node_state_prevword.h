@@ -17,41 +17,40 @@
 #ifndef LATINIME_DIC_NODE_STATE_PREVWORD_H
 #define LATINIME_DIC_NODE_STATE_PREVWORD_H
 
-#include <cstring> // for memset()
 #include <stdint.h>
 
 #include "defines.h"
-#include "dic_node_utils.h"
+#include "dic_node_word_arena.h"
 
 namespace latinime {
 
+/**
+ * Previous words of a dic node. Their code points are the ones of DicNodeStateOutput before the
+ * current word. The input indices of the spaces between them are stored in the DicNodeWordArena
+ * too, as a chain of one entry per space.
+ */
 class DicNodeStatePrevWord {
  public:
     AK_FORCE_INLINE DicNodeStatePrevWord()
             : mPrevWordCount(0), mPrevWordLength(0), mPrevWordStart(0), mPrevWordProbability(0),
-              mPrevWordNodePos(0) {
-        memset(mPrevWord, 0, sizeof(mPrevWord));
-        memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
+              mMaxBigramProbability(NOT_A_PROBABILITY), mPrevWordNodePos(0),
+              mLastSpacePositionSegment(DicNodeWordArena::NO_SEGMENT) {
     }
 
     virtual ~DicNodeStatePrevWord() {}
 
     void init() {
-        mPrevWordLength = 0;
-        mPrevWordCount = 0;
-        mPrevWordStart = 0;
-        mPrevWordProbability = -1;
-        mPrevWordNodePos = NOT_VALID_WORD;
-        memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
+        init(NOT_VALID_WORD, NOT_A_PROBABILITY);
     }
 
-    void init(const int prevWordNodePos) {
+    void init(const int prevWordNodePos, const int16_t maxBigramProbability) {
         mPrevWordLength = 0;
         mPrevWordCount = 0;
         mPrevWordStart = 0;
         mPrevWordProbability = -1;
+        mMaxBigramProbability = maxBigramProbability;
         mPrevWordNodePos = prevWordNodePos;
-        memset(mPrevSpacePositions, 0, sizeof(mPrevSpacePositions));
+        mLastSpacePositionSegment = DicNodeWordArena::NO_SEGMENT;
     }
 
     // Init by copy
@@ -60,43 +59,59 @@ class DicNodeStatePrevWord {
         mPrevWordCount = prevWord->mPrevWordCount;
         mPrevWordStart = prevWord->mPrevWordStart;
         mPrevWordProbability = prevWord->mPrevWordProbability;
+        mMaxBigramProbability = prevWord->mMaxBigramProbability;
         mPrevWordNodePos = prevWord->mPrevWordNodePos;
-        memcpy(mPrevWord, prevWord->mPrevWord, prevWord->mPrevWordLength * sizeof(mPrevWord[0]));
-        memcpy(mPrevSpacePositions, prevWord->mPrevSpacePositions, sizeof(mPrevSpacePositions));
+        mLastSpacePositionSegment = prevWord->mLastSpacePositionSegment;
     }
 
-    void init(const int16_t prevWordCount, const int16_t prevWordProbability,
-            const int prevWordNodePos, const int *const src0, const int16_t length0,
-            const int *const src1, const int16_t length1, const int *const prevSpacePositions,
-            const int lastInputIndex) {
-        mPrevWordCount = prevWordCount;
+    // Init for the next word, after a word of wordLength code points and a space.
+    void init(const DicNodeStatePrevWord *const prevWord, const int16_t prevWordProbability,
+            const int16_t maxBigramProbability, const int prevWordNodePos, const int wordLength,
+            const int lastInputIndex, DicNodeWordArena *const wordArena) {
+        mPrevWordCount = static_cast<int16_t>(prevWord->mPrevWordCount + 1);
         mPrevWordProbability = prevWordProbability;
+        mMaxBigramProbability = maxBigramProbability;
         mPrevWordNodePos = prevWordNodePos;
-        const int twoWordsLen =
-                DicNodeUtils::appendTwoWords(src0, length0, src1, length1, mPrevWord);
-        mPrevWord[twoWordsLen] = KEYCODE_SPACE;
-        mPrevWordStart = length0;
-        mPrevWordLength = static_cast<int16_t>(twoWordsLen + 1);
-        memcpy(mPrevSpacePositions, prevSpacePositions, sizeof(mPrevSpacePositions));
-        mPrevSpacePositions[mPrevWordCount - 1] = lastInputIndex;
+        mPrevWordStart = prevWord->mPrevWordLength;
+        mPrevWordLength = static_cast<int16_t>(prevWord->mPrevWordLength + wordLength + 1);
+        mLastSpacePositionSegment = prevWord->mLastSpacePositionSegment;
+        if (mPrevWordCount <= MAX_RESULTS) {
+            mLastSpacePositionSegment = wordArena->append(mLastSpacePositionSegment,
+                    mPrevWordCount - 1, &lastInputIndex, 1);
+        }
+    }
+
+    // Must be called for every live node during a compaction of the word arena.
+    void relocateInWordArena(DicNodeWordArena *const wordArena) {
+        if (wordArena) {
+            mLastSpacePositionSegment = wordArena->relocateChain(mLastSpacePositionSegment);
+        }
+    }
+
+    // Must be called for every live node reading a region once it is merged into its base.
+    void moveToBaseWordArena(const DicNodeWordArena *const wordArena) {
+        if (wordArena) {
+            mLastSpacePositionSegment = wordArena->getMergedSegment(mLastSpacePositionSegment);
+        }
     }
 
     void truncate(const int offset) {
-        // TODO: memmove
         if (mPrevWordLength < offset) {
-            memset(mPrevWord, 0, sizeof(mPrevWord));
             mPrevWordLength = 0;
             return;
         }
-        const int newPrevWordLength = mPrevWordLength - offset;
-        memmove(mPrevWord, &mPrevWord[offset], newPrevWordLength * sizeof(mPrevWord[0]));
-        mPrevWordLength = newPrevWordLength;
+        // The previous words end where the current word starts, so dropping their first code
+        // points only needs a shorter length.
+        mPrevWordLength = static_cast<int16_t>(mPrevWordLength - offset);
     }
 
-    void outputSpacePositions(int *spaceIndices) const {
-        // Convert uint16_t to int
-        for (int i = 0; i < MAX_RESULTS; i++) {
-            spaceIndices[i] = mPrevSpacePositions[i];
+    void outputSpacePositions(const DicNodeWordArena *const wordArena, int *spaceIndices) const {
+        const int count = wordArena ? wordArena->getChainLength(mLastSpacePositionSegment) : 0;
+        if (count > 0) {
+            wordArena->copyCodePoints(mLastSpacePositionSegment, 0, count, spaceIndices);
+        }
+        for (int i = count; i < MAX_RESULTS; i++) {
+            spaceIndices[i] = 0;
         }
     }
 
@@ -117,31 +132,15 @@ class DicNodeStatePrevWord {
         return mPrevWordProbability;
     }
 
-    int getPrevWordNodePos() const {
-        return mPrevWordNodePos;
-    }
-
-    int getPrevWordCodePointAt(const int id) const {
-        return mPrevWord[id];
+    // The highest probability of a bigram of the previous word, or NOT_A_PROBABILITY.
+    int16_t getMaxBigramProbability() const {
+        return mMaxBigramProbability;
     }
 
-    bool startsWith(const DicNodeStatePrevWord *const prefix, const int prefixLen) const {
-        if (prefixLen > mPrevWordLength) {
-            return false;
-        }
-        for (int i = 0; i < prefixLen; ++i) {
-            if (mPrevWord[i] != prefix->mPrevWord[i]) {
-                return false;
-            }
-        }
-        return true;
+    int getPrevWordNodePos() const {
+        return mPrevWordNodePos;
     }
 
-    // TODO: Move to private
-    int mPrevWord[MAX_WORD_LENGTH];
-    // TODO: Move to private
-    int mPrevSpacePositions[MAX_RESULTS];
-
  private:
     // Caution!!!
     // Use a default copy constructor and an assign operator because shallow copies are ok
@@ -150,7 +149,9 @@ class DicNodeStatePrevWord {
     int16_t mPrevWordLength;
     int16_t mPrevWordStart;
     int16_t mPrevWordProbability;
+    int16_t mMaxBigramProbability;
     int mPrevWordNodePos;
+    int mLastSpacePositionSegment;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_STATE_PREVWORD_H
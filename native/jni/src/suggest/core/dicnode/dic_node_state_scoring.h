@@ -31,7 +31,7 @@ class DicNodeStateScoring {
               mDigraphIndex(DigraphUtils::NOT_A_DIGRAPH_INDEX),
               mEditCorrectionCount(0), mProximityCorrectionCount(0),
               mNormalizedCompoundDistance(0.0f), mSpatialDistance(0.0f), mLanguageDistance(0.0f),
-              mRawLength(0.0f), mExactMatch(true) {
+              mLanguageLookAheadCost(0.0f), mRawLength(0.0f), mExactMatch(true) {
     }
 
     virtual ~DicNodeStateScoring() {}
@@ -42,6 +42,7 @@ class DicNodeStateScoring {
         mNormalizedCompoundDistance = 0.0f;
         mSpatialDistance = 0.0f;
         mLanguageDistance = 0.0f;
+        mLanguageLookAheadCost = 0.0f;
         mRawLength = 0.0f;
         mDoubleLetterLevel = NOT_A_DOUBLE_LETTER;
         mDigraphIndex = DigraphUtils::NOT_A_DIGRAPH_INDEX;
@@ -54,6 +55,7 @@ class DicNodeStateScoring {
         mNormalizedCompoundDistance = scoring->mNormalizedCompoundDistance;
         mSpatialDistance = scoring->mSpatialDistance;
         mLanguageDistance = scoring->mLanguageDistance;
+        mLanguageLookAheadCost = scoring->mLanguageLookAheadCost;
         mRawLength = scoring->mRawLength;
         mDoubleLetterLevel = scoring->mDoubleLetterLevel;
         mDigraphIndex = scoring->mDigraphIndex;
@@ -86,6 +88,14 @@ class DicNodeStateScoring {
         }
     }
 
+    // A lower bound of the language cost still to come. It replaces the previous one and only
+    // counts for the ranking of the node, not in its compound distance.
+    void setLanguageLookAheadCost(const float languageLookAheadCost, const bool doNormalization,
+            const int totalInputIndex) {
+        mLanguageLookAheadCost = languageLookAheadCost;
+        updateNormalizedCompoundDistance(doNormalization, totalInputIndex);
+    }
+
     void addRawLength(const float rawLength) {
         mRawLength += rawLength;
     }
@@ -98,6 +108,7 @@ class DicNodeStateScoring {
         return mSpatialDistance + mLanguageDistance * languageWeight;
     }
 
+    // Includes the language look-ahead cost
     float getNormalizedCompoundDistance() const {
         return mNormalizedCompoundDistance;
     }
@@ -176,6 +187,7 @@ class DicNodeStateScoring {
     float mNormalizedCompoundDistance;
     float mSpatialDistance;
     float mLanguageDistance;
+    float mLanguageLookAheadCost;
     float mRawLength;
     bool mExactMatch;
 
@@ -183,11 +195,18 @@ class DicNodeStateScoring {
             bool doNormalization, int inputSize, int totalInputIndex) {
         mSpatialDistance += spatialDistance;
         mLanguageDistance += languageDistance;
+        updateNormalizedCompoundDistance(doNormalization, totalInputIndex);
+    }
+
+    AK_FORCE_INLINE void updateNormalizedCompoundDistance(const bool doNormalization,
+            const int totalInputIndex) {
+        const float rankingDistance =
+                mSpatialDistance + mLanguageDistance + mLanguageLookAheadCost;
         if (!doNormalization) {
-            mNormalizedCompoundDistance = mSpatialDistance + mLanguageDistance;
+            mNormalizedCompoundDistance = rankingDistance;
         } else {
-            mNormalizedCompoundDistance = (mSpatialDistance + mLanguageDistance)
-                    / static_cast<float>(max(1, totalInputIndex));
+            mNormalizedCompoundDistance =
+                    rankingDistance / static_cast<float>(max(1, totalInputIndex));
         }
     }
 };
@@ -18,14 +18,15 @@
 #define LATINIME_DIC_NODE_UTILS_H
 
 #include <stdint.h>
-#include <vector>
 
 #include "defines.h"
+#include "proximity_info_state_utils.h"
 
 namespace latinime {
 
 class DicNode;
 class DicNodeVector;
+class DicNodeWordArena;
 class ProximityInfo;
 class ProximityInfoState;
 class MultiBigramMap;
@@ -35,18 +36,25 @@ class DicNodeUtils {
     static int appendTwoWords(const int *src0, const int16_t length0, const int *src1,
             const int16_t length1, int *dest);
     static void initAsRoot(const int rootPos, const uint8_t *const dicRoot,
-            const int prevWordNodePos, DicNode *newRootNode);
+            const int prevWordNodePos, const int prevWordMaxBigramProbability,
+            const int dictionaryIndex, DicNodeWordArena *const wordArena, DicNode *newRootNode);
     static void initAsRootWithPreviousWord(const int rootPos, const uint8_t *const dicRoot,
-            DicNode *prevWordLastNode, DicNode *newRootNode);
+            DicNode *prevWordLastNode, const int prevWordMaxBigramProbability,
+            DicNode *newRootNode);
     static void initByCopy(DicNode *srcNode, DicNode *destNode);
     static void getAllChildDicNodes(DicNode *dicNode, const uint8_t *const dicRoot,
+            const bool supportsDynamicUpdate, const int headerSize,
             DicNodeVector *childDicNodes);
     static float getBigramNodeImprobability(const uint8_t *const dicRoot,
-            const DicNode *const node, MultiBigramMap *const multiBigramMap);
+            const bool supportsDynamicUpdate, const DicNode *const node,
+            MultiBigramMap *const multiBigramMap);
+    // Returns whether no key of nodeCodePoint is in searchKeys, the ids of the keys to search.
+    // Nothing is filtered out without a keyboard or search keys.
     static bool isDicNodeFilteredOut(const int nodeCodePoint, const ProximityInfo *const pInfo,
-            const std::vector<int> *const codePointsFilter);
+            const ProximityInfoStateUtils::NearKeycodesSet *const searchKeys);
     // TODO: Move to private
     static void getProximityChildDicNodes(DicNode *dicNode, const uint8_t *const dicRoot,
+            const bool supportsDynamicUpdate, const int headerSize,
             const ProximityInfoState *pInfoState, const int pointIndex, bool exactOnly,
             DicNodeVector *childDicNodes);
 
@@ -60,19 +68,9 @@ class DicNodeUtils {
     // Max number of bigrams to look up
     static const int MAX_BIGRAMS_CONSIDERED_PER_CONTEXT = 500;
 
-    static int getBigramNodeProbability(const uint8_t *const dicRoot, const DicNode *const node,
+    static int getBigramNodeProbability(const uint8_t *const dicRoot,
+            const bool supportsDynamicUpdate, const DicNode *const node,
             MultiBigramMap *multiBigramMap);
-    static void createAndGetPassingChildNode(DicNode *dicNode, const ProximityInfoState *pInfoState,
-            const int pointIndex, const bool exactOnly, DicNodeVector *childDicNodes);
-    static void createAndGetAllLeavingChildNodes(DicNode *dicNode, const uint8_t *const dicRoot,
-            const ProximityInfoState *pInfoState, const int pointIndex, const bool exactOnly,
-            const std::vector<int> *const codePointsFilter,
-            const ProximityInfo *const pInfo, DicNodeVector *childDicNodes);
-    static int createAndGetLeavingChildNode(DicNode *dicNode, int pos, const uint8_t *const dicRoot,
-            const int terminalDepth, const ProximityInfoState *pInfoState, const int pointIndex,
-            const bool exactOnly, const std::vector<int> *const codePointsFilter,
-            const ProximityInfo *const pInfo, DicNodeVector *childDicNodes);
-
     // TODO: Move to proximity info
     static bool isMatchedNodeCodePoint(const ProximityInfoState *pInfoState, const int pointIndex,
             const bool exactOnly, const int nodeCodePoint);
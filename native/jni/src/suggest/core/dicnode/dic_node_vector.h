@@ -21,6 +21,7 @@
 
 #include "defines.h"
 #include "dic_node.h"
+#include "dic_node_child_iterator.h"
 
 namespace latinime {
 
@@ -56,23 +57,11 @@ class DicNodeVector {
         return mDicNodes.size() >= limit;
     }
 
-    void pushPassingChild(DicNode *dicNode) {
+    // Pushes the current child of childIterator, an iterator over the children of dicNode.
+    void pushChild(DicNode *dicNode, const DicNodeChildIterator *const childIterator) {
         ASSERT(!mLock);
         mDicNodes.push_back(mEmptyNode);
-        mDicNodes.back().initAsPassingChild(dicNode);
-    }
-
-    void pushLeavingChild(DicNode *dicNode, const int pos, const uint8_t flags,
-            const int childrenPos, const int attributesPos, const int siblingPos,
-            const int nodeCodePoint, const int childrenCount, const int probability,
-            const int bigramProbability, const bool isTerminal, const bool hasMultipleChars,
-            const bool hasChildren, const uint16_t additionalSubwordLength,
-            const int *additionalSubword) {
-        ASSERT(!mLock);
-        mDicNodes.push_back(mEmptyNode);
-        mDicNodes.back().initAsChild(dicNode, pos, flags, childrenPos, attributesPos, siblingPos,
-                nodeCodePoint, childrenCount, probability, -1 /* bigramProbability */, isTerminal,
-                hasMultipleChars, hasChildren, additionalSubwordLength, additionalSubword);
+        childIterator->initChildDicNode(dicNode, &mDicNodes.back());
     }
 
     DicNode *operator[](const int id) {
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_WORD_ARENA_H
+#define LATINIME_DIC_NODE_WORD_ARENA_H
+
+#include <cstring> // for memcpy()
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Append-only storage of the code points output by dic nodes, shared by all the nodes of a
+ * traverse session. Each node appends only the code points it adds, as a segment linked to the
+ * segment of its parent, and keeps the handle of its last segment. A chain of segments is then a
+ * string in which every segment holds the code points from its start index on; indices before
+ * it are read from its parent. Nodes sharing a prefix share its segments, so copying a node does
+ * not copy its word.
+ *
+ * Handles are offsets in the buffer, so that they stay valid when the buffer grows. They are all
+ * invalidated by clear(). As the segments of discarded nodes are never reused, the arena is
+ * compacted between two continued searches: every live chain is relocated as a single segment.
+ *
+ * To let several threads append at the same time, an arena can reserve regions of its buffer,
+ * each of which is then appended to through another arena started with startRegion(). Both read
+ * the same buffer, which must not grow meanwhile. A region that is full fails its appends instead
+ * of growing. mergeRegion() then moves the segments of a region right after the used ones, where
+ * getMergedSegment() of the region finds them.
+ */
+class DicNodeWordArena {
+ public:
+    static const int NO_SEGMENT = -1;
+
+    AK_FORCE_INLINE DicNodeWordArena()
+            : mBuffer(), mCompactionBuffer(), mSegments(0), mUsedSize(0), mCapacity(0),
+              mBaseArena(0), mRegionStart(0), mMergeShift(0), mHasOverflowed(false) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    AK_FORCE_INLINE ~DicNodeWordArena() {}
+
+    void clear() {
+        mUsedSize = 0;
+    }
+
+    // Moves all the segments aside. Each live chain then has to be moved back with
+    // relocateChain() before calling finishCompaction().
+    void startCompaction() {
+        mBuffer.swap(mCompactionBuffer);
+        setBuffer();
+        mUsedSize = 0;
+    }
+
+    // Returns the new handle of the chain that ended with segment before startCompaction().
+    int relocateChain(const int segment) {
+        if (segment == NO_SEGMENT) {
+            return NO_SEGMENT;
+        }
+        const int *const compactedSegments = &mCompactionBuffer[0];
+        const int length = getChainLength(compactedSegments, segment);
+        const int newSegment = allocateSegment(NO_SEGMENT, 0 /* startIndex */, length);
+        copyCodePoints(compactedSegments, segment, 0, length,
+                mSegments + newSegment + SEGMENT_HEADER_SIZE);
+        return newSegment;
+    }
+
+    void finishCompaction() {
+        // The buffer moved aside is kept for the next compaction.
+    }
+
+    // Reserves regionCount regions of regionSize ints after the used segments. Returns the start
+    // of the first one; the others follow.
+    int reserveRegions(const int regionCount, const int regionSize) {
+        ensureCapacity(mUsedSize + regionCount * regionSize);
+        return mUsedSize;
+    }
+
+    // Empties this arena and makes it append to the region of baseArena that starts at
+    // regionStart.
+    void startRegion(DicNodeWordArena *const baseArena, const int regionStart,
+            const int regionSize) {
+        mBaseArena = baseArena;
+        mSegments = baseArena->mSegments;
+        mRegionStart = regionStart;
+        mUsedSize = regionStart;
+        mCapacity = regionStart + regionSize;
+        mMergeShift = 0;
+        mHasOverflowed = false;
+    }
+
+    // Whether an append has failed since startRegion(), as the region was full.
+    bool hasOverflowed() const {
+        return mHasOverflowed;
+    }
+
+    // Moves the segments of region, a region of this arena, right after the used segments. The
+    // regions have to be merged in the order they were reserved, before appending to this arena.
+    void mergeRegion(DicNodeWordArena *const region) {
+        const int mergedStart = mUsedSize;
+        const int length = region->mUsedSize - region->mRegionStart;
+        region->mMergeShift = mergedStart - region->mRegionStart;
+        memmove(mSegments + mergedStart, mSegments + region->mRegionStart,
+                length * sizeof(mSegments[0]));
+        mUsedSize += length;
+        for (int segment = mergedStart; segment < mUsedSize;
+                segment += SEGMENT_HEADER_SIZE + mSegments[segment + LENGTH_OFFSET]) {
+            mSegments[segment + PARENT_OFFSET] =
+                    region->getMergedSegment(mSegments[segment + PARENT_OFFSET]);
+        }
+    }
+
+    // Returns the handle of segment once this region is merged into its base arena.
+    int getMergedSegment(const int segment) const {
+        return segment < mRegionStart ? segment : segment + mMergeShift;
+    }
+
+    DicNodeWordArena *getBaseArena() const {
+        return mBaseArena;
+    }
+
+    int getUsedSize() const {
+        return mUsedSize;
+    }
+
+    // Appends codePoints as the chain indices from startIndex on, after the chain of parent.
+    // Returns the handle of the new segment, or NO_SEGMENT if a region is full.
+    AK_FORCE_INLINE int append(const int parent, const int startIndex, const int *const codePoints,
+            const int length) {
+        const int segment = allocateSegment(parent, startIndex, length);
+        if (segment != NO_SEGMENT) {
+            memcpy(mSegments + segment + SEGMENT_HEADER_SIZE, codePoints,
+                    length * sizeof(mSegments[0]));
+        }
+        return segment;
+    }
+
+    // Returns the length of the chain ending with segment.
+    AK_FORCE_INLINE int getChainLength(const int segment) const {
+        return getChainLength(mSegments, segment);
+    }
+
+    // Returns the code point at index in the chain ending with segment, or 0 if there is none.
+    AK_FORCE_INLINE int getCodePointAt(int segment, const int index) const {
+        if (index < 0 || index >= getChainLength(segment)) {
+            return 0;
+        }
+        while (index < mSegments[segment + START_INDEX_OFFSET]) {
+            segment = mSegments[segment + PARENT_OFFSET];
+        }
+        return mSegments[segment + SEGMENT_HEADER_SIZE + index
+                - mSegments[segment + START_INDEX_OFFSET]];
+    }
+
+    // Copies the code points from begin to end (excluded) of the chain ending with segment to
+    // dest.
+    void copyCodePoints(const int segment, const int begin, const int end,
+            int *const dest) const {
+        copyCodePoints(mSegments, segment, begin, end, dest);
+    }
+
+    // Compares length code points of the chain ending with segment from begin with the ones of
+    // the chain ending with otherSegment from otherBegin. Returns the difference between the
+    // first pair of different code points (the other one minus this one), or 0 if there is none.
+    // Parts shared by both chains are not read.
+    int compareCodePoints(const int segment, const int begin, const int otherSegment,
+            const int otherBegin, const int length) const {
+        int skippedLength = 0;
+        if (begin == otherBegin) {
+            skippedLength = max(0, getSharedLength(segment, otherSegment) - begin);
+            if (skippedLength >= length) {
+                return 0;
+            }
+        }
+        for (int i = skippedLength; i < length; ++i) {
+            const int codePoint = getCodePointAt(segment, begin + i);
+            const int otherCodePoint = getCodePointAt(otherSegment, otherBegin + i);
+            if (codePoint != otherCodePoint) {
+                return otherCodePoint - codePoint;
+            }
+        }
+        return 0;
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodeWordArena);
+
+    static const int INITIAL_CAPACITY = 64 * 1024;
+    static const int PARENT_OFFSET = 0;
+    static const int START_INDEX_OFFSET = 1;
+    static const int LENGTH_OFFSET = 2;
+    static const int SEGMENT_HEADER_SIZE = 3;
+
+    // Owned segments, if this arena is not a region of another one. Its size is the capacity.
+    std::vector<int> mBuffer;
+    // Segments being compacted
+    std::vector<int> mCompactionBuffer;
+    // The segments read and appended to, which are the ones of the base arena for a region
+    int *mSegments;
+    int mUsedSize;
+    int mCapacity;
+
+    // Only for a region
+    DicNodeWordArena *mBaseArena;
+    int mRegionStart;
+    // Shift of the handles of the region once merged into its base
+    int mMergeShift;
+    bool mHasOverflowed;
+
+    AK_FORCE_INLINE void setBuffer() {
+        mSegments = mBuffer.empty() ? 0 : &mBuffer[0];
+        mCapacity = static_cast<int>(mBuffer.size());
+    }
+
+    void ensureCapacity(const int capacity) {
+        if (capacity > mCapacity) {
+            const int grownCapacity = mCapacity > 0 ? mCapacity * 2 : INITIAL_CAPACITY;
+            mBuffer.resize(max(capacity, grownCapacity));
+            setBuffer();
+        }
+    }
+
+    AK_FORCE_INLINE int allocateSegment(const int parent, const int startIndex, const int length) {
+        const int segment = mUsedSize;
+        const int usedSize = segment + SEGMENT_HEADER_SIZE + length;
+        if (usedSize > mCapacity) {
+            if (mBaseArena) {
+                mHasOverflowed = true;
+                return NO_SEGMENT;
+            }
+            ensureCapacity(usedSize);
+        }
+        mUsedSize = usedSize;
+        mSegments[segment + PARENT_OFFSET] = parent;
+        mSegments[segment + START_INDEX_OFFSET] = startIndex;
+        mSegments[segment + LENGTH_OFFSET] = length;
+        return segment;
+    }
+
+    // Returns a length up to which both chains read the same segments, hence hold the same code
+    // points. This is usually where they diverge, but may be less.
+    int getSharedLength(int segment, int otherSegment) const {
+        int sharedLength = S_INT_MAX;
+        while (segment != otherSegment) {
+            const int startIndex =
+                    segment == NO_SEGMENT ? -1 : mSegments[segment + START_INDEX_OFFSET];
+            const int otherStartIndex = otherSegment == NO_SEGMENT
+                    ? -1 : mSegments[otherSegment + START_INDEX_OFFSET];
+            if (startIndex >= otherStartIndex) {
+                sharedLength = min(sharedLength, startIndex);
+                segment = mSegments[segment + PARENT_OFFSET];
+            } else {
+                sharedLength = min(sharedLength, otherStartIndex);
+                otherSegment = mSegments[otherSegment + PARENT_OFFSET];
+            }
+        }
+        return segment == NO_SEGMENT ? 0 : sharedLength;
+    }
+
+    static AK_FORCE_INLINE int getChainLength(const int *const segments, const int segment) {
+        if (segment == NO_SEGMENT) {
+            return 0;
+        }
+        return segments[segment + START_INDEX_OFFSET] + segments[segment + LENGTH_OFFSET];
+    }
+
+    static void copyCodePoints(const int *const segments, int segment, const int begin,
+            const int end, int *const dest) {
+        int limit = end;
+        while (segment != NO_SEGMENT && begin < limit) {
+            const int startIndex = segments[segment + START_INDEX_OFFSET];
+            const int from = max(startIndex, begin);
+            const int to = min(startIndex + segments[segment + LENGTH_OFFSET], limit);
+            if (from < to) {
+                memcpy(&dest[from - begin], &segments[segment + SEGMENT_HEADER_SIZE + from
+                        - startIndex], (to - from) * sizeof(dest[0]));
+            }
+            limit = min(limit, startIndex);
+            segment = segments[segment + PARENT_OFFSET];
+        }
+    }
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_WORD_ARENA_H
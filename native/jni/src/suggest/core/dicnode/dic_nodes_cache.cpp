@@ -23,15 +23,73 @@
 
 namespace latinime {
 
+// Initialization of class constants.
+const int DicNodesCache::MAX_CHECKPOINT_COUNT = 16;
+
+void DicNodesCache::continueSearch(DicNodeWordArena *const wordArena) {
+    resetTemporaryCaches();
+    // The dic nodes of the checkpoints are the only live ones now.
+    wordArena->startCompaction();
+    for (size_t i = 0; i < mCheckpointDicNodes.size(); ++i) {
+        mCheckpointDicNodes[i].relocateInWordArena();
+    }
+    wordArena->finishCompaction();
+    const int checkpointIndex = static_cast<int>(mCheckpointInputIndices.size()) - 1;
+    mInputIndex = mCheckpointInputIndices[checkpointIndex];
+    for (int i = mCheckpointStarts[checkpointIndex];
+            i < static_cast<int>(mCheckpointDicNodes.size()); ++i) {
+        mActiveDicNodes->copyPush(&mCheckpointDicNodes[i]);
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("Continue from %d nodes. inputIndex = %d.", mActiveDicNodes->getSize(),
+                mInputIndex);
+    }
+}
+
+void DicNodesCache::saveCheckpoint() {
+    if (!mCheckpointInputIndices.empty() && mCheckpointInputIndices.back() >= mInputIndex) {
+        return;
+    }
+    if (static_cast<int>(mCheckpointInputIndices.size()) >= MAX_CHECKPOINT_COUNT) {
+        const int droppedSize = mCheckpointStarts[1];
+        mCheckpointDicNodes.erase(mCheckpointDicNodes.begin(),
+                mCheckpointDicNodes.begin() + droppedSize);
+        mCheckpointInputIndices.erase(mCheckpointInputIndices.begin());
+        mCheckpointStarts.erase(mCheckpointStarts.begin());
+        for (size_t i = 0; i < mCheckpointStarts.size(); ++i) {
+            mCheckpointStarts[i] -= droppedSize;
+        }
+    }
+    mCheckpointInputIndices.push_back(mInputIndex);
+    mCheckpointStarts.push_back(static_cast<int>(mCheckpointDicNodes.size()));
+    const int activeSize = mActiveDicNodes->getSize();
+    for (int i = 0; i < activeSize; ++i) {
+        mCheckpointDicNodes.push_back(*mActiveDicNodes->getDicNodeAt(i));
+    }
+}
+
+void DicNodesCache::copyPushNextActive(DicNode *dicNode) {
+    DicNode *pushedDicNode = mNextActiveDicNodes->copyPushMergingSearchState(dicNode);
+    if (!pushedDicNode) {
+        if (dicNode->isCached()) {
+            dicNode->remove();
+        }
+        // We simply drop any dic node that was not cached, ignoring the slim chance
+        // that one of its children represents what the user really wanted.
+    }
+}
+
 /**
- * Truncates all of the dicNodes so that they start at the given commit point.
+ * Truncates all of the active dicNodes so that they start at the given commit point. The
+ * checkpoints are dropped, as their input indices are from before it.
  * Only called for multi-word typing input.
  */
 DicNode *DicNodesCache::setCommitPoint(int commitPoint) {
+    clearCheckpoints();
     std::list<DicNode> dicNodesList;
-    while (mCachedDicNodesForContinuousSuggestion->getSize() > 0) {
+    while (mActiveDicNodes->getSize() > 0) {
         DicNode dicNode;
-        mCachedDicNodesForContinuousSuggestion->copyPop(&dicNode);
+        mActiveDicNodes->copyPop(&dicNode);
         dicNodesList.push_front(dicNode);
     }
 
@@ -46,7 +104,7 @@ DicNode *DicNodesCache::setCommitPoint(int commitPoint) {
     for (iter = dicNodesList.begin(); iter != dicNodesList.end(); iter++) {
         DicNode *dicNode = &*iter;
         if (dicNode->truncateNode(&topDicNodeCopy, commitPoint)) {
-            mCachedDicNodesForContinuousSuggestion->copyPush(dicNode);
+            mActiveDicNodes->copyPush(dicNode);
         } else {
             // Top dicNode should be reprocessed.
             ASSERT(dicNode != topDicNode);
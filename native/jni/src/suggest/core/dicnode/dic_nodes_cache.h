@@ -18,22 +18,27 @@
 #define LATINIME_DIC_NODES_CACHE_H
 
 #include <stdint.h>
+#include <vector>
 
 #include "defines.h"
+#include "dic_node.h"
 #include "dic_node_priority_queue.h"
+#include "dic_node_word_arena.h"
 
 #define INITIAL_QUEUE_ID_ACTIVE 0
 #define INITIAL_QUEUE_ID_NEXT_ACTIVE 1
 #define INITIAL_QUEUE_ID_TERMINAL 2
-#define INITIAL_QUEUE_ID_CACHE_FOR_CONTINUOUS_SUGGESTION 3
-#define PRIORITY_QUEUES_SIZE 4
+#define PRIORITY_QUEUES_SIZE 3
 
 namespace latinime {
 
-class DicNode;
-
 /**
  * Class for controlling dicNode search priority queue and lexicon trie traversal.
+ *
+ * The active dic nodes at the start of input indices are saved as checkpoints, in increasing
+ * index order, so that a search for an input that shares points with the previous one continues
+ * from the last checkpoint that is still valid for it instead of from the root, whether points
+ * were added or removed.
  */
 class DicNodesCache {
  public:
@@ -41,27 +46,48 @@ class DicNodesCache {
             : mActiveDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_ACTIVE]),
               mNextActiveDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_NEXT_ACTIVE]),
               mTerminalDicNodes(&mDicNodePriorityQueues[INITIAL_QUEUE_ID_TERMINAL]),
-              mCachedDicNodesForContinuousSuggestion(
-                      &mDicNodePriorityQueues[INITIAL_QUEUE_ID_CACHE_FOR_CONTINUOUS_SUGGESTION]),
-              mInputIndex(0), mLastCachedInputIndex(0) {
+              mInputIndex(0), mCheckpointDicNodes(), mCheckpointInputIndices(),
+              mCheckpointStarts() {
     }
 
     AK_FORCE_INLINE virtual ~DicNodesCache() {}
 
     AK_FORCE_INLINE void reset(const int nextActiveSize, const int terminalSize) {
         mInputIndex = 0;
-        mLastCachedInputIndex = 0;
         mActiveDicNodes->reset();
         mNextActiveDicNodes->clearAndResize(nextActiveSize);
         mTerminalDicNodes->clearAndResize(terminalSize);
-        mCachedDicNodesForContinuousSuggestion->reset();
+        clearCheckpoints();
+    }
+
+    void clearCheckpoints() {
+        mCheckpointDicNodes.clear();
+        mCheckpointInputIndices.clear();
+        mCheckpointStarts.clear();
     }
 
-    AK_FORCE_INLINE void continueSearch() {
-        resetTemporaryCaches();
-        restoreActiveDicNodesFromCache();
+    // Drops the checkpoints of the input indices after maxInputIndex. Returns whether one is left
+    // to continue the search from.
+    bool dropCheckpointsAfter(const int maxInputIndex) {
+        int count = static_cast<int>(mCheckpointInputIndices.size());
+        while (count > 0 && mCheckpointInputIndices[count - 1] > maxInputIndex) {
+            --count;
+        }
+        if (count < static_cast<int>(mCheckpointInputIndices.size())) {
+            mCheckpointDicNodes.resize(mCheckpointStarts[count]);
+            mCheckpointInputIndices.resize(count);
+            mCheckpointStarts.resize(count);
+        }
+        return count > 0;
     }
 
+    // Continues the search from the dic nodes of the last checkpoint.
+    void continueSearch(DicNodeWordArena *const wordArena);
+
+    // Saves the active dic nodes as the checkpoint of the current input index, unless there is
+    // one already.
+    void saveCheckpoint();
+
     AK_FORCE_INLINE void advanceActiveDicNodes() {
         if (DEBUG_DICT) {
             AKLOGI("Advance active %d nodes.", mNextActiveDicNodes->getSize());
@@ -77,6 +103,15 @@ class DicNodesCache {
 
     int activeSize() const { return mActiveDicNodes->getSize(); }
     int terminalSize() const { return mTerminalDicNodes->getSize(); }
+    const DicNode *getActiveDicNodeAt(const int index) const {
+        return mActiveDicNodes->getDicNodeAt(index);
+    }
+    // Returns the worst terminal, or null until as many terminals as are kept were found: only
+    // then does a new terminal have to beat it to be kept.
+    const DicNode *peekWorstKeptTerminal() const {
+        return mTerminalDicNodes->getSize() < mTerminalDicNodes->getMaxSize()
+                ? 0 : mTerminalDicNodes->peekWorst();
+    }
     bool isLookAheadCorrectionInputIndex(const int inputIndex) const {
         return inputIndex == mInputIndex - 1;
     }
@@ -94,20 +129,9 @@ class DicNodesCache {
         mActiveDicNodes->copyPush(dicNode);
     }
 
-    AK_FORCE_INLINE bool copyPushContinue(DicNode *dicNode) {
-        return mCachedDicNodesForContinuousSuggestion->copyPush(dicNode);
-    }
-
-    AK_FORCE_INLINE void copyPushNextActive(DicNode *dicNode) {
-        DicNode *pushedDicNode = mNextActiveDicNodes->copyPush(dicNode);
-        if (!pushedDicNode) {
-            if (dicNode->isCached()) {
-                dicNode->remove();
-            }
-            // We simply drop any dic node that was not cached, ignoring the slim chance
-            // that one of its children represents what the user really wanted.
-        }
-    }
+    // A node reaching the state of a node already pushed, through other corrections, only
+    // replaces it if it is better.
+    void copyPushNextActive(DicNode *dicNode);
 
     void popTerminal(DicNode *dest) {
         mTerminalDicNodes->copyPop(dest);
@@ -117,40 +141,21 @@ class DicNodesCache {
         mActiveDicNodes->copyPop(dest);
     }
 
-    bool hasCachedDicNodesForContinuousSuggestion() const {
-        return mCachedDicNodesForContinuousSuggestion
-                && mCachedDicNodesForContinuousSuggestion->getSize() > 0;
-    }
-
-    AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        // TODO: Move this variable to header
-        static const int CACHE_BACK_LENGTH = 3;
-        const int cacheInputIndex = inputSize - CACHE_BACK_LENGTH;
-        const bool shouldCache = (cacheInputIndex == mInputIndex)
-                && (cacheInputIndex != mLastCachedInputIndex);
-        return shouldCache;
-    }
-
-    AK_FORCE_INLINE void updateLastCachedInputIndex() {
-        mLastCachedInputIndex = mInputIndex;
+    // Whether the active dic nodes of the current input index are worth a checkpoint for typing.
+    // Nodes at input indices before inputSize - 1 can do look-ahead corrections, and the ones
+    // before inputSize are not completions, so that the active nodes of an input index below
+    // inputSize depend on the points before it only, as long as it stays below inputSize.
+    AK_FORCE_INLINE bool isCheckpointInputIndexForTyping(const int inputSize) const {
+        // The only node at index 0 is the root.
+        return mInputIndex > 0 && mInputIndex < inputSize;
     }
 
  private:
     DISALLOW_COPY_AND_ASSIGN(DicNodesCache);
 
-    AK_FORCE_INLINE void restoreActiveDicNodesFromCache() {
-        if (DEBUG_DICT) {
-            AKLOGI("Restore %d nodes. inputIndex = %d.",
-                    mCachedDicNodesForContinuousSuggestion->getSize(), mLastCachedInputIndex);
-        }
-        if (DEBUG_DICT_FULL || DEBUG_CACHE) {
-            mCachedDicNodesForContinuousSuggestion->dump();
-        }
-        mInputIndex = mLastCachedInputIndex;
-        mCachedDicNodesForContinuousSuggestion =
-                moveNodesAndReturnReusableEmptyQueue(
-                        mCachedDicNodesForContinuousSuggestion, &mActiveDicNodes);
-    }
+    // Checkpoints kept at most, the oldest ones being dropped first, so that their dic nodes
+    // take bounded memory
+    static const int MAX_CHECKPOINT_COUNT;
 
     AK_FORCE_INLINE static DicNodePriorityQueue *moveNodesAndReturnReusableEmptyQueue(
             DicNodePriorityQueue *src, DicNodePriorityQueue **dest) {
@@ -176,10 +181,12 @@ class DicNodesCache {
     DicNodePriorityQueue *mNextActiveDicNodes;
     // Current top terminal dicNodes.
     DicNodePriorityQueue *mTerminalDicNodes;
-    // Cached dicNodes used for continuous suggestion.
-    DicNodePriorityQueue *mCachedDicNodesForContinuousSuggestion;
     int mInputIndex;
-    int mLastCachedInputIndex;
+    // The dic nodes of all the checkpoints, the ones of the i-th checkpoint from
+    // mCheckpointStarts[i] on
+    std::vector<DicNode> mCheckpointDicNodes;
+    std::vector<int> mCheckpointInputIndices;
+    std::vector<int> mCheckpointStarts;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODES_CACHE_H
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: cache_optimized_trie.cpp"
+
+#include "suggest/core/dictionary/cache_optimized_trie.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "binary_format.h"
+#include "defines.h"
+
+namespace latinime {
+
+const int CacheOptimizedTrie::SUPPORTED_FORMAT_VERSION = 2;
+const int CacheOptimizedTrie::ADDRESS_SIZE = 3;
+const int CacheOptimizedTrie::MAX_ADDRESS_OFFSET = 0xFFFFFF;
+
+static inline void writeUInt24(uint8_t *const buffer, const int value) {
+    buffer[0] = static_cast<uint8_t>(value >> 16);
+    buffer[1] = static_cast<uint8_t>(value >> 8);
+    buffer[2] = static_cast<uint8_t>(value);
+}
+
+/* static */ const CacheOptimizedTrie *CacheOptimizedTrie::create(const uint8_t *const dict,
+        const int dictSize) {
+    // Dynamic dictionaries are updated in place, so they must keep their own layout; version 1
+    // dictionaries are not worth the trouble.
+    if (BinaryFormat::detectFormat(dict, dictSize) != SUPPORTED_FORMAT_VERSION) {
+        return 0;
+    }
+    const int headerSize = BinaryFormat::getHeaderSize(dict, dictSize);
+    if (headerSize <= 0 || headerSize >= dictSize) {
+        return 0;
+    }
+    const uint8_t *const root = dict + headerSize;
+    std::vector<Node> nodes;
+    std::vector<CharGroup> charGroups;
+    if (!readNodes(root, dictSize - headerSize, &nodes, &charGroups)) {
+        return 0;
+    }
+    const int newBodySize = layOutNodes(&nodes, &charGroups);
+    if (newBodySize <= 0) {
+        return 0;
+    }
+    uint8_t *const newDict = new uint8_t[headerSize + newBodySize];
+    memcpy(newDict, dict, headerSize);
+    if (!writeNodes(root, nodes, charGroups, newDict + headerSize)) {
+        delete[] newDict;
+        return 0;
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("Cache optimized trie: %d nodes, %d bytes instead of %d.",
+                static_cast<int>(nodes.size()), headerSize + newBodySize, dictSize);
+    }
+    return new CacheOptimizedTrie(newDict, headerSize + newBodySize);
+}
+
+CacheOptimizedTrie::~CacheOptimizedTrie() {
+    delete[] mDict;
+}
+
+// Reads all the nodes breadth-first, so that the children of a node always come after it in
+// nodes, and computes the size of each char group once its addresses are widened to 3 bytes.
+/* static */ bool CacheOptimizedTrie::readNodes(const uint8_t *const root, const int bodySize,
+        std::vector<Node> *const nodes, std::vector<CharGroup> *const charGroups) {
+    const Node rootNode = { 0 /* root position */, 0, 0, 0, 0, NOT_A_PROBABILITY };
+    nodes->push_back(rootNode);
+    for (size_t nodeIndex = 0; nodeIndex < nodes->size(); ++nodeIndex) {
+        const int nodePos = (*nodes)[nodeIndex].mOriginalPos;
+        if (nodePos < 0 || nodePos >= bodySize) {
+            AKLOGE("Invalid node position %d while rearranging the trie.", nodePos);
+            return false;
+        }
+        int pos = nodePos;
+        const int charGroupCount = BinaryFormat::getGroupCountAndForwardPointer(root, &pos);
+        int nodeSize = pos - nodePos;
+        int maxProbability = NOT_A_PROBABILITY;
+        const int firstCharGroupIndex = static_cast<int>(charGroups->size());
+        for (int i = 0; i < charGroupCount; ++i) {
+            if (pos >= bodySize) {
+                AKLOGE("Invalid char group position %d while rearranging the trie.", pos);
+                return false;
+            }
+            const int charGroupPos = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+            BinaryFormat::getCodePointAndForwardPointer(root, &pos);
+            if (BinaryFormat::FLAG_HAS_MULTIPLE_CHARS & flags) {
+                pos = BinaryFormat::skipOtherCharacters(root, pos);
+            }
+            if (BinaryFormat::FLAG_IS_TERMINAL & flags) {
+                maxProbability = std::max(maxProbability,
+                        BinaryFormat::readProbabilityWithoutMovingPointer(root, pos));
+            }
+            pos = BinaryFormat::skipProbability(flags, pos);
+            int newSize = pos - charGroupPos;
+            CharGroup charGroup = { charGroupPos, nodeSize, 0, NOT_AN_INDEX };
+            if (BinaryFormat::hasChildrenInFlags(flags)) {
+                const Node childNode = { BinaryFormat::readChildrenPosition(root, flags, pos), 0,
+                        0, 0, 0, NOT_A_PROBABILITY };
+                charGroup.mChildNodeIndex = static_cast<int>(nodes->size());
+                nodes->push_back(childNode);
+                newSize += ADDRESS_SIZE;
+            }
+            pos = BinaryFormat::skipChildrenPosition(flags, pos);
+            const int shortcutsPos = pos;
+            pos = BinaryFormat::skipShortcuts(root, flags, pos);
+            newSize += pos - shortcutsPos;
+            if (BinaryFormat::FLAG_HAS_BIGRAMS & flags) {
+                uint8_t bigramFlags;
+                do {
+                    bigramFlags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+                    BinaryFormat::getAttributeAddressAndForwardPointer(root, bigramFlags, &pos);
+                    newSize += 1 /* flags */ + ADDRESS_SIZE;
+                } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+            }
+            charGroups->push_back(charGroup);
+            nodeSize += newSize;
+        }
+        Node *const node = &(*nodes)[nodeIndex];
+        node->mSize = nodeSize;
+        node->mFirstCharGroupIndex = firstCharGroupIndex;
+        node->mCharGroupCount = charGroupCount;
+        node->mMaxProbability = maxProbability;
+    }
+    return true;
+}
+
+// Assigns the new positions of the nodes and char groups and returns the new body size, or 0 if
+// some children address would not fit.
+/* static */ int CacheOptimizedTrie::layOutNodes(std::vector<Node> *const nodes,
+        std::vector<CharGroup> *const charGroups) {
+    // Children always come after their parent in nodes, so a backward pass sees every subtree
+    // before its root.
+    for (int nodeIndex = static_cast<int>(nodes->size()) - 1; nodeIndex >= 0; --nodeIndex) {
+        Node *const node = &(*nodes)[nodeIndex];
+        for (int i = 0; i < node->mCharGroupCount; ++i) {
+            const int childNodeIndex =
+                    (*charGroups)[node->mFirstCharGroupIndex + i].mChildNodeIndex;
+            if (childNodeIndex != NOT_AN_INDEX) {
+                node->mMaxProbability = std::max(node->mMaxProbability,
+                        (*nodes)[childNodeIndex].mMaxProbability);
+            }
+        }
+    }
+    int newBodySize = 0;
+    std::vector<int> nodeIndexStack;
+    // Pairs of (negated max probability, node index), so that sorting puts the most probable
+    // subtree first and keeps the original order between subtrees of the same probability.
+    std::vector<std::pair<int, int> > children;
+    nodeIndexStack.push_back(0 /* root index */);
+    while (!nodeIndexStack.empty()) {
+        Node *const node = &(*nodes)[nodeIndexStack.back()];
+        nodeIndexStack.pop_back();
+        node->mNewPos = newBodySize;
+        newBodySize += node->mSize;
+        children.clear();
+        for (int i = 0; i < node->mCharGroupCount; ++i) {
+            CharGroup *const charGroup = &(*charGroups)[node->mFirstCharGroupIndex + i];
+            charGroup->mNewPos = node->mNewPos + charGroup->mOffsetInNode;
+            if (charGroup->mChildNodeIndex != NOT_AN_INDEX) {
+                children.push_back(std::make_pair(
+                        -(*nodes)[charGroup->mChildNodeIndex].mMaxProbability,
+                        charGroup->mChildNodeIndex));
+            }
+        }
+        std::sort(children.begin(), children.end());
+        for (int i = static_cast<int>(children.size()) - 1; i >= 0; --i) {
+            nodeIndexStack.push_back(children[i].second);
+        }
+    }
+    // Children are written after their parent, so the largest children offset is bounded by the
+    // body size.
+    return newBodySize > MAX_ADDRESS_OFFSET ? 0 : newBodySize;
+}
+
+/* static */ bool CacheOptimizedTrie::writeNodes(const uint8_t *const root,
+        const std::vector<Node> &nodes, const std::vector<CharGroup> &charGroups,
+        uint8_t *const newRoot) {
+    // Sorted pairs of (original position, new position) of every char group, to translate the
+    // bigram targets.
+    std::vector<std::pair<int, int> > newCharGroupPositions;
+    newCharGroupPositions.reserve(charGroups.size());
+    for (size_t i = 0; i < charGroups.size(); ++i) {
+        newCharGroupPositions.push_back(
+                std::make_pair(charGroups[i].mOriginalPos, charGroups[i].mNewPos));
+    }
+    std::sort(newCharGroupPositions.begin(), newCharGroupPositions.end());
+    for (size_t nodeIndex = 0; nodeIndex < nodes.size(); ++nodeIndex) {
+        const Node &node = nodes[nodeIndex];
+        int groupCountEndPos = node.mOriginalPos;
+        BinaryFormat::getGroupCountAndForwardPointer(root, &groupCountEndPos);
+        memcpy(newRoot + node.mNewPos, root + node.mOriginalPos,
+                groupCountEndPos - node.mOriginalPos);
+        for (int i = 0; i < node.mCharGroupCount; ++i) {
+            const CharGroup &charGroup = charGroups[node.mFirstCharGroupIndex + i];
+            int pos = charGroup.mOriginalPos;
+            int newPos = charGroup.mNewPos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+            const bool hasChildren = charGroup.mChildNodeIndex != NOT_AN_INDEX;
+            newRoot[newPos++] = static_cast<uint8_t>(
+                    (flags & ~BinaryFormat::MASK_GROUP_ADDRESS_TYPE)
+                    | (hasChildren ? BinaryFormat::FLAG_GROUP_ADDRESS_TYPE_THREEBYTES
+                            : BinaryFormat::FLAG_GROUP_ADDRESS_TYPE_NOADDRESS));
+            // Characters and probability are copied as they are.
+            const int charactersPos = pos;
+            BinaryFormat::getCodePointAndForwardPointer(root, &pos);
+            if (BinaryFormat::FLAG_HAS_MULTIPLE_CHARS & flags) {
+                pos = BinaryFormat::skipOtherCharacters(root, pos);
+            }
+            pos = BinaryFormat::skipProbability(flags, pos);
+            memcpy(newRoot + newPos, root + charactersPos, pos - charactersPos);
+            newPos += pos - charactersPos;
+            if (hasChildren) {
+                writeUInt24(newRoot + newPos, nodes[charGroup.mChildNodeIndex].mNewPos - newPos);
+                newPos += ADDRESS_SIZE;
+            }
+            pos = BinaryFormat::skipChildrenPosition(flags, pos);
+            // Shortcut targets are strings, so they do not depend on the layout either.
+            const int shortcutsPos = pos;
+            pos = BinaryFormat::skipShortcuts(root, flags, pos);
+            memcpy(newRoot + newPos, root + shortcutsPos, pos - shortcutsPos);
+            newPos += pos - shortcutsPos;
+            if (!(BinaryFormat::FLAG_HAS_BIGRAMS & flags)) {
+                continue;
+            }
+            uint8_t bigramFlags;
+            do {
+                bigramFlags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+                const int targetPos =
+                        BinaryFormat::getAttributeAddressAndForwardPointer(root, bigramFlags, &pos);
+                const std::vector<std::pair<int, int> >::const_iterator it = std::lower_bound(
+                        newCharGroupPositions.begin(), newCharGroupPositions.end(),
+                        std::make_pair(targetPos, S_INT_MIN));
+                if (it == newCharGroupPositions.end() || it->first != targetPos) {
+                    AKLOGE("Invalid bigram target %d while rearranging the trie.", targetPos);
+                    return false;
+                }
+                const int offset = it->second - (newPos + 1 /* flags */);
+                if (abs(offset) > MAX_ADDRESS_OFFSET) {
+                    return false;
+                }
+                newRoot[newPos++] = static_cast<uint8_t>((bigramFlags
+                        & ~(BinaryFormat::MASK_ATTRIBUTE_ADDRESS_TYPE
+                                | BinaryFormat::FLAG_ATTRIBUTE_OFFSET_NEGATIVE))
+                        | BinaryFormat::FLAG_ATTRIBUTE_ADDRESS_TYPE_THREEBYTES
+                        | (offset < 0 ? BinaryFormat::FLAG_ATTRIBUTE_OFFSET_NEGATIVE : 0));
+                writeUInt24(newRoot + newPos, abs(offset));
+                newPos += ADDRESS_SIZE;
+            } while (BinaryFormat::FLAG_ATTRIBUTE_HAS_NEXT & bigramFlags);
+        }
+    }
+    return true;
+}
+} // namespace latinime
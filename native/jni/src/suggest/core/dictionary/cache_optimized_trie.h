@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_CACHE_OPTIMIZED_TRIE_H
+#define LATINIME_CACHE_OPTIMIZED_TRIE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * In-memory copy of a static dictionary whose nodes are rearranged so that a descent touches as
+ * few cache lines and pages as possible. makedict writes the nodes breadth-first, hence each
+ * level of a descent usually lands far away from the previous one. The copy writes the nodes
+ * depth-first instead, and visits the children of a node by decreasing best unigram probability
+ * in their subtree, so that the most likely paths are laid out contiguously.
+ *
+ * The copy is still a valid version 2 dictionary: the header is kept as is and every children
+ * and bigram address is rewritten for the new positions. Only the order of the nodes changes;
+ * the order of the char groups in a node is kept, so suggestions are the same as with the
+ * original layout. The one reader that depends on the node order is the search for the word at
+ * an address without parent links (BinaryFormat::getWordAtAddress), which expects the nodes of
+ * makedict; Dictionary therefore always builds the ParentLinkIndex for the copy.
+ */
+class CacheOptimizedTrie {
+ public:
+    // Returns null when the dictionary cannot be rearranged and has to be read in place.
+    static const CacheOptimizedTrie *create(const uint8_t *const dict, const int dictSize);
+
+    ~CacheOptimizedTrie();
+
+    // The whole dictionary, header included.
+    const uint8_t *getDict() const { return mDict; }
+    int getDictSize() const { return mDictSize; }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(CacheOptimizedTrie);
+
+    static const int SUPPORTED_FORMAT_VERSION;
+    // Every children and bigram address of the copy is written on 3 bytes.
+    static const int ADDRESS_SIZE;
+    static const int MAX_ADDRESS_OFFSET;
+
+    struct Node {
+        int mOriginalPos;
+        int mNewPos;
+        int mSize;
+        int mFirstCharGroupIndex;
+        int mCharGroupCount;
+        // Best unigram probability in the subtree of this node.
+        int mMaxProbability;
+    };
+
+    struct CharGroup {
+        int mOriginalPos;
+        int mOffsetInNode;
+        int mNewPos;
+        int mChildNodeIndex;
+    };
+
+    CacheOptimizedTrie(const uint8_t *const dict, const int dictSize)
+            : mDict(dict), mDictSize(dictSize) {}
+
+    static bool readNodes(const uint8_t *const root, const int bodySize,
+            std::vector<Node> *const nodes, std::vector<CharGroup> *const charGroups);
+    static int layOutNodes(std::vector<Node> *const nodes,
+            std::vector<CharGroup> *const charGroups);
+    static bool writeNodes(const uint8_t *const root, const std::vector<Node> &nodes,
+            const std::vector<CharGroup> &charGroups, uint8_t *const newRoot);
+
+    const uint8_t *const mDict;
+    const int mDictSize;
+};
+} // namespace latinime
+#endif // LATINIME_CACHE_OPTIMIZED_TRIE_H
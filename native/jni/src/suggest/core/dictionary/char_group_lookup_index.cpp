@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: char_group_lookup_index.cpp"
+
+#include "suggest/core/dictionary/char_group_lookup_index.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "defines.h"
+#include "suggest/core/dictionary/trie_walk.h"
+
+namespace latinime {
+
+const int CharGroupLookupIndex::MIN_INDEXED_GROUP_COUNT = 8;
+
+CharGroupLookupIndex::CharGroupLookupIndex(const TrieWalk &trieWalk)
+        : mEntries(0), mTableSize(0), mIndexedNodeCount(0) {
+    build(trieWalk);
+}
+
+CharGroupLookupIndex::~CharGroupLookupIndex() {
+    delete[] mEntries;
+}
+
+// Indexes the char groups of every wide enough node. Each indexed node also gets a marker entry
+// keyed by NOT_A_CODE_POINT so that lookups can tell "not in this node" from "this node was not
+// indexed".
+void CharGroupLookupIndex::build(const TrieWalk &trieWalk) {
+    if (!trieWalk.isComplete()) {
+        return;
+    }
+    const std::vector<TrieWalk::Node> &nodes = trieWalk.getNodes();
+    const std::vector<TrieWalk::CharGroup> &charGroups = trieWalk.getCharGroups();
+    std::vector<Entry> entries;
+    for (size_t nodeIndex = 0; nodeIndex < nodes.size(); ++nodeIndex) {
+        const TrieWalk::Node &node = nodes[nodeIndex];
+        if (node.mCharGroupCount < MIN_INDEXED_GROUP_COUNT) {
+            continue;
+        }
+        const Entry marker = { node.mPos, NOT_A_CODE_POINT, node.mPos };
+        entries.push_back(marker);
+        ++mIndexedNodeCount;
+        for (int i = node.mFirstCharGroupIndex;
+                i < node.mFirstCharGroupIndex + node.mCharGroupCount; ++i) {
+            const Entry entry = { node.mPos, charGroups[i].mCodePoint, charGroups[i].mPos };
+            entries.push_back(entry);
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+    // Keep the load factor at or below 50% so that probe chains stay short.
+    int tableSize = 1;
+    while (tableSize < static_cast<int>(entries.size()) * 2) {
+        tableSize <<= 1;
+    }
+    mTableSize = tableSize;
+    mEntries = new Entry[mTableSize];
+    for (int i = 0; i < mTableSize; ++i) {
+        mEntries[i].mNodePos = NOT_A_NODE_POS;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        insert(entries[i].mNodePos, entries[i].mCodePoint, entries[i].mCharGroupPos);
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("Char group index: %d nodes, %d entries, %d buckets.", mIndexedNodeCount,
+                static_cast<int>(entries.size()), mTableSize);
+    }
+}
+
+void CharGroupLookupIndex::insert(const int nodePos, const int codePoint,
+        const int charGroupPos) {
+    int i = getBucketIndex(nodePos, codePoint);
+    while (mEntries[i].mNodePos != NOT_A_NODE_POS) {
+        if (mEntries[i].mNodePos == nodePos && mEntries[i].mCodePoint == codePoint) {
+            // Only one char group of a node may start with a given code point.
+            return;
+        }
+        i = (i + 1) & (mTableSize - 1);
+    }
+    mEntries[i].mNodePos = nodePos;
+    mEntries[i].mCodePoint = codePoint;
+    mEntries[i].mCharGroupPos = charGroupPos;
+}
+} // namespace latinime
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_CHAR_GROUP_LOOKUP_INDEX_H
+#define LATINIME_CHAR_GROUP_LOOKUP_INDEX_H
+
+#include <stdint.h>
+
+#include "defines.h"
+
+namespace latinime {
+
+class TrieWalk;
+
+/**
+ * Side index mapping (node position, first code point) to the position of the matching char
+ * group, so that an exact word lookup does not have to walk and skip every sibling of a wide
+ * node. Only nodes with at least MIN_INDEXED_GROUP_COUNT char groups are indexed; narrower nodes
+ * are cheap enough to scan. The index is built once when the dictionary is opened and is
+ * immutable afterwards, so it can be shared by all threads using the dictionary.
+ */
+class CharGroupLookupIndex {
+ public:
+    // Returned by getCharGroupPos() when the node is not indexed and must be scanned.
+    static const int NOT_INDEXED = -2;
+
+    explicit CharGroupLookupIndex(const TrieWalk &trieWalk);
+    ~CharGroupLookupIndex();
+
+    // Returns the position of the char group of the node at nodePos that starts with codePoint,
+    // NOT_VALID_WORD if the node is indexed but has no such char group, or NOT_INDEXED.
+    AK_FORCE_INLINE int getCharGroupPos(const int nodePos, const int codePoint) const {
+        if (mTableSize == 0) {
+            return NOT_INDEXED;
+        }
+        const Entry *const entry = findEntry(nodePos, codePoint);
+        if (entry) {
+            return entry->mCharGroupPos;
+        }
+        // Tell a missing code point in an indexed node from a node that was not indexed.
+        return findEntry(nodePos, NOT_A_CODE_POINT) ? NOT_VALID_WORD : NOT_INDEXED;
+    }
+
+    int getIndexedNodeCount() const { return mIndexedNodeCount; }
+    int getMemorySize() const { return mTableSize * static_cast<int>(sizeof(Entry)); }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(CharGroupLookupIndex);
+
+    // Minimal number of char groups in a node to make it worth indexing.
+    static const int MIN_INDEXED_GROUP_COUNT;
+    static const int NOT_A_NODE_POS = -1;
+
+    struct Entry {
+        int mNodePos;
+        // NOT_A_CODE_POINT for the marker entry that tells the node is indexed.
+        int mCodePoint;
+        int mCharGroupPos;
+    };
+
+    AK_FORCE_INLINE int getBucketIndex(const int nodePos, const int codePoint) const {
+        const uint32_t hash = (static_cast<uint32_t>(nodePos) * 0x9E3779B1U)
+                ^ (static_cast<uint32_t>(codePoint) * 0x85EBCA6BU);
+        return static_cast<int>((hash ^ (hash >> 15)) & static_cast<uint32_t>(mTableSize - 1));
+    }
+
+    AK_FORCE_INLINE const Entry *findEntry(const int nodePos, const int codePoint) const {
+        for (int i = getBucketIndex(nodePos, codePoint); mEntries[i].mNodePos != NOT_A_NODE_POS;
+                i = (i + 1) & (mTableSize - 1)) {
+            if (mEntries[i].mNodePos == nodePos && mEntries[i].mCodePoint == codePoint) {
+                return &mEntries[i];
+            }
+        }
+        return 0;
+    }
+
+    void build(const TrieWalk &trieWalk);
+    void insert(const int nodePos, const int codePoint, const int charGroupPos);
+
+    Entry *mEntries;
+    int mTableSize;
+    int mIndexedNodeCount;
+};
+} // namespace latinime
+#endif // LATINIME_CHAR_GROUP_LOOKUP_INDEX_H
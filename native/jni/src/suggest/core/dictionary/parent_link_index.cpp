@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: parent_link_index.cpp"
+
+#include "suggest/core/dictionary/parent_link_index.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "defines.h"
+#include "suggest/core/dictionary/trie_walk.h"
+
+namespace latinime {
+
+ParentLinkIndex::ParentLinkIndex(const TrieWalk &trieWalk)
+        : mNodePositions(0), mParentCharGroupPositions(0), mNodeCount(0) {
+    build(trieWalk);
+}
+
+ParentLinkIndex::~ParentLinkIndex() {
+    delete[] mNodePositions;
+    delete[] mParentCharGroupPositions;
+}
+
+void ParentLinkIndex::build(const TrieWalk &trieWalk) {
+    if (!trieWalk.isComplete()) {
+        return;
+    }
+    const std::vector<TrieWalk::Node> &nodes = trieWalk.getNodes();
+    const std::vector<TrieWalk::CharGroup> &charGroups = trieWalk.getCharGroups();
+    // Pairs of (node position, parent char group position).
+    std::vector<std::pair<int, int> > links;
+    links.reserve(nodes.size());
+    for (size_t nodeIndex = 0; nodeIndex < nodes.size(); ++nodeIndex) {
+        const int parentIndex = nodes[nodeIndex].mParentCharGroupIndex;
+        links.push_back(std::make_pair(nodes[nodeIndex].mPos,
+                parentIndex < 0 ? static_cast<int>(NO_PARENT) : charGroups[parentIndex].mPos));
+    }
+    std::sort(links.begin(), links.end());
+    mNodeCount = static_cast<int>(links.size());
+    mNodePositions = new int[mNodeCount];
+    mParentCharGroupPositions = new int[mNodeCount];
+    for (int i = 0; i < mNodeCount; ++i) {
+        mNodePositions[i] = links[i].first;
+        mParentCharGroupPositions[i] = links[i].second;
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("Parent link index: %d nodes.", mNodeCount);
+    }
+}
+} // namespace latinime
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_PARENT_LINK_INDEX_H
+#define LATINIME_PARENT_LINK_INDEX_H
+
+#include <algorithm>
+#include <stdint.h>
+
+#include "defines.h"
+
+namespace latinime {
+
+class TrieWalk;
+
+/**
+ * Reverse links of the trie, so that a word can be rebuilt from the address of its terminal char
+ * group by climbing to the root instead of descending the trie and scanning siblings. Since nodes
+ * are written contiguously, the node containing a char group is the one with the greatest start
+ * position not above the char group position; only one (node position, parent char group
+ * position) pair is stored per node. Built once when the dictionary is opened and immutable
+ * afterwards.
+ */
+class ParentLinkIndex {
+ public:
+    // Parent position of the char groups of the root node.
+    static const int NO_PARENT = -1;
+
+    explicit ParentLinkIndex(const TrieWalk &trieWalk);
+    ~ParentLinkIndex();
+
+    bool isEmpty() const { return mNodeCount == 0; }
+    int getMemorySize() const {
+        return mNodeCount * static_cast<int>(sizeof(mNodePositions[0])
+                + sizeof(mParentCharGroupPositions[0]));
+    }
+
+    // Returns the position of the char group whose children contain the char group at
+    // charGroupPos, or NO_PARENT if it is in the root node.
+    AK_FORCE_INLINE int getParentCharGroupPos(const int charGroupPos) const {
+        const int *const nodePos =
+                std::upper_bound(mNodePositions, mNodePositions + mNodeCount, charGroupPos);
+        if (nodePos == mNodePositions) {
+            return NO_PARENT;
+        }
+        return mParentCharGroupPositions[nodePos - mNodePositions - 1];
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(ParentLinkIndex);
+
+    void build(const TrieWalk &trieWalk);
+
+    // Sorted start positions of the nodes, and the parent char group of each of them.
+    int *mNodePositions;
+    int *mParentCharGroupPositions;
+    int mNodeCount;
+};
+} // namespace latinime
+#endif // LATINIME_PARENT_LINK_INDEX_H
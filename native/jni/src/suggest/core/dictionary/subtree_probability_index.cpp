@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: subtree_probability_index.cpp"
+
+#include "suggest/core/dictionary/subtree_probability_index.h"
+
+#include <cstring>
+#include <vector>
+
+#include "defines.h"
+#include "suggest/core/dictionary/trie_walk.h"
+
+namespace latinime {
+
+SubtreeProbabilityIndex::SubtreeProbabilityIndex(const TrieWalk &trieWalk)
+        : mCharGroupBitmap(0), mRanks(0), mMaxProbabilities(0), mCharGroupCount(0),
+          mDictBodySize(0) {
+    build(trieWalk);
+}
+
+SubtreeProbabilityIndex::~SubtreeProbabilityIndex() {
+    delete[] mCharGroupBitmap;
+    delete[] mRanks;
+    delete[] mMaxProbabilities;
+}
+
+void SubtreeProbabilityIndex::build(const TrieWalk &trieWalk) {
+    if (!trieWalk.isComplete()) {
+        return;
+    }
+    const std::vector<TrieWalk::Node> &nodes = trieWalk.getNodes();
+    const std::vector<TrieWalk::CharGroup> &charGroups = trieWalk.getCharGroups();
+    const int dictBodySize = trieWalk.getDictBodySize();
+    std::vector<int> maxProbabilities(charGroups.size());
+    for (size_t i = 0; i < charGroups.size(); ++i) {
+        maxProbabilities[i] = charGroups[i].mProbability;
+    }
+    // Children come after their parents, so a backward pass sees every subtree before its root.
+    for (int i = static_cast<int>(charGroups.size()) - 1; i >= 0; --i) {
+        const int parentIndex = nodes[charGroups[i].mNodeIndex].mParentCharGroupIndex;
+        if (parentIndex >= 0) {
+            maxProbabilities[parentIndex] =
+                    max(maxProbabilities[parentIndex], maxProbabilities[i]);
+        }
+    }
+
+    const int bitmapSize = (dictBodySize + BITS_PER_BITMAP_WORD - 1) / BITS_PER_BITMAP_WORD;
+    mCharGroupBitmap = new uint32_t[bitmapSize];
+    memset(mCharGroupBitmap, 0, bitmapSize * sizeof(mCharGroupBitmap[0]));
+    for (size_t i = 0; i < charGroups.size(); ++i) {
+        const int pos = charGroups[i].mPos;
+        mCharGroupBitmap[pos / BITS_PER_BITMAP_WORD] |= 1U << (pos % BITS_PER_BITMAP_WORD);
+    }
+    mRanks = new int[bitmapSize];
+    int rank = 0;
+    for (int i = 0; i < bitmapSize; ++i) {
+        mRanks[i] = rank;
+        rank += __builtin_popcount(mCharGroupBitmap[i]);
+    }
+    mMaxProbabilities = new uint8_t[rank];
+    mCharGroupCount = rank;
+    mDictBodySize = dictBodySize;
+    for (size_t i = 0; i < charGroups.size(); ++i) {
+        const int pos = charGroups[i].mPos;
+        const uint32_t bit = 1U << (pos % BITS_PER_BITMAP_WORD);
+        const int bitmapIndex = pos / BITS_PER_BITMAP_WORD;
+        // A subtree without words is never worth reaching: give it the lowest probability.
+        mMaxProbabilities[mRanks[bitmapIndex]
+                + __builtin_popcount(mCharGroupBitmap[bitmapIndex] & (bit - 1))] =
+                        static_cast<uint8_t>(max(0, maxProbabilities[i]));
+    }
+    if (DEBUG_DICT) {
+        AKLOGI("Subtree probability index: %d char groups.", rank);
+    }
+}
+} // namespace latinime
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_SUBTREE_PROBABILITY_INDEX_H
+#define LATINIME_SUBTREE_PROBABILITY_INDEX_H
+
+#include <stdint.h>
+
+#include "defines.h"
+
+namespace latinime {
+
+class TrieWalk;
+
+/**
+ * Side index giving, for every char group, the highest unigram probability of the words that end
+ * at it or below it, so that the search can bound the language cost of a prefix before reaching
+ * its terminals. The values are stored in char group position order, and a bitmap of the char
+ * group positions with the number of set bits before each of its words maps a position to its
+ * value. Built once when the dictionary is opened and immutable afterwards.
+ */
+class SubtreeProbabilityIndex {
+ public:
+    explicit SubtreeProbabilityIndex(const TrieWalk &trieWalk);
+    ~SubtreeProbabilityIndex();
+
+    // Returns the highest probability of the words ending at or below the char group at
+    // charGroupPos, or NOT_A_PROBABILITY if there is no char group there.
+    AK_FORCE_INLINE int getMaxProbability(const int charGroupPos) const {
+        if (charGroupPos < 0 || charGroupPos >= mDictBodySize) {
+            return NOT_A_PROBABILITY;
+        }
+        const int bitmapIndex = charGroupPos / BITS_PER_BITMAP_WORD;
+        const uint32_t bit = 1U << (charGroupPos % BITS_PER_BITMAP_WORD);
+        const uint32_t bitmapWord = mCharGroupBitmap[bitmapIndex];
+        if (!(bitmapWord & bit)) {
+            return NOT_A_PROBABILITY;
+        }
+        return mMaxProbabilities[mRanks[bitmapIndex]
+                + __builtin_popcount(bitmapWord & (bit - 1))];
+    }
+
+    int getMemorySize() const {
+        const int bitmapSize = (mDictBodySize + BITS_PER_BITMAP_WORD - 1) / BITS_PER_BITMAP_WORD;
+        return bitmapSize * static_cast<int>(sizeof(mCharGroupBitmap[0]) + sizeof(mRanks[0]))
+                + mCharGroupCount * static_cast<int>(sizeof(mMaxProbabilities[0]));
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(SubtreeProbabilityIndex);
+
+    static const int BITS_PER_BITMAP_WORD = 32;
+
+    void build(const TrieWalk &trieWalk);
+
+    // Char group positions, and the number of them before each word of the bitmap.
+    uint32_t *mCharGroupBitmap;
+    int *mRanks;
+    // Highest probabilities of the subtrees of the char groups, in position order.
+    uint8_t *mMaxProbabilities;
+    int mCharGroupCount;
+    // 0 if nothing was indexed, so that all lookups fail.
+    int mDictBodySize;
+};
+} // namespace latinime
+#endif // LATINIME_SUBTREE_PROBABILITY_INDEX_H
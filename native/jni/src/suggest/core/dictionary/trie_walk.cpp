@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: trie_walk.cpp"
+
+#include "suggest/core/dictionary/trie_walk.h"
+
+#include "binary_format.h"
+#include "defines.h"
+
+namespace latinime {
+
+TrieWalk::TrieWalk(const uint8_t *const dictRoot, const int dictBodySize)
+        : mDictBodySize(dictBodySize), mIsComplete(false), mNodes(), mCharGroups() {
+    walk(dictRoot);
+}
+
+void TrieWalk::walk(const uint8_t *const dictRoot) {
+    if (!dictRoot || mDictBodySize <= 0) {
+        return;
+    }
+    const Node root = { 0 /* root position */, -1, 0, 0 };
+    mNodes.push_back(root);
+    for (size_t nodeIndex = 0; nodeIndex < mNodes.size(); ++nodeIndex) {
+        const int nodePos = mNodes[nodeIndex].mPos;
+        if (nodePos < 0 || nodePos >= mDictBodySize) {
+            AKLOGE("Invalid node position %d while walking the trie.", nodePos);
+            ASSERT(false);
+            return;
+        }
+        int pos = nodePos;
+        const int charGroupCount = BinaryFormat::getGroupCountAndForwardPointer(dictRoot, &pos);
+        mNodes[nodeIndex].mFirstCharGroupIndex = static_cast<int>(mCharGroups.size());
+        for (int i = 0; i < charGroupCount && pos < mDictBodySize; ++i) {
+            const int charGroupPos = pos;
+            const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(dictRoot, &pos);
+            const int codePoint = BinaryFormat::getCodePointAndForwardPointer(dictRoot, &pos);
+            if (BinaryFormat::FLAG_HAS_MULTIPLE_CHARS & flags) {
+                pos = BinaryFormat::skipOtherCharacters(dictRoot, pos);
+            }
+            const int probability = (BinaryFormat::FLAG_IS_TERMINAL & flags)
+                    ? BinaryFormat::readProbabilityWithoutMovingPointer(dictRoot, pos)
+                    : NOT_A_PROBABILITY;
+            const CharGroup charGroup = { charGroupPos, codePoint, probability,
+                    static_cast<int>(nodeIndex) };
+            mCharGroups.push_back(charGroup);
+            pos = BinaryFormat::skipProbability(flags, pos);
+            if (BinaryFormat::hasChildrenInFlags(flags)) {
+                const Node child = { BinaryFormat::readChildrenPosition(dictRoot, flags, pos),
+                        static_cast<int>(mCharGroups.size()) - 1, 0, 0 };
+                mNodes.push_back(child);
+            }
+            pos = BinaryFormat::skipChildrenPosAndAttributes(dictRoot, flags, pos);
+            ++mNodes[nodeIndex].mCharGroupCount;
+        }
+    }
+    mIsComplete = true;
+}
+} // namespace latinime
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_TRIE_WALK_H
+#define LATINIME_TRIE_WALK_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * The nodes and char groups of a static trie, read in one breadth first walk, so that the side
+ * indices built when the dictionary is opened do not each walk the whole trie again. Parents come
+ * before their children, and the char groups of a node are contiguous. Only lives while the
+ * indices are built.
+ */
+class TrieWalk {
+ public:
+    struct Node {
+        int mPos;
+        // Index of the char group whose children are this node, or -1 for the root node.
+        int mParentCharGroupIndex;
+        int mFirstCharGroupIndex;
+        int mCharGroupCount;
+    };
+
+    struct CharGroup {
+        int mPos;
+        int mCodePoint;
+        // NOT_A_PROBABILITY if no word ends at this char group.
+        int mProbability;
+        int mNodeIndex;
+    };
+
+    TrieWalk(const uint8_t *const dictRoot, const int dictBodySize);
+    ~TrieWalk() {}
+
+    // Whether the whole trie was read. A walk stopped at an invalid node position is not.
+    bool isComplete() const { return mIsComplete; }
+    int getDictBodySize() const { return mDictBodySize; }
+    const std::vector<Node> &getNodes() const { return mNodes; }
+    const std::vector<CharGroup> &getCharGroups() const { return mCharGroups; }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(TrieWalk);
+
+    void walk(const uint8_t *const dictRoot);
+
+    const int mDictBodySize;
+    bool mIsComplete;
+    std::vector<Node> mNodes;
+    std::vector<CharGroup> mCharGroups;
+};
+} // namespace latinime
+#endif // LATINIME_TRIE_WALK_H
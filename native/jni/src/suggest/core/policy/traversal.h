@@ -27,20 +27,21 @@ class Traversal {
  public:
     virtual int getMaxPointerCount() const = 0;
     virtual bool allowsErrorCorrections(const DicNode *const dicNode) const = 0;
+    // The child is only described by its code point, so that children can be filtered before
+    // being built.
     virtual bool isOmission(const DicTraverseSession *const traverseSession,
-            const DicNode *const dicNode, const DicNode *const childDicNode,
+            const DicNode *const dicNode, const int childCodePoint,
             const bool allowsErrorCorrections) const = 0;
     virtual bool isSpaceSubstitutionTerminal(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const = 0;
     virtual bool isSpaceOmissionTerminal(const DicTraverseSession *const traverseSession,
                const DicNode *const dicNode) const = 0;
-    virtual bool shouldDepthLevelCache(const DicTraverseSession *const traverseSession) const = 0;
-    virtual bool shouldNodeLevelCache(const DicTraverseSession *const traverseSession,
-            const DicNode *const dicNode) const = 0;
+    // Whether to save the active dic nodes as a checkpoint before expanding them
+    virtual bool shouldSaveCheckpoint(const DicTraverseSession *const traverseSession) const = 0;
     virtual bool canDoLookAheadCorrection(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const = 0;
     virtual ProximityType getProximityType(const DicTraverseSession *const traverseSession,
-            const DicNode *const dicNode, const DicNode *const childDicNode) const = 0;
+            const DicNode *const dicNode, const int childCodePoint) const = 0;
     virtual bool sameAsTyped(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const = 0;
     virtual bool needsToTraverseAllUserInput() const = 0;
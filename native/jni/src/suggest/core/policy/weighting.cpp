@@ -91,6 +91,12 @@ static inline void profile(const CorrectionType correctionType, DicNode *const n
     }
     dicNode->addCost(spatialCost, languageCost, weighting->needsToNormalizeCompoundDistance(),
             inputSize, errorType);
+    // Once at a terminal, the language cost of the word is known. Before, it includes at least
+    // the weight of the dictionary of the word.
+    dicNode->setLanguageLookAheadCost(correctionType == CT_TERMINAL ? 0.0f
+            : traverseSession->getDictionaryWeight(dicNode->getDictionaryIndex())
+                    + weighting->getLanguageLookAheadCost(traverseSession, dicNode),
+            weighting->needsToNormalizeCompoundDistance());
 }
 
 /* static */ float Weighting::getSpatialCost(const Weighting *const weighting,
@@ -135,19 +141,23 @@ static inline void profile(const CorrectionType correctionType, DicNode *const n
     case CT_SUBSTITUTION:
         return 0.0f;
     case CT_NEW_WORD_SPACE_OMITTION:
-        return weighting->getNewWordBigramCost(traverseSession, parentDicNode, multiBigramMap);
+        return weighting->getNewWordBigramCost(traverseSession, parentDicNode, multiBigramMap)
+                + traverseSession->getDictionaryWeight(parentDicNode->getDictionaryIndex());
     case CT_MATCH:
         return 0.0f;
     case CT_COMPLETION:
         return 0.0f;
     case CT_TERMINAL: {
-        const float languageImprobability =
-                DicNodeUtils::getBigramNodeImprobability(
-                        traverseSession->getOffsetDict(), dicNode, multiBigramMap);
-        return weighting->getTerminalLanguageCost(traverseSession, dicNode, languageImprobability);
+        const int dictionaryIndex = dicNode->getDictionaryIndex();
+        const float languageImprobability = DicNodeUtils::getBigramNodeImprobability(
+                traverseSession->getOffsetDict(dictionaryIndex),
+                traverseSession->supportsDynamicUpdate(dictionaryIndex), dicNode, multiBigramMap);
+        return weighting->getTerminalLanguageCost(traverseSession, dicNode, languageImprobability)
+                + traverseSession->getDictionaryWeight(dictionaryIndex);
     }
     case CT_NEW_WORD_SPACE_SUBSTITUTION:
-        return weighting->getNewWordBigramCost(traverseSession, parentDicNode, multiBigramMap);
+        return weighting->getNewWordBigramCost(traverseSession, parentDicNode, multiBigramMap)
+                + traverseSession->getDictionaryWeight(parentDicNode->getDictionaryIndex());
     case CT_INSERTION:
         return 0.0f;
     case CT_TRANSPOSITION:
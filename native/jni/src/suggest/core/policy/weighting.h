@@ -34,6 +34,18 @@ class Weighting {
             const DicNode *const parentDicNode, DicNode *const dicNode,
             MultiBigramMap *const multiBigramMap);
 
+    // A lower bound of the distance that the node, or any node derived from it, still adds
+    // before being output as a terminal, or a negative value if the distance is normalized, as
+    // it then does not only grow along a path.
+    static AK_FORCE_INLINE float getRemainingDistanceLowerBound(
+            const Weighting *const weighting, const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode) {
+        if (weighting->needsToNormalizeCompoundDistance()) {
+            return -1.0f;
+        }
+        return weighting->getRemainingCostLowerBound(traverseSession, dicNode);
+    }
+
  protected:
     virtual float getTerminalSpatialCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const = 0;
@@ -71,6 +83,15 @@ class Weighting {
             const DicTraverseSession *const traverseSession, const DicNode *const dicNode,
             float dicNodeLanguageImprobability) const = 0;
 
+    // A lower bound of the language cost of the words the node may still reach. It must never
+    // be greater than the cost they get at their terminal.
+    virtual float getLanguageLookAheadCost(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode) const = 0;
+
+    // See getRemainingDistanceLowerBound(). Only called if the distance is not normalized.
+    virtual float getRemainingCostLowerBound(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode) const = 0;
+
     virtual bool needsToNormalizeCompoundDistance() const = 0;
 
     virtual float getAdditionalProximityCost() const = 0;
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: batch_suggest.cpp"
+
+#include "suggest/core/session/batch_suggest.h"
+
+#include <cstring>
+#include <stdint.h>
+
+#include "defines.h"
+#include "dic_traverse_wrapper.h"
+#include "dictionary.h"
+#include "jni.h"
+
+namespace latinime {
+
+const int BatchSuggest::MAX_THREAD_COUNT = 64;
+
+void BatchSuggestResults::clear() {
+    mResultStarts.assign(1, 0);
+    mWordStarts.assign(1, 0);
+    mCodePoints.clear();
+    mScores.clear();
+    mSpaceIndices.clear();
+    mOutputTypes.clear();
+}
+
+void BatchSuggestResults::addInput(const int count, const int *const outputCodePoints,
+        const int *const scores, const int *const spaceIndices, const int *const outputTypes) {
+    for (int i = 0; i < count; ++i) {
+        const int *const word = &outputCodePoints[i * MAX_WORD_LENGTH];
+        int length = 0;
+        while (length < MAX_WORD_LENGTH && word[length] != 0) {
+            ++length;
+        }
+        mCodePoints.insert(mCodePoints.end(), word, word + length);
+        mWordStarts.push_back(getCodePointCount());
+    }
+    mScores.insert(mScores.end(), scores, scores + count);
+    mSpaceIndices.insert(mSpaceIndices.end(), spaceIndices, spaceIndices + count);
+    mOutputTypes.insert(mOutputTypes.end(), outputTypes, outputTypes + count);
+    mResultStarts.push_back(getResultCount());
+}
+
+void BatchSuggestResults::append(const BatchSuggestResults &results) {
+    const int resultOffset = getResultCount();
+    for (int i = 1; i < static_cast<int>(results.mResultStarts.size()); ++i) {
+        mResultStarts.push_back(resultOffset + results.mResultStarts[i]);
+    }
+    const int codePointOffset = getCodePointCount();
+    for (int i = 1; i < static_cast<int>(results.mWordStarts.size()); ++i) {
+        mWordStarts.push_back(codePointOffset + results.mWordStarts[i]);
+    }
+    mCodePoints.insert(mCodePoints.end(), results.mCodePoints.begin(),
+            results.mCodePoints.end());
+    mScores.insert(mScores.end(), results.mScores.begin(), results.mScores.end());
+    mSpaceIndices.insert(mSpaceIndices.end(), results.mSpaceIndices.begin(),
+            results.mSpaceIndices.end());
+    mOutputTypes.insert(mOutputTypes.end(), results.mOutputTypes.begin(),
+            results.mOutputTypes.end());
+}
+
+/**
+ * Searches the inputs of one slice of a batch on the session of its part.
+ */
+class BatchSuggest::BatchTask : public WorkerThreadPool::Task {
+ public:
+    BatchTask(std::vector<Part *> *const parts, const Dictionary *const dictionary,
+            ProximityInfo *const proximityInfo, const int inputCount,
+            const int *const inputStarts, int *const xCoordinates, int *const yCoordinates,
+            int *const times, int *const pointerIds, int *const inputCodePoints,
+            const int *const prevWordStarts, int *const prevWordCodePoints, const bool isGesture,
+            const bool useFullEditDistance)
+            : mParts(parts), mDictionary(dictionary), mProximityInfo(proximityInfo),
+              mInputCount(inputCount), mInputStarts(inputStarts), mXCoordinates(xCoordinates),
+              mYCoordinates(yCoordinates), mTimes(times), mPointerIds(pointerIds),
+              mInputCodePoints(inputCodePoints), mPrevWordStarts(prevWordStarts),
+              mPrevWordCodePoints(prevWordCodePoints), mIsGesture(isGesture),
+              mUseFullEditDistance(useFullEditDistance) {}
+
+    // The slices are contiguous, so that the prefixes of a word are searched in order on the
+    // same session, and that merging the parts in order gives the input order.
+    static int getSliceBegin(const int inputCount, const int partIndex, const int partCount) {
+        return static_cast<int>(static_cast<int64_t>(inputCount) * partIndex / partCount);
+    }
+
+    void run(const int partIndex) {
+        const int partCount = static_cast<int>(mParts->size());
+        Part *const part = (*mParts)[partIndex];
+        part->mResults.clear();
+        const int end = getSliceBegin(mInputCount, partIndex + 1, partCount);
+        for (int i = getSliceBegin(mInputCount, partIndex, partCount); i < end; ++i) {
+            const int pointStart = mInputStarts[i];
+            const int inputSize = mInputStarts[i + 1] - pointStart;
+            const int prevWordStart = mPrevWordStarts[i];
+            const int prevWordLength = mPrevWordStarts[i + 1] - prevWordStart;
+            int *const prevWordCodePoints =
+                    prevWordLength > 0 ? &mPrevWordCodePoints[prevWordStart] : 0;
+            int count = 0;
+            if (mIsGesture || inputSize > 0) {
+                // Like BinaryDictionary.getSuggestions(), which does not search those.
+                if (mIsGesture || inputSize < MAX_WORD_LENGTH) {
+                    count = mDictionary->getSuggestions(mProximityInfo, part->mTraverseSession,
+                            &mXCoordinates[pointStart], &mYCoordinates[pointStart],
+                            &mTimes[pointStart], &mPointerIds[pointStart],
+                            &mInputCodePoints[pointStart], inputSize, prevWordCodePoints,
+                            prevWordLength, 0 /* commitPoint */, mIsGesture,
+                            mUseFullEditDistance, part->mOutputCodePoints, part->mScores,
+                            part->mSpaceIndices, part->mOutputTypes);
+                }
+            } else {
+                count = mDictionary->getBigrams(prevWordCodePoints, prevWordLength,
+                        &mInputCodePoints[pointStart], inputSize, part->mOutputCodePoints,
+                        part->mScores, part->mOutputTypes);
+            }
+            part->mResults.addInput(count, part->mOutputCodePoints, part->mScores,
+                    part->mSpaceIndices, part->mOutputTypes);
+            // Only the suggested words have to be cleared for the next search.
+            memset(part->mOutputCodePoints, 0,
+                    count * MAX_WORD_LENGTH * sizeof(part->mOutputCodePoints[0]));
+            memset(part->mScores, 0, sizeof(part->mScores));
+            memset(part->mSpaceIndices, 0, sizeof(part->mSpaceIndices));
+            memset(part->mOutputTypes, 0, sizeof(part->mOutputTypes));
+        }
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(BatchTask);
+
+    std::vector<Part *> *const mParts;
+    const Dictionary *const mDictionary;
+    ProximityInfo *const mProximityInfo;
+    const int mInputCount;
+    const int *const mInputStarts;
+    int *const mXCoordinates;
+    int *const mYCoordinates;
+    int *const mTimes;
+    int *const mPointerIds;
+    int *const mInputCodePoints;
+    const int *const mPrevWordStarts;
+    int *const mPrevWordCodePoints;
+    const bool mIsGesture;
+    const bool mUseFullEditDistance;
+};
+
+BatchSuggest::BatchSuggest(JNIEnv *env, jstring localeStr, const int threadCount)
+        : mParts(), mWorkerThreadPool(), mResults() {
+    const int partCount =
+            mWorkerThreadPool.setPartCount(min(max(1, threadCount), MAX_THREAD_COUNT));
+    for (int i = 0; i < partCount; ++i) {
+        void *const traverseSession = DicTraverseWrapper::getDicTraverseSession(env, localeStr);
+        if (!traverseSession) {
+            break;
+        }
+        mParts.push_back(new Part(traverseSession));
+    }
+    if (static_cast<int>(mParts.size()) != partCount) {
+        AKLOGE("Can't create the traverse sessions of %d threads.", partCount);
+        mWorkerThreadPool.setPartCount(max(1, static_cast<int>(mParts.size())));
+    }
+}
+
+BatchSuggest::~BatchSuggest() {
+    for (size_t i = 0; i < mParts.size(); ++i) {
+        DicTraverseWrapper::releaseDicTraverseSession(mParts[i]->mTraverseSession);
+        delete mParts[i];
+    }
+}
+
+void BatchSuggest::setSearchLimits(const int maxSearchTimeMs, const int maxExpandedDicNodeCount) {
+    for (size_t i = 0; i < mParts.size(); ++i) {
+        DicTraverseWrapper::setDicTraverseSessionSearchLimits(mParts[i]->mTraverseSession,
+                maxSearchTimeMs, maxExpandedDicNodeCount);
+    }
+}
+
+int BatchSuggest::getSuggestions(const Dictionary *const dictionary,
+        ProximityInfo *const proximityInfo, const int inputCount, const int *const inputStarts,
+        int *const xCoordinates, int *const yCoordinates, int *const times,
+        int *const pointerIds, int *const inputCodePoints, const int *const prevWordStarts,
+        int *const prevWordCodePoints, const bool isGesture, const bool useFullEditDistance) {
+    mResults.clear();
+    if (mParts.empty() || inputCount <= 0) {
+        return 0;
+    }
+    BatchTask task(&mParts, dictionary, proximityInfo, inputCount, inputStarts, xCoordinates,
+            yCoordinates, times, pointerIds, inputCodePoints, prevWordStarts, prevWordCodePoints,
+            isGesture, useFullEditDistance);
+    mWorkerThreadPool.run(&task);
+    for (size_t i = 0; i < mParts.size(); ++i) {
+        mResults.append(mParts[i]->mResults);
+        mParts[i]->mResults.clear();
+    }
+    return mResults.getResultCount();
+}
+} // namespace latinime
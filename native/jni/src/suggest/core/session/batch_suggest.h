@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_BATCH_SUGGEST_H
+#define LATINIME_BATCH_SUGGEST_H
+
+#include <vector>
+
+#include "defines.h"
+#include "jni.h"
+#include "suggest/core/session/worker_thread_pool.h"
+
+namespace latinime {
+
+class Dictionary;
+class ProximityInfo;
+
+/**
+ * Suggestions of a batch of inputs, packed in input order. The suggestions of input i are the
+ * entries [mResultStarts[i], mResultStarts[i + 1]) of mScores, mSpaceIndices and mOutputTypes,
+ * and the code points of suggestion j are [mWordStarts[j], mWordStarts[j + 1]) of mCodePoints.
+ */
+struct BatchSuggestResults {
+    BatchSuggestResults()
+            : mResultStarts(1, 0), mWordStarts(1, 0), mCodePoints(), mScores(), mSpaceIndices(),
+              mOutputTypes() {}
+
+    int getInputCount() const { return static_cast<int>(mResultStarts.size()) - 1; }
+    int getResultCount() const { return static_cast<int>(mScores.size()); }
+    int getCodePointCount() const { return static_cast<int>(mCodePoints.size()); }
+
+    void clear();
+    // Appends the suggestions of one input, in the layout of Dictionary::getSuggestions().
+    void addInput(const int count, const int *const outputCodePoints, const int *const scores,
+            const int *const spaceIndices, const int *const outputTypes);
+    // Appends the inputs of results.
+    void append(const BatchSuggestResults &results);
+
+    std::vector<int> mResultStarts;
+    std::vector<int> mWordStarts;
+    std::vector<int> mCodePoints;
+    std::vector<int> mScores;
+    std::vector<int> mSpaceIndices;
+    std::vector<int> mOutputTypes;
+};
+
+/**
+ * Searches the suggestions of many inputs at once, for offline evaluation. Each thread searches
+ * a contiguous slice of the inputs on a traverse session of its own that is kept from batch to
+ * batch, so that the consecutive prefixes of a word continue each other's searches like on a
+ * device. The suggestions are the same as the ones of Dictionary::getSuggestions() for each
+ * input on its own.
+ */
+class BatchSuggest {
+ public:
+    // Creates threadCount traverse sessions for localeStr, up to MAX_THREAD_COUNT, or fewer if
+    // threads can't be started.
+    BatchSuggest(JNIEnv *env, jstring localeStr, const int threadCount);
+    ~BatchSuggest();
+
+    int getThreadCount() const { return static_cast<int>(mParts.size()); }
+
+    // Limits the search of each input, like DicTraverseSession::setSearchLimits().
+    void setSearchLimits(const int maxSearchTimeMs, const int maxExpandedDicNodeCount);
+
+    // Searches the suggestions of inputCount inputs packed in flat arrays: input i is made of
+    // the points [inputStarts[i], inputStarts[i + 1]) of xCoordinates, yCoordinates, times,
+    // pointerIds and inputCodePoints, and its previous word is the code points
+    // [prevWordStarts[i], prevWordStarts[i + 1]) of prevWordCodePoints, none if that is empty.
+    // An input without points gets the predictions of its previous word, unless isGesture. Typed
+    // inputs of MAX_WORD_LENGTH points or more get no suggestions. Returns the number of
+    // suggestions, which getResults() returns until the next batch.
+    int getSuggestions(const Dictionary *const dictionary, ProximityInfo *const proximityInfo,
+            const int inputCount, const int *const inputStarts, int *const xCoordinates,
+            int *const yCoordinates, int *const times, int *const pointerIds,
+            int *const inputCodePoints, const int *const prevWordStarts,
+            int *const prevWordCodePoints, const bool isGesture, const bool useFullEditDistance);
+
+    const BatchSuggestResults *getResults() const { return &mResults; }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(BatchSuggest);
+
+    class BatchTask;
+
+    static const int MAX_THREAD_COUNT;
+
+    // The session of a thread, with the outputs of its searches
+    struct Part {
+        explicit Part(void *const traverseSession)
+                : mTraverseSession(traverseSession), mResults(), mOutputCodePoints(),
+                  mScores(), mSpaceIndices(), mOutputTypes() {}
+
+        void *const mTraverseSession;
+        BatchSuggestResults mResults;
+        // The code points are kept zeroed in between the searches, as the suggested words are
+        // not null terminated.
+        int mOutputCodePoints[MAX_WORD_LENGTH * MAX_RESULTS];
+        int mScores[MAX_RESULTS];
+        int mSpaceIndices[MAX_RESULTS];
+        int mOutputTypes[MAX_RESULTS];
+
+     private:
+        DISALLOW_IMPLICIT_CONSTRUCTORS(Part);
+    };
+
+    std::vector<Part *> mParts;
+    WorkerThreadPool mWorkerThreadPool;
+    BatchSuggestResults mResults;
+};
+} // namespace latinime
+#endif // LATINIME_BATCH_SUGGEST_H
@@ -16,6 +16,9 @@
 
 #include "suggest/core/session/dic_traverse_session.h"
 
+#include <cstring>
+#include <time.h>
+
 #include "binary_format.h"
 #include "defines.h"
 #include "dictionary.h"
@@ -26,6 +29,7 @@
 namespace latinime {
 
 const int DicTraverseSession::CACHE_START_INPUT_LENGTH_THRESHOLD = 20;
+const int DicTraverseSession::MAX_EXPANSION_THREAD_COUNT = 8;
 
 // A factory method for DicTraverseSession
 static void *getSessionInstance(JNIEnv *env, jstring localeStr) {
@@ -41,6 +45,23 @@ static void initSessionInstance(void *traverseSession, const Dictionary *const d
     }
 }
 
+// TODO: Pass "DicTraverseSession *traverseSession" when the source code structure settles down.
+static void setSessionInstanceSearchLimits(void *traverseSession, const int maxSearchTimeMs,
+        const int maxExpandedDicNodeCount) {
+    if (traverseSession) {
+        DicTraverseSession *tSession = static_cast<DicTraverseSession *>(traverseSession);
+        tSession->setSearchLimits(maxSearchTimeMs, maxExpandedDicNodeCount);
+    }
+}
+
+// TODO: Pass "DicTraverseSession *traverseSession" when the source code structure settles down.
+static void setSessionInstanceExpansionThreadCount(void *traverseSession, const int threadCount) {
+    if (traverseSession) {
+        DicTraverseSession *tSession = static_cast<DicTraverseSession *>(traverseSession);
+        tSession->setExpansionThreadCount(threadCount);
+    }
+}
+
 // TODO: Pass "DicTraverseSession *traverseSession" when the source code structure settles down.
 static void releaseSessionInstance(void *traverseSession) {
     delete static_cast<DicTraverseSession *>(traverseSession);
@@ -52,6 +73,9 @@ class TraverseSessionFactoryRegisterer {
     TraverseSessionFactoryRegisterer() {
         DicTraverseWrapper::setTraverseSessionFactoryMethod(getSessionInstance);
         DicTraverseWrapper::setTraverseSessionInitMethod(initSessionInstance);
+        DicTraverseWrapper::setTraverseSessionSearchLimitsMethod(setSessionInstanceSearchLimits);
+        DicTraverseWrapper::setTraverseSessionExpansionThreadCountMethod(
+                setSessionInstanceExpansionThreadCount);
         DicTraverseWrapper::setTraverseSessionReleaseMethod(releaseSessionInstance);
     }
  private:
@@ -61,50 +85,133 @@ class TraverseSessionFactoryRegisterer {
 // To invoke the TraverseSessionFactoryRegisterer constructor in the global constructor.
 static TraverseSessionFactoryRegisterer traverseSessionFactoryRegisterer;
 
+static int64_t getMonotonicTimeMs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
 void DicTraverseSession::init(const Dictionary *const dictionary, const int *prevWord,
         int prevWordLength) {
-    mDictionary = dictionary;
-    mMultiWordCostMultiplier = BinaryFormat::getMultiWordCostMultiplier(mDictionary->getDict(),
-            mDictionary->getDictSize());
-    if (!prevWord) {
-        mPrevWordPos = NOT_VALID_WORD;
-        return;
+    const float weight = 0.0f;
+    init(&dictionary, &weight, 1 /* dictionaryCount */, prevWord, prevWordLength);
+}
+
+void DicTraverseSession::init(const Dictionary *const *dictionaries, const float *weights,
+        const int dictionaryCount, const int *prevWord, const int prevWordLength) {
+    const int lastDictionaryCount = mSearchedDictionaryCount;
+    mSearchedDictionaryCount = max(1, min(dictionaryCount, MAX_SEARCHED_DICTIONARY_COUNT));
+    // The dic nodes of the checkpoints carry the previous word of their search, so a session
+    // passed from one caller to another must not continue from them.
+    bool isSameSearch = mSearchedDictionaryCount == lastDictionaryCount;
+    for (int i = 0; i < mSearchedDictionaryCount; ++i) {
+        const Dictionary *const dictionary = dictionaries[i];
+        SearchedDictionary *const searchedDictionary = &mSearchedDictionaries[i];
+        const int prevWordPos = getTerminalPosition(dictionary, prevWord, prevWordLength);
+        isSameSearch = isSameSearch && searchedDictionary->mDictionary == dictionary
+                // The exact same weight, not to compare floats
+                && memcmp(&searchedDictionary->mWeight, &weights[i], sizeof(weights[i])) == 0
+                && searchedDictionary->mPrevWordPos == prevWordPos;
+        searchedDictionary->mDictionary = dictionary;
+        searchedDictionary->mWeight = weights[i];
+        searchedDictionary->mPrevWordPos = prevWordPos;
+        searchedDictionary->mMultiWordCostMultiplier = BinaryFormat::getMultiWordCostMultiplier(
+                dictionary->getDict(), dictionary->getDictSize());
+        searchedDictionary->mSubtreeProbabilityIndex = dictionary->getSubtreeProbabilityIndex();
+    }
+    if (!isSameSearch) {
+        mDicNodesCache.clearCheckpoints();
     }
-    // TODO: merge following similar calls to getTerminalPosition into one case-insensitive call.
-    mPrevWordPos = BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
-            prevWordLength, false /* forceLowerCaseSearch */);
-    if (mPrevWordPos == NOT_VALID_WORD) {
-        // Check bigrams for lower-cased previous word if original was not found. Useful for
-        // auto-capitalized words like "The [current_word]".
-        mPrevWordPos = BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), prevWord,
-                prevWordLength, true /* forceLowerCaseSearch */);
+}
+
+/* static */ int DicTraverseSession::getTerminalPosition(const Dictionary *const dictionary,
+        const int *const word, const int length) {
+    if (!word) {
+        return NOT_VALID_WORD;
+    }
+    // TODO: merge following similar calls to getTerminalPosition into one case-insensitive
+    // call.
+    const int pos = BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), word, length,
+            false /* forceLowerCaseSearch */, dictionary->getCharGroupLookupIndex(),
+            dictionary->supportsDynamicUpdate(), dictionary->getHeaderSize());
+    if (pos != NOT_VALID_WORD) {
+        return pos;
     }
+    // Check bigrams for lower-cased previous word if original was not found. Useful for
+    // auto-capitalized words like "The [current_word]".
+    return BinaryFormat::getTerminalPosition(dictionary->getOffsetDict(), word, length,
+            true /* forceLowerCaseSearch */, dictionary->getCharGroupLookupIndex(),
+            dictionary->supportsDynamicUpdate(), dictionary->getHeaderSize());
 }
 
 void DicTraverseSession::setupForGetSuggestions(const ProximityInfo *pInfo,
         const int *inputCodePoints, const int inputSize, const int *const inputXs,
         const int *const inputYs, const int *const times, const int *const pointerIds,
         const float maxSpatialDistance, const int maxPointerCount) {
+    // Points on another keyboard, or searched by another policy, are not continued either.
+    if (pInfo != mProximityInfo || maxPointerCount != mMaxPointerCount) {
+        mDicNodesCache.clearCheckpoints();
+    }
     mProximityInfo = pInfo;
     mMaxPointerCount = maxPointerCount;
     initializeProximityInfoStates(inputCodePoints, inputXs, inputYs, times, pointerIds, inputSize,
             maxSpatialDistance, maxPointerCount);
 }
 
-const uint8_t *DicTraverseSession::getOffsetDict() const {
-    return mDictionary->getOffsetDict();
+const uint8_t *DicTraverseSession::getOffsetDict(const int dictionaryIndex) const {
+    return mSearchedDictionaries[dictionaryIndex].mDictionary->getOffsetDict();
 }
 
-int DicTraverseSession::getDictFlags() const {
-    return mDictionary->getDictFlags();
+int DicTraverseSession::getDictFlags(const int dictionaryIndex) const {
+    return mSearchedDictionaries[dictionaryIndex].mDictionary->getDictFlags();
+}
+
+bool DicTraverseSession::supportsDynamicUpdate(const int dictionaryIndex) const {
+    return mSearchedDictionaries[dictionaryIndex].mDictionary->supportsDynamicUpdate();
+}
+
+int DicTraverseSession::getHeaderSize(const int dictionaryIndex) const {
+    return mSearchedDictionaries[dictionaryIndex].mDictionary->getHeaderSize();
 }
 
 void DicTraverseSession::resetCache(const int nextActiveCacheSize, const int maxWords) {
     mDicNodesCache.reset(nextActiveCacheSize, maxWords);
+    // No node refers to the word arena any more.
+    mDicNodeWordArena.clear();
     mMultiBigramMap.clear();
+    for (size_t i = 0; i < mParallelWorkers.size(); ++i) {
+        mParallelWorkers[i]->clearMultiBigramMap();
+    }
     mPartiallyCommited = false;
 }
 
+void DicTraverseSession::startSearch() {
+    mSearchStartTimeMs = mMaxSearchTimeMs > 0 ? getMonotonicTimeMs() : 0;
+    mExpandedDicNodeCount = 0;
+    mIsSearchInterrupted = false;
+}
+
+bool DicTraverseSession::isSearchLimitReached() const {
+    if (mMaxExpandedDicNodeCount > 0 && mExpandedDicNodeCount >= mMaxExpandedDicNodeCount) {
+        return true;
+    }
+    return mMaxSearchTimeMs > 0 && getMonotonicTimeMs() - mSearchStartTimeMs >= mMaxSearchTimeMs;
+}
+
+void DicTraverseSession::setExpansionThreadCount(const int threadCount) {
+    const int partCount =
+            mWorkerThreadPool.setPartCount(max(1, min(threadCount, MAX_EXPANSION_THREAD_COUNT)));
+    for (size_t i = 0; i < mParallelWorkers.size(); ++i) {
+        delete mParallelWorkers[i];
+    }
+    mParallelWorkers.clear();
+    if (partCount > 1) {
+        for (int i = 0; i < partCount; ++i) {
+            mParallelWorkers.push_back(new DicTraverseWorker());
+        }
+    }
+}
+
 void DicTraverseSession::initializeProximityInfoStates(const int *const inputCodePoints,
         const int *const inputXs, const int *const inputYs, const int *const times,
         const int *const pointerIds, const int inputSize, const float maxSpatialDistance,
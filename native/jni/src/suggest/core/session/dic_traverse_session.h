@@ -24,28 +24,43 @@
 #include "jni.h"
 #include "multi_bigram_map.h"
 #include "proximity_info_state.h"
+#include "suggest/core/dicnode/dic_node_word_arena.h"
 #include "suggest/core/dicnode/dic_nodes_cache.h"
+#include "suggest/core/session/dic_traverse_worker.h"
+#include "suggest/core/session/worker_thread_pool.h"
 
 namespace latinime {
 
 class Dictionary;
 class ProximityInfo;
+class SubtreeProbabilityIndex;
 
 class DicTraverseSession {
  public:
     AK_FORCE_INLINE DicTraverseSession(JNIEnv *env, jstring localeStr)
-            : mPrevWordPos(NOT_VALID_WORD), mProximityInfo(0),
-              mDictionary(0), mDicNodesCache(), mMultiBigramMap(),
+            : mProximityInfo(0), mSearchedDictionaries(), mSearchedDictionaryCount(0),
+              mOutputDictionaryIndices(), mDicNodesCache(), mDicNodeWordArena(), mMultiBigramMap(),
               mInputSize(0), mPartiallyCommited(false), mMaxPointerCount(1),
-              mMultiWordCostMultiplier(1.0f) {
+              mMaxSearchTimeMs(0), mMaxExpandedDicNodeCount(0), mSearchStartTimeMs(0),
+              mExpandedDicNodeCount(0), mIsSearchInterrupted(false), mSerialWorker(),
+              mParallelWorkers(), mWorkerThreadPool(), mParallelActiveDicNodes() {
         // NOTE: mProximityInfoStates is an array of instances.
         // No need to initialize it explicitly here.
+        mSerialWorker.initForSerialExpansion(&mDicNodesCache, &mMultiBigramMap);
     }
 
     // Non virtual inline destructor -- never inherit this class
-    AK_FORCE_INLINE ~DicTraverseSession() {}
+    AK_FORCE_INLINE ~DicTraverseSession() {
+        setExpansionThreadCount(1);
+    }
 
     void init(const Dictionary *dictionary, const int *prevWord, int prevWordLength);
+    // Searches dictionaryCount dictionaries together, up to MAX_SEARCHED_DICTIONARY_COUNT, in
+    // one search sharing the input and the dic nodes. The first one is the main dictionary, and
+    // the words of dictionaries[i] get weights[i] added to their compound distance. The dic
+    // nodes know their dictionary by its index in dictionaries.
+    void init(const Dictionary *const *dictionaries, const float *weights,
+            const int dictionaryCount, const int *prevWord, const int prevWordLength);
     // TODO: Remove and merge into init
     void setupForGetSuggestions(const ProximityInfo *pInfo, const int *inputCodePoints,
             const int inputSize, const int *const inputXs, const int *const inputYs,
@@ -53,20 +68,60 @@ class DicTraverseSession {
             const int maxPointerCount);
     void resetCache(const int nextActiveCacheSize, const int maxWords);
 
+    // Limits each following search to maxSearchTimeMs milliseconds and to
+    // maxExpandedDicNodeCount expanded dic nodes. A limit of 0 or less means none.
+    void setSearchLimits(const int maxSearchTimeMs, const int maxExpandedDicNodeCount) {
+        mMaxSearchTimeMs = maxSearchTimeMs;
+        mMaxExpandedDicNodeCount = maxExpandedDicNodeCount;
+    }
+    // Starts measuring the search against the limits.
+    void startSearch();
+    bool isSearchLimitReached() const;
+    void countExpandedDicNodes(const int count) { mExpandedDicNodeCount += count; }
+    int getExpandedDicNodeCount() const { return mExpandedDicNodeCount; }
+    // The checkpoints are saved before the expansion of their dic nodes, so that the next search
+    // can still continue from the ones of an interrupted search.
+    void interruptSearch() { mIsSearchInterrupted = true; }
+    bool isSearchInterrupted() const { return mIsSearchInterrupted; }
+
+    // Expands the active dic nodes on threadCount threads, up to MAX_EXPANSION_THREAD_COUNT, when
+    // there are enough of them. The default of 1 thread expands them on the calling thread only.
+    void setExpansionThreadCount(const int threadCount);
+    int getExpansionThreadCount() const { return mWorkerThreadPool.getPartCount(); }
+    DicTraverseWorker *getSerialWorker() { return &mSerialWorker; }
+    // The worker of the slice sliceIndex of a parallel expansion
+    DicTraverseWorker *getParallelWorker(const int sliceIndex) {
+        return mParallelWorkers[sliceIndex];
+    }
+    WorkerThreadPool *getWorkerThreadPool() { return &mWorkerThreadPool; }
+    // The active dic nodes being expanded in parallel
+    std::vector<DicNode> *getParallelActiveDicNodes() { return &mParallelActiveDicNodes; }
+
+    int getDictionaryCount() const { return mSearchedDictionaryCount; }
     // TODO: Remove
-    const uint8_t *getOffsetDict() const;
-    int getDictFlags() const;
+    const uint8_t *getOffsetDict(const int dictionaryIndex) const;
+    int getDictFlags(const int dictionaryIndex) const;
+    bool supportsDynamicUpdate(const int dictionaryIndex) const;
+    int getHeaderSize(const int dictionaryIndex) const;
+    float getDictionaryWeight(const int dictionaryIndex) const {
+        return mSearchedDictionaries[dictionaryIndex].mWeight;
+    }
 
     //--------------------
     // getters and setters
     //--------------------
     const ProximityInfo *getProximityInfo() const { return mProximityInfo; }
-    int getPrevWordPos() const { return mPrevWordPos; }
+    int getPrevWordPos(const int dictionaryIndex) const {
+        return mSearchedDictionaries[dictionaryIndex].mPrevWordPos;
+    }
     // TODO: REMOVE
-    void setPrevWordPos(int pos) { mPrevWordPos = pos; }
+    void setPrevWordPos(const int dictionaryIndex, int pos) {
+        mSearchedDictionaries[dictionaryIndex].mPrevWordPos = pos;
+    }
     // TODO: Use proper parameter when changed
     int getDicRootPos() const { return 0; }
     DicNodesCache *getDicTraverseCache() { return &mDicNodesCache; }
+    DicNodeWordArena *getDicNodeWordArena() { return &mDicNodeWordArena; }
     MultiBigramMap *getMultiBigramMap() { return &mMultiBigramMap; }
     const ProximityInfoState *getProximityInfoState(int id) const {
         return &mProximityInfoStates[id];
@@ -92,17 +147,17 @@ class DicTraverseSession {
         return true;
     }
 
-    void getSearchKeys(const DicNode *node, std::vector<int> *const outputSearchKeyVector) const {
+    // Returns the ids of the keys to search from the input indices of node, for all pointers.
+    ProximityInfoStateUtils::NearKeycodesSet getSearchKeys(const DicNode *node) const {
+        ProximityInfoStateUtils::NearKeycodesSet searchKeys;
         for (int i = 0; i < MAX_POINTER_COUNT_G; ++i) {
             if (!mProximityInfoStates[i].isUsed()) {
                 continue;
             }
             const int pointerId = node->getInputIndex(i);
-            const std::vector<int> *const searchKeyVector =
-                    mProximityInfoStates[i].getSearchKeyVector(pointerId);
-            outputSearchKeyVector->insert(outputSearchKeyVector->end(), searchKeyVector->begin(),
-                    searchKeyVector->end());
+            searchKeys |= *mProximityInfoStates[i].getSearchKeySet(pointerId);
         }
+        return searchKeys;
     }
 
     ProximityType getProximityTypeG(const DicNode *const node, const int childCodePoint) const {
@@ -124,51 +179,81 @@ class DicTraverseSession {
         return proximityType;
     }
 
-    AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        return mDicNodesCache.isCacheBorderForTyping(inputSize);
+    AK_FORCE_INLINE bool isCheckpointInputIndexForTyping(const int inputSize) const {
+        return mDicNodesCache.isCheckpointInputIndexForTyping(inputSize);
     }
 
     /**
-     * Returns whether or not it is possible to continue suggestion from the previous search.
+     * Returns the last input index whose checkpoint the search can continue from: the points
+     * before it are the ones of the previous search, and it is before the input size like the
+     * input indices of the checkpoints.
      */
-    // TODO: Remove. No need to check once the session is fully implemented.
-    bool isContinuousSuggestionPossible() const {
-        if (!mDicNodesCache.hasCachedDicNodesForContinuousSuggestion()) {
-            return false;
-        }
+    int getLastContinuableInputIndex() const {
+        int inputIndex = mInputSize - 1;
         ASSERT(mMaxPointerCount <= MAX_POINTER_COUNT_G);
         for (int i = 0; i < mMaxPointerCount; ++i) {
             const ProximityInfoState *const pInfoState = getProximityInfoState(i);
-            // If a proximity info state is not continuous suggestion possible,
-            // do not continue searching.
-            if (pInfoState->isUsed() && !pInfoState->isContinuousSuggestionPossible()) {
-                return false;
+            if (pInfoState->isUsed()) {
+                inputIndex = min(inputIndex, pInfoState->getSharedSampledInputSize());
             }
         }
-        return true;
+        return inputIndex;
     }
 
     bool isTouchPositionCorrectionEnabled() const {
         return mProximityInfoStates[0].touchPositionCorrectionEnabled();
     }
 
-    float getMultiWordCostMultiplier() const {
-        return mMultiWordCostMultiplier;
+    float getMultiWordCostMultiplier(const int dictionaryIndex) const {
+        return mSearchedDictionaries[dictionaryIndex].mMultiWordCostMultiplier;
+    }
+
+    // Null when the dictionary is not indexed.
+    const SubtreeProbabilityIndex *getSubtreeProbabilityIndex(const int dictionaryIndex) const {
+        return mSearchedDictionaries[dictionaryIndex].mSubtreeProbabilityIndex;
+    }
+
+    // The dictionary of each suggestion of the last search, which outputs them
+    int getOutputDictionaryIndex(const int outputIndex) const {
+        return mOutputDictionaryIndices[outputIndex];
+    }
+    void setOutputDictionaryIndex(const int outputIndex, const int dictionaryIndex) {
+        mOutputDictionaryIndices[outputIndex] = dictionaryIndex;
     }
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(DicTraverseSession);
     // threshold to start caching
     static const int CACHE_START_INPUT_LENGTH_THRESHOLD;
+    static const int MAX_EXPANSION_THREAD_COUNT;
+    // Returns the position of the terminal of word in dictionary, or NOT_VALID_WORD.
+    static int getTerminalPosition(const Dictionary *const dictionary, const int *const word,
+            const int length);
+    // A dictionary searched by the session, with its configuration
+    struct SearchedDictionary {
+        SearchedDictionary()
+                : mDictionary(0), mWeight(0.0f), mPrevWordPos(NOT_VALID_WORD),
+                  mMultiWordCostMultiplier(1.0f), mSubtreeProbabilityIndex(0) {}
+
+        const Dictionary *mDictionary;
+        float mWeight;
+        int mPrevWordPos;
+        float mMultiWordCostMultiplier;
+        const SubtreeProbabilityIndex *mSubtreeProbabilityIndex;
+    };
+
     void initializeProximityInfoStates(const int *const inputCodePoints, const int *const inputXs,
             const int *const inputYs, const int *const times, const int *const pointerIds,
             const int inputSize, const float maxSpatialDistance, const int maxPointerCount);
 
-    int mPrevWordPos;
     const ProximityInfo *mProximityInfo;
-    const Dictionary *mDictionary;
+    SearchedDictionary mSearchedDictionaries[MAX_SEARCHED_DICTIONARY_COUNT];
+    int mSearchedDictionaryCount;
+    int mOutputDictionaryIndices[MAX_RESULTS];
 
     DicNodesCache mDicNodesCache;
+    // Code points of the dic nodes in mDicNodesCache
+    DicNodeWordArena mDicNodeWordArena;
     // Temporary cache for bigram frequencies
     MultiBigramMap mMultiBigramMap;
     ProximityInfoState mProximityInfoStates[MAX_POINTER_COUNT_G];
@@ -177,10 +262,18 @@ class DicTraverseSession {
     bool mPartiallyCommited;
     int mMaxPointerCount;
 
-    /////////////////////////////////
-    // Configuration per dictionary
-    float mMultiWordCostMultiplier;
+    // Search limits
+    int mMaxSearchTimeMs;
+    int mMaxExpandedDicNodeCount;
+    int64_t mSearchStartTimeMs;
+    int mExpandedDicNodeCount;
+    bool mIsSearchInterrupted;
 
+    // Expansion of the active dic nodes
+    DicTraverseWorker mSerialWorker;
+    std::vector<DicTraverseWorker *> mParallelWorkers;
+    WorkerThreadPool mWorkerThreadPool;
+    std::vector<DicNode> mParallelActiveDicNodes;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_TRAVERSE_SESSION_H
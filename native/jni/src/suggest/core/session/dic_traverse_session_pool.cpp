@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: dic_traverse_session_pool.cpp"
+
+#include "suggest/core/session/dic_traverse_session_pool.h"
+
+#include "defines.h"
+#include "suggest/core/session/dic_traverse_session.h"
+
+namespace latinime {
+
+DicTraverseSessionPool::DicTraverseSessionPool() : mIdleSessions() {}
+
+DicTraverseSessionPool::~DicTraverseSessionPool() {
+    // No session is lent anymore when the dictionary goes away.
+    for (int i = 0; i < MAX_IDLE_SESSION_COUNT; ++i) {
+        delete mIdleSessions[i];
+    }
+}
+
+DicTraverseSession *DicTraverseSessionPool::acquire() {
+    for (int i = 0; i < MAX_IDLE_SESSION_COUNT; ++i) {
+        // Takes whatever the slot holds, with acquire semantics.
+        DicTraverseSession *const session = __sync_lock_test_and_set(&mIdleSessions[i],
+                static_cast<DicTraverseSession *>(0));
+        if (session) {
+            return session;
+        }
+    }
+    // The sessions do not use the locale.
+    return new DicTraverseSession(0 /* env */, 0 /* localeStr */);
+}
+
+void DicTraverseSessionPool::release(DicTraverseSession *const session) {
+    session->setSearchLimits(0, 0);
+    if (session->getExpansionThreadCount() != 1) {
+        session->setExpansionThreadCount(1);
+    }
+    for (int i = 0; i < MAX_IDLE_SESSION_COUNT; ++i) {
+        // A full barrier, so that the next owner sees the session as it is left.
+        if (__sync_bool_compare_and_swap(&mIdleSessions[i], static_cast<DicTraverseSession *>(0),
+                session)) {
+            return;
+        }
+    }
+    delete session;
+}
+} // namespace latinime
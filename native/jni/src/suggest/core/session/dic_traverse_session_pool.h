@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_TRAVERSE_SESSION_POOL_H
+#define LATINIME_DIC_TRAVERSE_SESSION_POOL_H
+
+#include "defines.h"
+
+namespace latinime {
+
+class DicTraverseSession;
+
+/**
+ * Traverse sessions lent to the callers that search a dictionary without a session of their own,
+ * so that concurrent callers can share the dictionary. Idle sessions wait in a fixed number of
+ * slots that are emptied with atomic exchanges and filled with atomic compare-and-swaps, so
+ * neither lending nor giving back ever blocks: a new session is created when no slot holds one,
+ * and a session given back when all the slots are full is deleted.
+ */
+class DicTraverseSessionPool {
+ public:
+    DicTraverseSessionPool();
+    ~DicTraverseSessionPool();
+
+    // Returns an idle session, or a new one if there is none. Thread safe.
+    DicTraverseSession *acquire();
+    // Gives back a session returned by acquire(), after resetting its search limits and its
+    // expansion threads. Thread safe.
+    void release(DicTraverseSession *const session);
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicTraverseSessionPool);
+
+    static const int MAX_IDLE_SESSION_COUNT = 4;
+
+    // Only accessed with atomic builtins while the pool is shared.
+    DicTraverseSession *mIdleSessions[MAX_IDLE_SESSION_COUNT];
+};
+} // namespace latinime
+#endif // LATINIME_DIC_TRAVERSE_SESSION_POOL_H
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_TRAVERSE_WORKER_H
+#define LATINIME_DIC_TRAVERSE_WORKER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "defines.h"
+#include "multi_bigram_map.h"
+#include "suggest/core/dicnode/dic_node.h"
+#include "suggest/core/dicnode/dic_node_word_arena.h"
+#include "suggest/core/dicnode/dic_nodes_cache.h"
+
+namespace latinime {
+
+/**
+ * Destination of the dic nodes created by the expansion of active dic nodes on one thread.
+ *
+ * The worker of the serial search pushes them to the cache of the session. The worker of each
+ * slice of a parallel expansion records them instead, and the code points they append go to a
+ * region of the word arena of the session. Merging the workers in the order of their slices then
+ * pushes the same dic nodes in the same order as the serial search, which keeps the result
+ * identical, including among dic nodes of the same score.
+ */
+class DicTraverseWorker {
+ public:
+    AK_FORCE_INLINE DicTraverseWorker()
+            : mDicNodesCache(0), mMultiBigramMap(0), mOwnMultiBigramMap(), mWordArena(),
+              mRecordedDicNodes(), mRecordedQueueIds(), mRecordedDicNodeCountBeforeExpansion(0),
+              mExpandedDicNodeCount(0), mIsExpansionStopped(false) {}
+
+    // Non virtual inline destructor -- never inherit this class
+    AK_FORCE_INLINE ~DicTraverseWorker() {}
+
+    // Pushes the dic nodes to dicNodesCache directly, with the bigrams of multiBigramMap.
+    void initForSerialExpansion(DicNodesCache *const dicNodesCache,
+            MultiBigramMap *const multiBigramMap) {
+        mDicNodesCache = dicNodesCache;
+        mMultiBigramMap = multiBigramMap;
+    }
+
+    // Records the dic nodes expanded from a slice of the active dic nodes until mergeInto(). The
+    // code points they append go to the region of wordArena reserved at regionStart.
+    void startParallelExpansion(DicNodeWordArena *const wordArena, const int regionStart,
+            const int regionSize) {
+        mDicNodesCache = 0;
+        mMultiBigramMap = &mOwnMultiBigramMap;
+        mWordArena.startRegion(wordArena, regionStart, regionSize);
+        mRecordedDicNodes.clear();
+        mRecordedQueueIds.clear();
+        mExpandedDicNodeCount = 0;
+        mIsExpansionStopped = false;
+    }
+
+    // Must be called on every active dic node before expanding it. The serial search counts the
+    // expanded dic nodes in the session directly.
+    AK_FORCE_INLINE void startExpansion(DicNode *const dicNode) {
+        if (!mDicNodesCache) {
+            ++mExpandedDicNodeCount;
+            mRecordedDicNodeCountBeforeExpansion = static_cast<int>(mRecordedDicNodes.size());
+            dicNode->setWordArena(&mWordArena);
+        }
+    }
+
+    // Whether the region of the word arena was too small for the last expanded dic node. It has
+    // then to be expanded again, after cancelExpansion().
+    bool hasWordArenaOverflowed() const {
+        return mWordArena.hasOverflowed();
+    }
+
+    // Forgets the expansion of dicNode, the last expanded one.
+    void cancelExpansion(DicNode *const dicNode) {
+        --mExpandedDicNodeCount;
+        mRecordedDicNodes.resize(mRecordedDicNodeCountBeforeExpansion);
+        mRecordedQueueIds.resize(mRecordedDicNodeCountBeforeExpansion);
+        dicNode->setWordArena(mWordArena.getBaseArena());
+    }
+
+    // Called when an active dic node stops the expansion of the following ones.
+    void stopExpansion() {
+        mIsExpansionStopped = true;
+    }
+
+    int getExpandedDicNodeCount() const { return mExpandedDicNodeCount; }
+    bool isExpansionStopped() const { return mIsExpansionStopped; }
+    MultiBigramMap *getMultiBigramMap() { return mMultiBigramMap; }
+
+    void clearMultiBigramMap() {
+        mOwnMultiBigramMap.clear();
+    }
+
+    AK_FORCE_INLINE void copyPushNextActive(DicNode *dicNode) {
+        if (mDicNodesCache) {
+            mDicNodesCache->copyPushNextActive(dicNode);
+        } else {
+            record(QUEUE_ID_NEXT_ACTIVE, dicNode);
+        }
+    }
+
+    AK_FORCE_INLINE void copyPushTerminal(DicNode *dicNode) {
+        if (mDicNodesCache) {
+            mDicNodesCache->copyPushTerminal(dicNode);
+        } else {
+            record(QUEUE_ID_TERMINAL, dicNode);
+        }
+    }
+
+    // Moves the code points of the recorded dic nodes to the used part of the word arena of the
+    // session. The workers have to do it in the order of their slices, before any mergeInto().
+    void mergeWordArena() {
+        mWordArena.getBaseArena()->mergeRegion(&mWordArena);
+    }
+
+    // Pushes the recorded dic nodes to dicNodesCache, in the order they were recorded.
+    void mergeInto(DicNodesCache *const dicNodesCache) {
+        const int size = static_cast<int>(mRecordedDicNodes.size());
+        for (int i = 0; i < size; ++i) {
+            DicNode *const dicNode = &mRecordedDicNodes[i];
+            dicNode->moveToBaseWordArena();
+            switch (mRecordedQueueIds[i]) {
+                case QUEUE_ID_NEXT_ACTIVE:
+                    dicNodesCache->copyPushNextActive(dicNode);
+                    break;
+                case QUEUE_ID_TERMINAL:
+                    dicNodesCache->copyPushTerminal(dicNode);
+                    break;
+                default:
+                    ASSERT(false);
+                    break;
+            }
+        }
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicTraverseWorker);
+
+    static const uint8_t QUEUE_ID_NEXT_ACTIVE = 0;
+    static const uint8_t QUEUE_ID_TERMINAL = 1;
+
+    // The cache to push to, or null to record the dic nodes
+    DicNodesCache *mDicNodesCache;
+    MultiBigramMap *mMultiBigramMap;
+    // Bigrams of the parallel expansion, which cannot share the cache of the session
+    MultiBigramMap mOwnMultiBigramMap;
+    // Region of the word arena of the session for the recorded dic nodes
+    DicNodeWordArena mWordArena;
+    std::vector<DicNode> mRecordedDicNodes;
+    std::vector<uint8_t> mRecordedQueueIds;
+    int mRecordedDicNodeCountBeforeExpansion;
+    int mExpandedDicNodeCount;
+    bool mIsExpansionStopped;
+
+    AK_FORCE_INLINE void record(const uint8_t queueId, const DicNode *const dicNode) {
+        mRecordedDicNodes.push_back(*dicNode);
+        mRecordedQueueIds.push_back(queueId);
+    }
+};
+} // namespace latinime
+#endif // LATINIME_DIC_TRAVERSE_WORKER_H
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "suggest/core/session/worker_thread_pool.h"
+
+namespace latinime {
+
+WorkerThreadPool::WorkerThreadPool()
+        : mMutex(), mTaskStartedCondition(), mTaskDoneCondition(), mThreads(), mTask(0),
+          mTaskId(0), mRunningThreadCount(0), mIsStopping(false) {
+    pthread_mutex_init(&mMutex, 0);
+    pthread_cond_init(&mTaskStartedCondition, 0);
+    pthread_cond_init(&mTaskDoneCondition, 0);
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+    stopThreads();
+    pthread_cond_destroy(&mTaskDoneCondition);
+    pthread_cond_destroy(&mTaskStartedCondition);
+    pthread_mutex_destroy(&mMutex);
+}
+
+int WorkerThreadPool::setPartCount(const int partCount) {
+    stopThreads();
+    for (int partIndex = 1; partIndex < partCount; ++partIndex) {
+        WorkerThread *const workerThread = new WorkerThread(this, partIndex, mTaskId);
+        if (pthread_create(&workerThread->mThread, 0, runWorkerThread, workerThread) != 0) {
+            AKLOGE("Cannot start worker thread %d.", partIndex);
+            delete workerThread;
+            break;
+        }
+        mThreads.push_back(workerThread);
+    }
+    return getPartCount();
+}
+
+void WorkerThreadPool::run(Task *const task) {
+    if (mThreads.empty()) {
+        task->run(0);
+        return;
+    }
+    pthread_mutex_lock(&mMutex);
+    mTask = task;
+    ++mTaskId;
+    mRunningThreadCount = static_cast<int>(mThreads.size());
+    pthread_cond_broadcast(&mTaskStartedCondition);
+    pthread_mutex_unlock(&mMutex);
+
+    task->run(0);
+
+    pthread_mutex_lock(&mMutex);
+    while (mRunningThreadCount > 0) {
+        pthread_cond_wait(&mTaskDoneCondition, &mMutex);
+    }
+    mTask = 0;
+    pthread_mutex_unlock(&mMutex);
+}
+
+/* static */ void *WorkerThreadPool::runWorkerThread(void *workerThread) {
+    WorkerThread *const thread = static_cast<WorkerThread *>(workerThread);
+    WorkerThreadPool *const pool = thread->mPool;
+    pthread_mutex_lock(&pool->mMutex);
+    while (true) {
+        while (!pool->mIsStopping && pool->mTaskId == thread->mLastTaskId) {
+            pthread_cond_wait(&pool->mTaskStartedCondition, &pool->mMutex);
+        }
+        if (pool->mIsStopping) {
+            break;
+        }
+        thread->mLastTaskId = pool->mTaskId;
+        Task *const task = pool->mTask;
+        pthread_mutex_unlock(&pool->mMutex);
+
+        task->run(thread->mPartIndex);
+
+        pthread_mutex_lock(&pool->mMutex);
+        --pool->mRunningThreadCount;
+        if (pool->mRunningThreadCount == 0) {
+            pthread_cond_signal(&pool->mTaskDoneCondition);
+        }
+    }
+    pthread_mutex_unlock(&pool->mMutex);
+    return 0;
+}
+
+void WorkerThreadPool::stopThreads() {
+    if (mThreads.empty()) {
+        return;
+    }
+    pthread_mutex_lock(&mMutex);
+    mIsStopping = true;
+    pthread_cond_broadcast(&mTaskStartedCondition);
+    pthread_mutex_unlock(&mMutex);
+    for (size_t i = 0; i < mThreads.size(); ++i) {
+        pthread_join(mThreads[i]->mThread, 0);
+        delete mThreads[i];
+    }
+    mThreads.clear();
+    mIsStopping = false;
+}
+} // namespace latinime
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_WORKER_THREAD_POOL_H
+#define LATINIME_WORKER_THREAD_POOL_H
+
+#include <pthread.h>
+#include <vector>
+
+#include "defines.h"
+
+namespace latinime {
+
+/**
+ * Threads that run the parts of a task in parallel with the calling thread. They are started
+ * once and wait for the next task in between, as the tasks of a search are short.
+ */
+class WorkerThreadPool {
+ public:
+    class Task {
+     public:
+        virtual ~Task() {}
+        // Runs the part partIndex of the task.
+        virtual void run(const int partIndex) = 0;
+    };
+
+    WorkerThreadPool();
+    ~WorkerThreadPool();
+
+    // Makes each task run in partCount parts, one per thread. Returns the number of parts
+    // actually available, which is 1 if no thread can be started.
+    int setPartCount(const int partCount);
+    int getPartCount() const {
+        return static_cast<int>(mThreads.size()) + 1;
+    }
+
+    // Runs all the parts of task, the first one on the calling thread. Returns once they are
+    // all done.
+    void run(Task *const task);
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(WorkerThreadPool);
+
+    struct WorkerThread {
+        WorkerThread(WorkerThreadPool *const pool, const int partIndex, const int lastTaskId)
+                : mPool(pool), mPartIndex(partIndex), mLastTaskId(lastTaskId), mThread() {}
+
+        WorkerThreadPool *const mPool;
+        const int mPartIndex;
+        // The last task run by this thread
+        int mLastTaskId;
+        pthread_t mThread;
+
+     private:
+        DISALLOW_COPY_AND_ASSIGN(WorkerThread);
+    };
+
+    static void *runWorkerThread(void *workerThread);
+
+    void stopThreads();
+
+    pthread_mutex_t mMutex;
+    // Signaled when a task is started or the threads have to stop
+    pthread_cond_t mTaskStartedCondition;
+    // Signaled when the last part running on a thread is done
+    pthread_cond_t mTaskDoneCondition;
+    std::vector<WorkerThread *> mThreads;
+    Task *mTask;
+    // Incremented for each task, so that a thread runs each one once
+    int mTaskId;
+    int mRunningThreadCount;
+    bool mIsStopping;
+};
+} // namespace latinime
+#endif // LATINIME_WORKER_THREAD_POOL_H
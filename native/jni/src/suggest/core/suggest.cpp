@@ -21,6 +21,7 @@
 #include "digraph_utils.h"
 #include "proximity_info.h"
 #include "suggest/core/dicnode/dic_node.h"
+#include "suggest/core/dicnode/dic_node_child_iterator.h"
 #include "suggest/core/dicnode/dic_node_priority_queue.h"
 #include "suggest/core/dicnode/dic_node_vector.h"
 #include "suggest/core/dictionary/shortcut_utils.h"
@@ -28,19 +29,24 @@
 #include "suggest/core/policy/traversal.h"
 #include "suggest/core/policy/weighting.h"
 #include "suggest/core/session/dic_traverse_session.h"
+#include "suggest/core/session/dic_traverse_worker.h"
+#include "suggest/core/session/worker_thread_pool.h"
 #include "terminal_attributes.h"
 
 namespace latinime {
 
 // Initialization of class constants.
 const int Suggest::MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT = 16;
-const int Suggest::MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE = 2;
 const float Suggest::AUTOCORRECT_CLASSIFICATION_THRESHOLD = 0.33f;
+const float Suggest::FINAL_TERMINALS_DISTANCE_MARGIN = 0.0001f;
+const int Suggest::MIN_ACTIVE_SIZE_FOR_PARALLEL_EXPANSION = 32;
+const int Suggest::WORD_ARENA_REGION_SIZE_PER_ACTIVE_DIC_NODE = 256;
 
 /**
  * Returns a set of suggestions for the given input touch points. The commitPoint argument indicates
  * whether to prematurely commit the suggested words up to the given point for sentence-level
- * suggestion.
+ * suggestion. When the search limits of the session are reached, the best suggestions found so far
+ * are returned with the KIND_FLAG_PARTIAL_RESULT flag.
  *
  * Note: Currently does not support concurrent calls across threads. Continuous suggestion is
  * automatically activated for sequential calls that share the same starting input.
@@ -56,8 +62,9 @@ int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
 
     PROF_OPEN;
     PROF_START(0);
-    const float maxSpatialDistance = TRAVERSAL->getMaxSpatialDistance();
     DicTraverseSession *tSession = static_cast<DicTraverseSession *>(traverseSession);
+    tSession->startSearch();
+    const float maxSpatialDistance = TRAVERSAL->getMaxSpatialDistance();
     tSession->setupForGetSuggestions(pInfo, inputCodePoints, inputSize, inputXs, inputYs, times,
             pointerIds, maxSpatialDistance, TRAVERSAL->getMaxPointerCount());
     // TODO: Add the way to evaluate cache
@@ -68,13 +75,27 @@ int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
 
     // keep expanding search dicNodes until all have terminated.
     while (tSession->getDicTraverseCache()->activeSize() > 0) {
+        // The limits are checked between two input indices, where the cache is consistent.
+        if (tSession->isSearchLimitReached()) {
+            tSession->interruptSearch();
+            break;
+        }
         expandCurrentDicNodes(tSession);
         tSession->getDicTraverseCache()->advanceActiveDicNodes();
         tSession->getDicTraverseCache()->advanceInputIndex(inputSize);
+        if (hasFoundFinalTerminals(tSession)) {
+            break;
+        }
     }
     PROF_END(1);
     PROF_START(2);
     const int size = outputSuggestions(tSession, frequencies, outWords, outputIndices, outputTypes);
+    if (tSession->isSearchInterrupted()) {
+        // These are the best terminals found so far; better ones may have been missed.
+        for (int i = 0; i < size; ++i) {
+            outputTypes[i] |= Dictionary::KIND_FLAG_PARTIAL_RESULT;
+        }
+    }
     PROF_END(2);
     PROF_CLOSE;
     return size;
@@ -82,7 +103,8 @@ int Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
 
 /**
  * Initializes the search at the root of the lexicon trie. Note that when possible the search will
- * continue suggestion from where it left off during the last call.
+ * continue suggestion from the last checkpoint of the previous calls that the input still shares,
+ * whether characters were added to it or removed from it.
  */
 void Suggest::initializeSearch(DicTraverseSession *traverseSession, int commitPoint) const {
     if (!traverseSession->getProximityInfoState(0)->isUsed()) {
@@ -92,28 +114,64 @@ void Suggest::initializeSearch(DicTraverseSession *traverseSession, int commitPo
         commitPoint = 0;
     }
 
-    if (traverseSession->getInputSize() > MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE
-            && traverseSession->isContinuousSuggestionPossible()) {
-        if (commitPoint == 0) {
-            // Continue suggestion
-            traverseSession->getDicTraverseCache()->continueSearch();
-        } else {
+    DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
+    if (dicNodesCache->dropCheckpointsAfter(traverseSession->getLastContinuableInputIndex())) {
+        // Continue suggestion
+        dicNodesCache->continueSearch(traverseSession->getDicNodeWordArena());
+        if (commitPoint != 0) {
             // Continue suggestion after partial commit.
-            DicNode *topDicNode =
-                    traverseSession->getDicTraverseCache()->setCommitPoint(commitPoint);
-            traverseSession->setPrevWordPos(topDicNode->getPrevWordNodePos());
-            traverseSession->getDicTraverseCache()->continueSearch();
+            DicNode *topDicNode = dicNodesCache->setCommitPoint(commitPoint);
+            traverseSession->setPrevWordPos(topDicNode->getDictionaryIndex(),
+                    topDicNode->getPrevWordNodePos());
             traverseSession->setPartiallyCommited();
         }
     } else {
-        // Restart recognition at the root.
-        traverseSession->resetCache(TRAVERSAL->getMaxCacheSize(), MAX_RESULTS);
-        // Create a new dic node here
-        DicNode rootNode;
-        DicNodeUtils::initAsRoot(traverseSession->getDicRootPos(),
-                traverseSession->getOffsetDict(), traverseSession->getPrevWordPos(), &rootNode);
-        traverseSession->getDicTraverseCache()->copyPushActive(&rootNode);
+        // Restart recognition at the root. The dictionaries share the queues, so that each of
+        // them keeps about as many nodes as a search of its own, up to the queue capacity.
+        traverseSession->resetCache(
+                TRAVERSAL->getMaxCacheSize() * traverseSession->getDictionaryCount(),
+                MAX_RESULTS);
+        // Create a new dic node here for each dictionary, so that their words are searched in
+        // the same queues.
+        for (int i = 0; i < traverseSession->getDictionaryCount(); ++i) {
+            DicNode rootNode;
+            DicNodeUtils::initAsRoot(traverseSession->getDicRootPos(),
+                    traverseSession->getOffsetDict(i), traverseSession->getPrevWordPos(i),
+                    traverseSession->getMultiBigramMap()->getMaxBigramProbability(
+                            traverseSession->getOffsetDict(i),
+                            traverseSession->supportsDynamicUpdate(i), i,
+                            traverseSession->getPrevWordPos(i)),
+                    i, traverseSession->getDicNodeWordArena(), &rootNode);
+            traverseSession->getDicTraverseCache()->copyPushActive(&rootNode);
+        }
+    }
+}
+
+/**
+ * Returns whether the kept terminals are the final ones: there are as many as can be kept, and no
+ * active dic node can lead to a terminal better than the worst of them, its distance growing by at
+ * least the lower bound of the weighting. The search can then stop without changing its results.
+ * Terminals come after the continuous suggestion cache border, so the cache is complete by then.
+ */
+bool Suggest::hasFoundFinalTerminals(DicTraverseSession *traverseSession) const {
+    const DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
+    const DicNode *const worstTerminal = dicNodesCache->peekWorstKeptTerminal();
+    if (!worstTerminal) {
+        return false;
     }
+    const float maxDistance =
+            worstTerminal->getNormalizedCompoundDistance() + FINAL_TERMINALS_DISTANCE_MARGIN;
+    const int activeSize = dicNodesCache->activeSize();
+    for (int i = 0; i < activeSize; ++i) {
+        const DicNode *const dicNode = dicNodesCache->getActiveDicNodeAt(i);
+        const float remainingDistanceLowerBound =
+                Weighting::getRemainingDistanceLowerBound(WEIGHTING, traverseSession, dicNode);
+        if (remainingDistanceLowerBound < 0.0f || dicNode->getNormalizedCompoundDistance()
+                + remainingDistanceLowerBound <= maxDistance) {
+            return false;
+        }
+    }
+    return true;
 }
 
 /**
@@ -142,6 +200,7 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
             SCORING->getMostProbableString(traverseSession, terminalSize, languageWeight,
                     &outputCodePoints[0], &outputTypes[0], &frequencies[0]);
     if (hasMostProbableString) {
+        traverseSession->setOutputDictionaryIndex(outputWordIndex, 0 /* dictionaryIndex */);
         ++outputWordIndex;
     }
 
@@ -163,7 +222,8 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
                 terminalIndex, doubleLetterTerminalIndex, doubleLetterLevel);
         const float compoundDistance = terminalDicNode->getCompoundDistance(languageWeight)
                 + doubleLetterCost;
-        const TerminalAttributes terminalAttributes(traverseSession->getOffsetDict(),
+        const int dictionaryIndex = terminalDicNode->getDictionaryIndex();
+        const TerminalAttributes terminalAttributes(traverseSession->getOffsetDict(dictionaryIndex),
                 terminalDicNode->getFlags(), terminalDicNode->getAttributesPos());
         const bool isPossiblyOffensiveWord = terminalDicNode->getProbability() <= 0;
         const bool isExactMatch = terminalDicNode->isExactMatch();
@@ -207,12 +267,17 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
             // Populate the outputChars array with the suggested word.
             const int startIndex = outputWordIndex * MAX_WORD_LENGTH;
             terminalDicNode->outputResult(&outputCodePoints[startIndex]);
+            traverseSession->setOutputDictionaryIndex(outputWordIndex, dictionaryIndex);
             ++outputWordIndex;
         }
 
         const bool sameAsTyped = TRAVERSAL->sameAsTyped(traverseSession, terminalDicNode);
+        const int shortcutStartIndex = outputWordIndex;
         outputWordIndex = ShortcutUtils::outputShortcuts(&terminalAttributes, outputWordIndex,
                 finalScore, outputCodePoints, frequencies, outputTypes, sameAsTyped);
+        for (int i = shortcutStartIndex; i < outputWordIndex; ++i) {
+            traverseSession->setOutputDictionaryIndex(i, dictionaryIndex);
+        }
         DicNode::managedDelete(terminalDicNode);
     }
 
@@ -223,133 +288,248 @@ int Suggest::outputSuggestions(DicTraverseSession *traverseSession, int *frequen
     return outputWordIndex;
 }
 
+/**
+ * Expands the active dic nodes of one slice of a parallel expansion.
+ */
+class Suggest::ParallelExpansionTask : public WorkerThreadPool::Task {
+ public:
+    ParallelExpansionTask(const Suggest *const suggest, DicTraverseSession *const traverseSession,
+            const int sliceCount, const int regionsStart, const int regionSize)
+            : mSuggest(suggest), mTraverseSession(traverseSession), mSliceCount(sliceCount),
+              mRegionsStart(regionsStart), mRegionSize(regionSize) {}
+
+    // The slices are contiguous, so that merging them in order gives the serial order.
+    static int getSliceBegin(const int activeSize, const int sliceIndex, const int sliceCount) {
+        return activeSize * sliceIndex / sliceCount;
+    }
+
+    void run(const int sliceIndex) {
+        std::vector<DicNode> *const activeDicNodes = mTraverseSession->getParallelActiveDicNodes();
+        const int activeSize = static_cast<int>(activeDicNodes->size());
+        const int end = getSliceBegin(activeSize, sliceIndex + 1, mSliceCount);
+        DicTraverseWorker *const worker = mTraverseSession->getParallelWorker(sliceIndex);
+        worker->startParallelExpansion(mTraverseSession->getDicNodeWordArena(),
+                mRegionsStart + sliceIndex * mRegionSize, mRegionSize);
+        DicNode childDicNode;
+        DicNode correctionDicNode;
+        for (int i = getSliceBegin(activeSize, sliceIndex, mSliceCount); i < end; ++i) {
+            DicNode *const dicNode = &(*activeDicNodes)[i];
+            worker->startExpansion(dicNode);
+            const bool shouldContinue = mSuggest->expandDicNode(mTraverseSession, worker,
+                    dicNode, &childDicNode, &correctionDicNode);
+            if (worker->hasWordArenaOverflowed()) {
+                // The rest of the slice is expanded serially after the merge.
+                worker->cancelExpansion(dicNode);
+                return;
+            }
+            if (!shouldContinue) {
+                worker->stopExpansion();
+                return;
+            }
+        }
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(ParallelExpansionTask);
+
+    const Suggest *const mSuggest;
+    DicTraverseSession *const mTraverseSession;
+    const int mSliceCount;
+    const int mRegionsStart;
+    const int mRegionSize;
+};
+
 /**
  * Expands the dicNodes in the current search priority queue by advancing to the possible child
  * nodes based on the next touch point(s) (or no touch points for lookahead)
  */
 void Suggest::expandCurrentDicNodes(DicTraverseSession *traverseSession) const {
-    const int inputSize = traverseSession->getInputSize();
-    DicNodeVector childDicNodes(TRAVERSAL->getDefaultExpandDicNodeSize());
-    DicNode correctionDicNode;
-
-    // TODO: Find more efficient caching
-    const bool shouldDepthLevelCache = TRAVERSAL->shouldDepthLevelCache(traverseSession);
-    if (shouldDepthLevelCache) {
-        traverseSession->getDicTraverseCache()->updateLastCachedInputIndex();
-    }
+    DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
+    const bool shouldSaveCheckpoint = TRAVERSAL->shouldSaveCheckpoint(traverseSession);
     if (DEBUG_CACHE) {
-        AKLOGI("expandCurrentDicNodes depth level cache = %d, inputSize = %d",
-                shouldDepthLevelCache, inputSize);
+        AKLOGI("expandCurrentDicNodes checkpoint = %d, inputSize = %d",
+                shouldSaveCheckpoint, traverseSession->getInputSize());
     }
-    while (traverseSession->getDicTraverseCache()->activeSize() > 0) {
-        DicNode dicNode;
-        traverseSession->getDicTraverseCache()->popActive(&dicNode);
-        if (dicNode.isTotalInputSizeExceedingLimit()) {
-            return;
+    if (shouldSaveCheckpoint) {
+        dicNodesCache->saveCheckpoint();
+    }
+    const int sliceCount = traverseSession->getExpansionThreadCount();
+    DicNode childDicNode;
+    DicNode correctionDicNode;
+    if (sliceCount > 1 && dicNodesCache->activeSize() >= MIN_ACTIVE_SIZE_FOR_PARALLEL_EXPANSION) {
+        // Expand the active dic nodes in the order they are popped, one contiguous slice per
+        // thread, and push what they output in that order too.
+        std::vector<DicNode> *const activeDicNodes = traverseSession->getParallelActiveDicNodes();
+        const int activeSize = dicNodesCache->activeSize();
+        activeDicNodes->resize(activeSize);
+        for (int i = 0; i < activeSize; ++i) {
+            dicNodesCache->popActive(&(*activeDicNodes)[i]);
         }
-        childDicNodes.clear();
-        const int point0Index = dicNode.getInputIndex(0);
-        const bool canDoLookAheadCorrection =
-                TRAVERSAL->canDoLookAheadCorrection(traverseSession, &dicNode);
-        const bool isLookAheadCorrection = canDoLookAheadCorrection
-                && traverseSession->getDicTraverseCache()->
-                        isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
-        const bool isCompletion = dicNode.isCompletion(inputSize);
-
-        const bool shouldNodeLevelCache =
-                TRAVERSAL->shouldNodeLevelCache(traverseSession, &dicNode);
-        if (shouldDepthLevelCache || shouldNodeLevelCache) {
-            if (DEBUG_CACHE) {
-                dicNode.dump("PUSH_CACHE");
+        const int regionSize =
+                (activeSize / sliceCount + 1) * WORD_ARENA_REGION_SIZE_PER_ACTIVE_DIC_NODE;
+        const int regionsStart =
+                traverseSession->getDicNodeWordArena()->reserveRegions(sliceCount, regionSize);
+        ParallelExpansionTask task(this, traverseSession, sliceCount, regionsStart, regionSize);
+        traverseSession->getWorkerThreadPool()->run(&task);
+        // The following slices would not have been expanded by the serial search.
+        int mergedSliceCount = sliceCount;
+        for (int i = 0; i < sliceCount; ++i) {
+            if (traverseSession->getParallelWorker(i)->isExpansionStopped()) {
+                mergedSliceCount = i + 1;
+                break;
             }
-            traverseSession->getDicTraverseCache()->copyPushContinue(&dicNode);
-            dicNode.setCached();
         }
-
-        if (dicNode.isInDigraph()) {
-            // Finish digraph handling if the node is in the middle of a digraph expansion.
-            processDicNodeAsDigraph(traverseSession, &dicNode);
-        } else if (isLookAheadCorrection) {
-            // The algorithm maintains a small set of "deferred" nodes that have not consumed the
-            // latest touch point yet. These are needed to apply look-ahead correction operations
-            // that require special handling of the latest touch point. For example, with insertions
-            // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
-            processDicNodeAsTransposition(traverseSession, &dicNode);
-            processDicNodeAsInsertion(traverseSession, &dicNode);
-        } else { // !isLookAheadCorrection
-            // Only consider typing error corrections if the normalized compound distance is
-            // below a spatial distance threshold.
-            // NOTE: the threshold may need to be updated if scoring model changes.
-            // TODO: Remove. Do not prune node here.
-            const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(&dicNode);
-            // Process for handling space substitution (e.g., hevis => he is)
-            if (allowsErrorCorrections
-                    && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, &dicNode)) {
-                createNextWordDicNode(traverseSession, &dicNode, true /* spaceSubstitution */);
+        for (int i = 0; i < mergedSliceCount; ++i) {
+            traverseSession->getParallelWorker(i)->mergeWordArena();
+        }
+        for (int i = 0; i < mergedSliceCount; ++i) {
+            DicTraverseWorker *const worker = traverseSession->getParallelWorker(i);
+            worker->mergeInto(dicNodesCache);
+            traverseSession->countExpandedDicNodes(worker->getExpandedDicNodeCount());
+            if (worker->isExpansionStopped()) {
+                return;
             }
-
-            DicNodeUtils::getAllChildDicNodes(
-                    &dicNode, traverseSession->getOffsetDict(), &childDicNodes);
-
-            const int childDicNodesSize = childDicNodes.getSizeAndLock();
-            for (int i = 0; i < childDicNodesSize; ++i) {
-                DicNode *const childDicNode = childDicNodes[i];
-                if (isCompletion) {
-                    // Handle forward lookahead when the lexicon letter exceeds the input size.
-                    processDicNodeAsMatch(traverseSession, childDicNode);
-                    continue;
-                }
-                if (DigraphUtils::hasDigraphForCodePoint(traverseSession->getDictFlags(),
-                        childDicNode->getNodeCodePoint())) {
-                    correctionDicNode.initByCopy(childDicNode);
-                    correctionDicNode.advanceDigraphIndex();
-                    processDicNodeAsDigraph(traverseSession, &correctionDicNode);
-                }
-                if (TRAVERSAL->isOmission(traverseSession, &dicNode, childDicNode,
-                        allowsErrorCorrections)) {
-                    // TODO: (Gesture) Change weight between omission and substitution errors
-                    // TODO: (Gesture) Terminal node should not be handled as omission
-                    correctionDicNode.initByCopy(childDicNode);
-                    processDicNodeAsOmission(traverseSession, &correctionDicNode);
-                }
-                const ProximityType proximityType = TRAVERSAL->getProximityType(
-                        traverseSession, &dicNode, childDicNode);
-                switch (proximityType) {
-                    // TODO: Consider the difference of proximityType here
-                    case MATCH_CHAR:
-                    case PROXIMITY_CHAR:
-                        processDicNodeAsMatch(traverseSession, childDicNode);
-                        break;
-                    case ADDITIONAL_PROXIMITY_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsAdditionalProximityChar(traverseSession, &dicNode,
-                                    childDicNode);
-                        }
-                        break;
-                    case SUBSTITUTION_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsSubstitution(traverseSession, &dicNode, childDicNode);
-                        }
-                        break;
-                    case UNRELATED_CHAR:
-                        // Just drop this node and do nothing.
-                        break;
-                    default:
-                        // Just drop this node and do nothing.
-                        break;
+            // The dic nodes left when the word arena region of the slice was full
+            const int end = ParallelExpansionTask::getSliceBegin(activeSize, i + 1, sliceCount);
+            for (int j = ParallelExpansionTask::getSliceBegin(activeSize, i, sliceCount)
+                    + worker->getExpandedDicNodeCount(); j < end; ++j) {
+                traverseSession->countExpandedDicNodes(1);
+                if (!expandDicNode(traverseSession, traverseSession->getSerialWorker(),
+                        &(*activeDicNodes)[j], &childDicNode, &correctionDicNode)) {
+                    return;
                 }
             }
+        }
+        return;
+    }
+    while (dicNodesCache->activeSize() > 0) {
+        DicNode dicNode;
+        dicNodesCache->popActive(&dicNode);
+        traverseSession->countExpandedDicNodes(1);
+        if (!expandDicNode(traverseSession, traverseSession->getSerialWorker(), &dicNode,
+                &childDicNode, &correctionDicNode)) {
+            return;
+        }
+    }
+}
 
-            // Push the node for look-ahead correction
-            if (allowsErrorCorrections && canDoLookAheadCorrection) {
-                traverseSession->getDicTraverseCache()->copyPushNextActive(&dicNode);
+/**
+ * Expands dicNode, an active dic node, and pushes the resulting dic nodes to worker. childDicNode
+ * and correctionDicNode are reused for the children. Returns false if the expansion of the active
+ * dic nodes has to stop at this one.
+ */
+bool Suggest::expandDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+        DicNode *dicNode, DicNode *childDicNode, DicNode *correctionDicNode) const {
+    const int inputSize = traverseSession->getInputSize();
+    if (dicNode->isTotalInputSizeExceedingLimit()) {
+        return false;
+    }
+    const int point0Index = dicNode->getInputIndex(0);
+    const bool canDoLookAheadCorrection =
+            TRAVERSAL->canDoLookAheadCorrection(traverseSession, dicNode);
+    const bool isLookAheadCorrection = canDoLookAheadCorrection
+            && traverseSession->getDicTraverseCache()->
+                    isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
+    const bool isCompletion = dicNode->isCompletion(inputSize);
+
+    if (dicNode->isInDigraph()) {
+        // Finish digraph handling if the node is in the middle of a digraph expansion.
+        processDicNodeAsDigraph(traverseSession, worker, dicNode);
+    } else if (isLookAheadCorrection) {
+        // The algorithm maintains a small set of "deferred" nodes that have not consumed the
+        // latest touch point yet. These are needed to apply look-ahead correction operations
+        // that require special handling of the latest touch point. For example, with insertions
+        // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
+        processDicNodeAsTransposition(traverseSession, worker, dicNode);
+        processDicNodeAsInsertion(traverseSession, worker, dicNode);
+    } else { // !isLookAheadCorrection
+        // Only consider typing error corrections if the normalized compound distance is
+        // below a spatial distance threshold.
+        // NOTE: the threshold may need to be updated if scoring model changes.
+        // TODO: Remove. Do not prune node here.
+        const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(dicNode);
+        // Process for handling space substitution (e.g., hevis => he is)
+        if (allowsErrorCorrections
+                && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, dicNode)) {
+            createNextWordDicNode(traverseSession, worker, dicNode, true /* spaceSubstitution */);
+        }
+
+        // Children are filtered on their code point, and only the ones that are kept are
+        // built as full nodes.
+        const int dictionaryIndex = dicNode->getDictionaryIndex();
+        DicNodeChildIterator childIterator(dicNode, traverseSession->getOffsetDict(dictionaryIndex),
+                traverseSession->supportsDynamicUpdate(dictionaryIndex),
+                traverseSession->getHeaderSize(dictionaryIndex));
+        while (childIterator.next()) {
+            const int childCodePoint = childIterator.getNodeCodePoint();
+            if (isCompletion) {
+                // Handle forward lookahead when the lexicon letter exceeds the input size.
+                childIterator.initChildDicNode(dicNode, childDicNode);
+                processDicNodeAsMatch(traverseSession, worker, childDicNode);
+                continue;
+            }
+            const bool hasDigraph = DigraphUtils::hasDigraphForCodePoint(
+                    traverseSession->getDictFlags(dictionaryIndex), childCodePoint);
+            const bool isOmission = TRAVERSAL->isOmission(traverseSession, dicNode,
+                    childCodePoint, allowsErrorCorrections);
+            const ProximityType proximityType = TRAVERSAL->getProximityType(
+                    traverseSession, dicNode, childCodePoint);
+            const bool isExpanded = proximityType == MATCH_CHAR
+                    || proximityType == PROXIMITY_CHAR
+                    || (allowsErrorCorrections && (proximityType == ADDITIONAL_PROXIMITY_CHAR
+                            || proximityType == SUBSTITUTION_CHAR));
+            if (!hasDigraph && !isOmission && !isExpanded) {
+                continue;
+            }
+            childIterator.initChildDicNode(dicNode, childDicNode);
+            if (hasDigraph) {
+                correctionDicNode->initByCopy(childDicNode);
+                correctionDicNode->advanceDigraphIndex();
+                processDicNodeAsDigraph(traverseSession, worker, correctionDicNode);
+            }
+            if (isOmission) {
+                // TODO: (Gesture) Change weight between omission and substitution errors
+                // TODO: (Gesture) Terminal node should not be handled as omission
+                correctionDicNode->initByCopy(childDicNode);
+                processDicNodeAsOmission(traverseSession, worker, correctionDicNode);
             }
+            switch (proximityType) {
+                // TODO: Consider the difference of proximityType here
+                case MATCH_CHAR:
+                case PROXIMITY_CHAR:
+                    processDicNodeAsMatch(traverseSession, worker, childDicNode);
+                    break;
+                case ADDITIONAL_PROXIMITY_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsAdditionalProximityChar(traverseSession, worker, dicNode,
+                                childDicNode);
+                    }
+                    break;
+                case SUBSTITUTION_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsSubstitution(traverseSession, worker, dicNode,
+                                childDicNode);
+                    }
+                    break;
+                case UNRELATED_CHAR:
+                    // Just drop this node and do nothing.
+                    break;
+                default:
+                    // Just drop this node and do nothing.
+                    break;
+            }
+        }
+
+        // Push the node for look-ahead correction
+        if (allowsErrorCorrections && canDoLookAheadCorrection) {
+            worker->copyPushNextActive(dicNode);
         }
     }
+    return true;
 }
 
 void Suggest::processTerminalDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
+        DicTraverseSession *traverseSession, DicTraverseWorker *worker, DicNode *dicNode) const {
     if (dicNode->getCompoundDistance() >= static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         return;
     }
@@ -368,8 +548,8 @@ void Suggest::processTerminalDicNode(
     DicNode terminalDicNode;
     DicNodeUtils::initByCopy(dicNode, &terminalDicNode);
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TERMINAL, traverseSession, 0,
-            &terminalDicNode, traverseSession->getMultiBigramMap());
-    traverseSession->getDicTraverseCache()->copyPushTerminal(&terminalDicNode);
+            &terminalDicNode, worker->getMultiBigramMap());
+    worker->copyPushTerminal(&terminalDicNode);
 }
 
 /**
@@ -377,53 +557,53 @@ void Suggest::processTerminalDicNode(
  * (by the space omission error correction) search path if input dicNode is on a terminal node.
  */
 void Suggest::processExpandedDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
-    processTerminalDicNode(traverseSession, dicNode);
+        DicTraverseSession *traverseSession, DicTraverseWorker *worker, DicNode *dicNode) const {
+    processTerminalDicNode(traverseSession, worker, dicNode);
     if (dicNode->getCompoundDistance() < static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         if (TRAVERSAL->isSpaceOmissionTerminal(traverseSession, dicNode)) {
-            createNextWordDicNode(traverseSession, dicNode, false /* spaceSubstitution */);
+            createNextWordDicNode(traverseSession, worker, dicNode, false /* spaceSubstitution */);
         }
         const int allowsLookAhead = !(dicNode->hasMultipleWords()
                 && dicNode->isCompletion(traverseSession->getInputSize()));
         if (dicNode->hasChildren() && allowsLookAhead) {
-            traverseSession->getDicTraverseCache()->copyPushNextActive(dicNode);
+            worker->copyPushNextActive(dicNode);
         }
     }
     DicNode::managedDelete(dicNode);
 }
 
 void Suggest::processDicNodeAsMatch(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 void Suggest::processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const {
     // Note: Most types of corrections don't need to look up the bigram information since they do
     // not treat the node as a terminal. There is no need to pass the bigram map in these cases.
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_ADDITIONAL_PROXIMITY,
             traverseSession, dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 void Suggest::processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const {
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_SUBSTITUTION, traverseSession,
             dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 // Process the node codepoint as a digraph. This means that composite glyphs like the German
 // u-umlaut is expanded to the transliteration "ue". Note that this happens in parallel with
 // the normal non-digraph traversal, so both "uber" and "ueber" can be corrected to "[u-umlaut]ber".
 void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+        DicTraverseWorker *worker, DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
     childDicNode->advanceDigraphIndex();
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, worker, childDicNode);
 }
 
 /**
@@ -434,9 +614,12 @@ void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
  * Note that apostrophes are handled as omissions.
  */
 void Suggest::processDicNodeAsOmission(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
+        DicTraverseSession *traverseSession, DicTraverseWorker *worker, DicNode *dicNode) const {
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
     DicNodeVector childDicNodes;
-    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getOffsetDict(), &childDicNodes);
+    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getOffsetDict(dictionaryIndex),
+            traverseSession->supportsDynamicUpdate(dictionaryIndex),
+            traverseSession->getHeaderSize(dictionaryIndex), &childDicNodes);
 
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
@@ -449,7 +632,7 @@ void Suggest::processDicNodeAsOmission(
         if (!TRAVERSAL->isPossibleOmissionChildNode(traverseSession, dicNode, childDicNode)) {
             continue;
         }
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, worker, childDicNode);
     }
 }
 
@@ -458,17 +641,21 @@ void Suggest::processDicNodeAsOmission(
  * consider matches for the next touch point.
  */
 void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
     DicNodeVector childDicNodes;
-    DicNodeUtils::getProximityChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+    DicNodeUtils::getProximityChildDicNodes(dicNode,
+            traverseSession->getOffsetDict(dictionaryIndex),
+            traverseSession->supportsDynamicUpdate(dictionaryIndex),
+            traverseSession->getHeaderSize(dictionaryIndex),
             traverseSession->getProximityInfoState(0), pointIndex + 1, true, &childDicNodes);
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
         DicNode *const childDicNode = childDicNodes[i];
         Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_INSERTION, traverseSession,
                 dicNode, childDicNode, 0 /* multiBigramMap */);
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, worker, childDicNode);
     }
 }
 
@@ -476,24 +663,28 @@ void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
  * Handle the dicNode as a transposition error (e.g., thsi => this). Swap the next two touch points.
  */
 void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+        DicTraverseWorker *worker, DicNode *dicNode) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
+    const uint8_t *const dicRoot = traverseSession->getOffsetDict(dictionaryIndex);
+    const bool supportsDynamicUpdate = traverseSession->supportsDynamicUpdate(dictionaryIndex);
+    const int headerSize = traverseSession->getHeaderSize(dictionaryIndex);
     DicNodeVector childDicNodes1;
-    DicNodeUtils::getProximityChildDicNodes(dicNode, traverseSession->getOffsetDict(),
+    DicNodeUtils::getProximityChildDicNodes(dicNode, dicRoot, supportsDynamicUpdate, headerSize,
             traverseSession->getProximityInfoState(0), pointIndex + 1, false, &childDicNodes1);
     const int childSize1 = childDicNodes1.getSizeAndLock();
     for (int i = 0; i < childSize1; i++) {
         if (childDicNodes1[i]->hasChildren()) {
             DicNodeVector childDicNodes2;
-            DicNodeUtils::getProximityChildDicNodes(
-                    childDicNodes1[i], traverseSession->getOffsetDict(),
-                    traverseSession->getProximityInfoState(0), pointIndex, false, &childDicNodes2);
+            DicNodeUtils::getProximityChildDicNodes(childDicNodes1[i], dicRoot,
+                    supportsDynamicUpdate, headerSize, traverseSession->getProximityInfoState(0),
+                    pointIndex, false, &childDicNodes2);
             const int childSize2 = childDicNodes2.getSizeAndLock();
             for (int j = 0; j < childSize2; j++) {
                 DicNode *const childDicNode2 = childDicNodes2[j];
                 Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TRANSPOSITION,
                         traverseSession, childDicNodes1[i], childDicNode2, 0 /* multiBigramMap */);
-                processExpandedDicNode(traverseSession, childDicNode2);
+                processExpandedDicNode(traverseSession, worker, childDicNode2);
             }
         }
         DicNode::managedDelete(childDicNodes1[i]);
@@ -518,20 +709,26 @@ void Suggest::weightChildNode(DicTraverseSession *traverseSession, DicNode *dicN
  * Creates a new dicNode that represents a space insertion at the end of the input dicNode. Also
  * incorporates the unigram / bigram score for the ending word into the new dicNode.
  */
-void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-        const bool spaceSubstitution) const {
+void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession,
+        DicTraverseWorker *worker, DicNode *dicNode, const bool spaceSubstitution) const {
     if (!TRAVERSAL->isGoodToTraverseNextWord(dicNode)) {
         return;
     }
 
     // Create a non-cached node here.
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
     DicNode newDicNode;
     DicNodeUtils::initAsRootWithPreviousWord(traverseSession->getDicRootPos(),
-            traverseSession->getOffsetDict(), dicNode, &newDicNode);
+            traverseSession->getOffsetDict(dictionaryIndex), dicNode,
+            worker->getMultiBigramMap()->getMaxBigramProbability(
+                    traverseSession->getOffsetDict(dictionaryIndex),
+                    traverseSession->supportsDynamicUpdate(dictionaryIndex), dictionaryIndex,
+                    dicNode->getPos()),
+            &newDicNode);
     const CorrectionType correctionType = spaceSubstitution ?
             CT_NEW_WORD_SPACE_SUBSTITUTION : CT_NEW_WORD_SPACE_OMITTION;
     Weighting::addCostAndForwardInputIndex(WEIGHTING, correctionType, traverseSession, dicNode,
-            &newDicNode, traverseSession->getMultiBigramMap());
-    traverseSession->getDicTraverseCache()->copyPushNextActive(&newDicNode);
+            &newDicNode, worker->getMultiBigramMap());
+    worker->copyPushNextActive(&newDicNode);
 }
 } // namespace latinime
@@ -34,6 +34,7 @@ namespace latinime {
 
 class DicNode;
 class DicTraverseSession;
+class DicTraverseWorker;
 class ProximityInfo;
 class Scoring;
 class Traversal;
@@ -52,33 +53,51 @@ class Suggest : public SuggestInterface {
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(Suggest);
-    void createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-            const bool spaceSubstitution) const;
+    class ParallelExpansionTask;
+
+    void createNextWordDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode, const bool spaceSubstitution) const;
     int outputSuggestions(DicTraverseSession *traverseSession, int *frequencies,
             int *outputCodePoints, int *outputIndices, int *outputTypes) const;
     void initializeSearch(DicTraverseSession *traverseSession, int commitPoint) const;
     void expandCurrentDicNodes(DicTraverseSession *traverseSession) const;
-    void processTerminalDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processExpandedDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    bool hasFoundFinalTerminals(DicTraverseSession *traverseSession) const;
+    bool expandDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode, DicNode *childDicNode, DicNode *correctionDicNode) const;
+    void processTerminalDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
+    void processExpandedDicNode(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
     void weightChildNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
     float getAutocorrectScore(DicTraverseSession *traverseSession, DicNode *dicNode) const;
     void generateFeatures(
             DicTraverseSession *traverseSession, DicNode *dicNode, float *features) const;
-    void processDicNodeAsOmission(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    void processDicNodeAsOmission(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
+    void processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
+            DicNode *dicNode) const;
     void processDicNodeAsTransposition(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode) const;
+    void processDicNodeAsInsertion(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
             DicNode *dicNode) const;
-    void processDicNodeAsInsertion(DicTraverseSession *traverseSession, DicNode *dicNode) const;
     void processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-            DicNode *dicNode, DicNode *childDicNode) const;
-    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession, DicNode *dicNode,
-            DicNode *childDicNode) const;
-    void processDicNodeAsMatch(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const;
+    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
+            DicTraverseWorker *worker, DicNode *dicNode, DicNode *childDicNode) const;
+    void processDicNodeAsMatch(DicTraverseSession *traverseSession, DicTraverseWorker *worker,
             DicNode *childDicNode) const;
 
     // Inputs longer than this will autocorrect if the suggestion is multi-word
     static const int MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT;
-    static const int MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE;
+    // The active dic nodes are expanded in parallel, if enabled, from this many on only, as
+    // waking up the threads costs more than expanding a few dic nodes.
+    static const int MIN_ACTIVE_SIZE_FOR_PARALLEL_EXPANSION;
+    // Size of the word arena region of a parallel expansion, per active dic node of a slice
+    static const int WORD_ARENA_REGION_SIZE_PER_ACTIVE_DIC_NODE;
+
+    // Margin over the distance of the worst kept terminal for an active dic node to be unable to
+    // beat it, above DicNode::compare()'s tolerance and the rounding of the distances.
+    static const float FINAL_TERMINALS_DISTANCE_MARGIN;
 
     // Threshold for autocorrection classifier
     static const float AUTOCORRECT_CLASSIFICATION_THRESHOLD;
@@ -23,6 +23,7 @@
 #include "defines.h"
 #include "proximity_info_state.h"
 #include "suggest/core/dicnode/dic_node.h"
+#include "suggest/core/dicnode/dic_node_utils.h"
 #include "suggest/core/dicnode/dic_node_vector.h"
 #include "suggest/core/policy/traversal.h"
 #include "suggest/core/session/dic_traverse_session.h"
@@ -43,14 +44,14 @@ class TypingTraversal : public Traversal {
     }
 
     AK_FORCE_INLINE bool isOmission(const DicTraverseSession *const traverseSession,
-            const DicNode *const dicNode, const DicNode *const childDicNode,
+            const DicNode *const dicNode, const int childCodePoint,
             const bool allowsErrorCorrections) const {
         if (!CORRECT_OMISSION) {
             return false;
         }
         // Note: Always consider intentional omissions (like apostrophes) since they are common.
         const bool canConsiderOmission =
-                allowsErrorCorrections || childDicNode->canBeIntentionalOmission();
+                allowsErrorCorrections || isIntentionalOmissionCodePoint(childCodePoint);
         if (!canConsiderOmission) {
             return false;
         }
@@ -63,8 +64,7 @@ class TypingTraversal : public Traversal {
             return true;
         }
         const int point0Index = dicNode->getInputIndex(0);
-        const int currentBaseLowerCodePoint =
-                toBaseLowerCase(childDicNode->getNodeCodePoint());
+        const int currentBaseLowerCodePoint = toBaseLowerCase(childCodePoint);
         const int typedBaseLowerCodePoint =
                 toBaseLowerCase(traverseSession->getProximityInfoState(0)
                         ->getPrimaryCodePointAt(point0Index));
@@ -103,15 +103,10 @@ class TypingTraversal : public Traversal {
                 && !dicNode->shouldBeFilterdBySafetyNetForBigram();
     }
 
-    AK_FORCE_INLINE bool shouldDepthLevelCache(
+    AK_FORCE_INLINE bool shouldSaveCheckpoint(
             const DicTraverseSession *const traverseSession) const {
         const int inputSize = traverseSession->getInputSize();
-        return traverseSession->isCacheBorderForTyping(inputSize);
-    }
-
-    AK_FORCE_INLINE bool shouldNodeLevelCache(
-            const DicTraverseSession *const traverseSession, const DicNode *const dicNode) const {
-        return false;
+        return traverseSession->isCheckpointInputIndexForTyping(inputSize);
     }
 
     AK_FORCE_INLINE bool canDoLookAheadCorrection(
@@ -122,9 +117,9 @@ class TypingTraversal : public Traversal {
 
     AK_FORCE_INLINE ProximityType getProximityType(
             const DicTraverseSession *const traverseSession, const DicNode *const dicNode,
-            const DicNode *const childDicNode) const {
+            const int childCodePoint) const {
         return traverseSession->getProximityInfoState(0)->getProximityType(
-                dicNode->getInputIndex(0), childDicNode->getNodeCodePoint(),
+                dicNode->getInputIndex(0), childCodePoint,
                 true /* checkProximityChars */);
     }
 
@@ -146,8 +141,9 @@ class TypingTraversal : public Traversal {
 
     AK_FORCE_INLINE bool sameAsTyped(
             const DicTraverseSession *const traverseSession, const DicNode *const dicNode) const {
-        return traverseSession->getProximityInfoState(0)->sameAsTyped(
-                dicNode->getOutputWordBuf(), dicNode->getDepth());
+        int word[MAX_WORD_LENGTH];
+        dicNode->outputCurrentWord(word);
+        return traverseSession->getProximityInfoState(0)->sameAsTyped(word, dicNode->getDepth());
     }
 
     AK_FORCE_INLINE int getMaxCacheSize() const {
@@ -158,7 +154,7 @@ class TypingTraversal : public Traversal {
             const DicTraverseSession *const traverseSession, const DicNode *const parentDicNode,
             const DicNode *const dicNode) const {
         const ProximityType proximityType =
-                getProximityType(traverseSession, parentDicNode, dicNode);
+                getProximityType(traverseSession, parentDicNode, dicNode->getNodeCodePoint());
         if (!DicNodeUtils::isProximityChar(proximityType)) {
             return false;
         }
@@ -170,7 +166,7 @@ class TypingTraversal : public Traversal {
         if (probability < ScoringParams::THRESHOLD_NEXT_WORD_PROBABILITY) {
             return false;
         }
-        const int c = dicNode->getOutputWordBuf()[0];
+        const int c = dicNode->getFirstCodePoint();
         const bool shortCappedWord = dicNode->getDepth()
                 < ScoringParams::THRESHOLD_SHORT_WORD_LENGTH && isAsciiUpper(c);
         return !shortCappedWord
@@ -20,6 +20,7 @@
 #include "defines.h"
 #include "suggest_utils.h"
 #include "suggest/core/dicnode/dic_node_utils.h"
+#include "suggest/core/dictionary/subtree_probability_index.h"
 #include "suggest/core/policy/weighting.h"
 #include "suggest/core/session/dic_traverse_session.h"
 #include "suggest/policyimpl/typing/scoring_params.h"
@@ -139,14 +140,18 @@ class TypingWeighting : public Weighting {
 
     float getNewWordCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const {
-        return ScoringParams::COST_NEW_WORD * traverseSession->getMultiWordCostMultiplier();
+        return ScoringParams::COST_NEW_WORD
+                * traverseSession->getMultiWordCostMultiplier(dicNode->getDictionaryIndex());
     }
 
     float getNewWordBigramCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode,
             MultiBigramMap *const multiBigramMap) const {
-        return DicNodeUtils::getBigramNodeImprobability(traverseSession->getOffsetDict(),
-                dicNode, multiBigramMap) * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
+        const int dictionaryIndex = dicNode->getDictionaryIndex();
+        return DicNodeUtils::getBigramNodeImprobability(
+                traverseSession->getOffsetDict(dictionaryIndex),
+                traverseSession->supportsDynamicUpdate(dictionaryIndex), dicNode, multiBigramMap)
+                * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
     }
 
     float getCompletionCost(const DicTraverseSession *const traverseSession,
@@ -167,6 +172,36 @@ class TypingWeighting : public Weighting {
         return languageImprobability * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
     }
 
+    // Bounds the language cost of getTerminalLanguageCost() and getNewWordBigramCost() with the
+    // highest probability of the words below the node: the unigram one, or one boosted by a
+    // bigram of the previous word.
+    float getLanguageLookAheadCost(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode) const {
+        const SubtreeProbabilityIndex *const subtreeProbabilityIndex =
+                traverseSession->getSubtreeProbabilityIndex(dicNode->getDictionaryIndex());
+        // Exact matches get no language cost at their terminal.
+        if (!subtreeProbabilityIndex || dicNode->isExactMatch()) {
+            return 0.0f;
+        }
+        const int subtreeProbability = subtreeProbabilityIndex->getMaxProbability(
+                dicNode->getPos());
+        if (subtreeProbability == NOT_A_PROBABILITY) {
+            // Roots are not char groups.
+            return 0.0f;
+        }
+        const int probability =
+                max(subtreeProbability, dicNode->getPrevWordMaxBigramProbability());
+        return static_cast<float>(MAX_PROBABILITY - probability)
+                / static_cast<float>(MAX_PROBABILITY) * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
+    }
+
+    // The terminal spatial cost only grows with the correction counts, and the language cost is
+    // already bounded by the look-ahead one.
+    float getRemainingCostLowerBound(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode) const {
+        return getTerminalSpatialCost(traverseSession, dicNode);
+    }
+
     AK_FORCE_INLINE bool needsToNormalizeCompoundDistance() const {
         return false;
     }
@@ -182,7 +217,7 @@ class TypingWeighting : public Weighting {
     AK_FORCE_INLINE float getSpaceSubstitutionCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const {
         const float cost = ScoringParams::SPACE_SUBSTITUTION_COST + ScoringParams::COST_NEW_WORD;
-        return cost * traverseSession->getMultiWordCostMultiplier();
+        return cost * traverseSession->getMultiWordCostMultiplier(dicNode->getDictionaryIndex());
     }
 
     ErrorType getErrorType(const CorrectionType correctionType,
@@ -32,9 +32,13 @@
 namespace latinime {
 
 // TODO: check the header
-UnigramDictionary::UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags)
+UnigramDictionary::UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags,
+        const CharGroupLookupIndex *const lookupIndex, const bool supportsDynamicUpdate,
+        const int headerSize)
         : DICT_ROOT(streamStart), ROOT_POS(0),
-          MAX_DIGRAPH_SEARCH_DEPTH(DEFAULT_MAX_DIGRAPH_SEARCH_DEPTH), DICT_FLAGS(dictFlags) {
+          MAX_DIGRAPH_SEARCH_DEPTH(DEFAULT_MAX_DIGRAPH_SEARCH_DEPTH), DICT_FLAGS(dictFlags),
+          LOOKUP_INDEX(lookupIndex), SUPPORTS_DYNAMIC_UPDATE(supportsDynamicUpdate),
+          HEADER_SIZE(headerSize) {
     if (DEBUG_DICT) {
         AKLOGI("UnigramDictionary - constructor");
     }
@@ -807,11 +811,12 @@ int UnigramDictionary::getMostProbableWordLikeInner(const int *const inWord, con
 int UnigramDictionary::getProbability(const int *const inWord, const int length) const {
     const uint8_t *const root = DICT_ROOT;
     int pos = BinaryFormat::getTerminalPosition(root, inWord, length,
-            false /* forceLowerCaseSearch */);
+            false /* forceLowerCaseSearch */, LOOKUP_INDEX, SUPPORTS_DYNAMIC_UPDATE, HEADER_SIZE);
     if (NOT_VALID_WORD == pos) {
         return NOT_A_PROBABILITY;
     }
     const uint8_t flags = BinaryFormat::getFlagsAndForwardPointer(root, &pos);
+    pos = BinaryFormat::skipParentPosition(SUPPORTS_DYNAMIC_UPDATE, pos);
     if (flags & (BinaryFormat::FLAG_IS_BLACKLISTED | BinaryFormat::FLAG_IS_NOT_A_WORD)) {
         // If this is not a word, or if it's a blacklisted entry, it should behave as
         // having no probability outside of the suggestion process (where it should be used
@@ -24,6 +24,7 @@
 
 namespace latinime {
 
+class CharGroupLookupIndex;
 class Correction;
 class ProximityInfo;
 class TerminalAttributes;
@@ -38,7 +39,9 @@ class UnigramDictionary {
     static const int FLAG_MULTIPLE_SUGGEST_ABORT = 0;
     static const int FLAG_MULTIPLE_SUGGEST_SKIP = 1;
     static const int FLAG_MULTIPLE_SUGGEST_CONTINUE = 2;
-    UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags);
+    UnigramDictionary(const uint8_t *const streamStart, const unsigned int dictFlags,
+            const CharGroupLookupIndex *const lookupIndex, const bool supportsDynamicUpdate,
+            const int headerSize);
     int getProbability(const int *const inWord, const int length) const;
     int getBigramPosition(int pos, int *word, int offset, int length) const;
     int getSuggestions(ProximityInfo *proximityInfo, const int *xcoordinates,
@@ -111,6 +114,9 @@ class UnigramDictionary {
     const int ROOT_POS;
     const int MAX_DIGRAPH_SEARCH_DEPTH;
     const int DICT_FLAGS;
+    const CharGroupLookupIndex *const LOOKUP_INDEX;
+    const bool SUPPORTS_DYNAMIC_UPDATE;
+    const int HEADER_SIZE;
 };
 } // namespace latinime
 #endif // LATINIME_UNIGRAM_DICTIONARY_H